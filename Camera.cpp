@@ -230,6 +230,32 @@ void Camera::transform() {
    glMultMatrixf( m.get() );
 }
 
+void Camera::getFrustum( Plane planes[6] ) const {
+
+   Vector3 direction = ( _target - _position ).normalized();
+   Vector3 right = direction ^ _up;
+   planes[0] = Plane( direction, _position + direction * _near_plane );
+   planes[1] = Plane( -direction, _position + direction * _far_plane );
+
+   // The sides pass through the point of view
+   // and the edges of the viewport on the near plane.
+   Vector3 toNearPlane = direction * _near_plane;
+   Vector3 halfWidth = right * ( 0.5f * _viewport_width );
+   Vector3 halfHeight = _up * ( 0.5f * _viewport_height );
+   Vector3 normals[4] = {
+      _up ^ ( toNearPlane + -halfWidth ),       // left
+      ( toNearPlane + halfWidth ) ^ _up,       // right
+      ( toNearPlane + -halfHeight ) ^ right,    // bottom
+      right ^ ( toNearPlane + halfHeight )     // top
+   };
+   for ( int i = 0; i < 4; ++i ) {
+      // pointing inward, i.e. towards the line of sight
+      if ( normals[i] * direction < 0 )
+         normals[i] = -normals[i];
+      planes[2+i] = Plane( normals[i], _position );
+   }
+}
+
 void Camera::pushViewportAndTransform(
    int window_width_in_pixels, int window_height_in_pixels,
    int viewport_x1, int viewport_y1,
@@ -202,6 +202,11 @@ public:
       return direction ^ _up;
    }
 
+   // Returns the planes bounding what is seen (near, far, left, right,
+   // bottom, top), in world space, with their normals pointing inward,
+   // as set up by transform() (with an identity modelview matrix).
+   void getFrustum( Plane planes[6] ) const;
+
    int getViewportWidthInPixels() const { return _window_width_in_pixels; }
    int getViewportHeightInPixels() const { return _window_height_in_pixels; }
 
@@ -0,0 +1,701 @@
+/*
+   This file is part of a program called sphereEversion.
+
+   Command-line companion to the interactive program,
+   for generating and processing the surface without a window.
+*/
+
+#include "generateGeometry.h"
+#include "surfaceMesh.h"
+#include "doubleCurve.h"
+#include "surfaceMetrics.h"
+#include "verifyGeometry.h"
+#include "tuneGeometry.h"
+#include "packedGeometry.h"
+#include "gridIndices.h"
+#include "parallel.h"
+#include "global.h"
+
+#include <cstring>
+#include <chrono>
+
+
+const int defaultNumStrips = 8;
+const int defaultNumberOfLatitudinalPatchesPerHemisphere = 12;
+const int defaultNumberOfLongitudinalPatchesPerStrip = 12;
+const int defaultTileSize = 256;
+const double defaultStageStarts[5] = { 0.00, 0.10, 0.23, 0.60, 0.93 };
+const double defaultPoleCap = 0.01;
+const int defaultMaxDepth = 24;
+const unsigned defaultSeed = 1;
+const double defaultTolerance = 1e-5;
+
+
+// Finds the bounding box of the vertices of the tiles.
+class GridBounds : public GeometryTileSink {
+   bool _empty;
+public:
+   float min[3], max[3];
+
+   GridBounds() : _empty( true ) { }
+   VertexLayout vertexLayout() const { return LAYOUT_SPLIT; }
+   void consumeTile( const GeometryTile & tile ) {
+      for ( int j = 0; j < tile.rowCount; ++j )
+         for ( int k = 0; k < tile.columnCount; ++k ) {
+            const float * p = &tile.positions[j][3*k];
+            for ( int i = 0; i < 3; ++i ) {
+               if ( _empty || p[i] < min[i] ) min[i] = p[i];
+               if ( _empty || p[i] > max[i] ) max[i] = p[i];
+            }
+            _empty = false;
+         }
+   }
+};
+
+// Writes tiles into a file holding the entire grid of samples.
+// The file starts with a header (8 byte magic string, then the number
+// of rows and columns as 32-bit integers), followed by the samples
+// of the grid in row-major order: interleaved, as GLPoints
+// (magic string SEGRID1), split, as all the positions
+// and then all the normals, 3 floats each (magic string SEGRID2),
+// or packed, as the PackingBox and then PackedPoints (magic string SEGRID3;
+// see packedGeometry.h), if a box to quantize against is given.
+// Each row of a tile is seek'ed to and written separately,
+// so only one tile is ever held in memory.
+class GridFileWriter : public GeometryTileSink {
+   FILE * _file;
+   int _rows, _columns;
+   VertexLayout _layout;
+   const PackingBox * _box;
+   bool _failed;
+   std::vector< PackedPoint > _packedRow;
+
+   static const int HeaderSize = 16;
+
+   void write( long long offset, const void * data, size_t size ) {
+      if ( _failed )
+         return;
+#ifdef _WIN32
+      if ( _fseeki64( _file, offset, SEEK_SET ) != 0 )
+#else
+      if ( fseeko( _file, offset, SEEK_SET ) != 0 )
+#endif
+         _failed = true;
+      else if ( fwrite( data, size, 1, _file ) != 1 )
+         _failed = true;
+   }
+public:
+   GridFileWriter(
+      FILE * file, int rows, int columns, VertexLayout layout,
+      const PackingBox * box = 0
+   )
+      : _file( file ), _rows( rows ), _columns( columns ),
+        _layout(
+           layout == LAYOUT_SPLIT && box == 0 ? LAYOUT_SPLIT : LAYOUT_INTERLEAVED
+        ),
+        _box( box ), _failed( false )
+   {
+      char magic[8] = { 'S','E','G','R','I','D','1','\0' };
+      if ( _box != 0 ) magic[6] = '3';
+      else if ( _layout == LAYOUT_SPLIT ) magic[6] = '2';
+      int size[2] = { rows, columns };
+      if (
+         fwrite( magic, sizeof(magic), 1, _file ) != 1
+         || fwrite( size, sizeof(size), 1, _file ) != 1
+         || ( _box != 0 && fwrite( _box, sizeof(*_box), 1, _file ) != 1 )
+      )
+         _failed = true;
+   }
+   bool hasFailed() const { return _failed; }
+   VertexLayout vertexLayout() const { return _layout; }
+
+   void consumeTile( const GeometryTile & tile ) {
+      for ( int j = 0; j < tile.rowCount && ! _failed; ++j ) {
+         long long sample
+            = (long long)( tile.firstRow + j ) * _columns + tile.firstColumn;
+         if ( _box != 0 ) {
+            _packedRow.resize( tile.columnCount );
+            for ( int k = 0; k < tile.columnCount; ++k )
+               packPoint( tile.points[j][k].vertex, tile.points[j][k].normal,
+                  *_box, &_packedRow[k] );
+            write( HeaderSize + sizeof(PackingBox) + sizeof(PackedPoint) * sample,
+               &_packedRow[0], sizeof(PackedPoint) * tile.columnCount );
+         }
+         else if ( _layout == LAYOUT_INTERLEAVED )
+            write( HeaderSize + sizeof(GLPoint) * sample,
+               tile.points[j], sizeof(GLPoint) * tile.columnCount );
+         else {
+            long long normalsStart = HeaderSize
+               + 3 * sizeof(float) * (long long)_rows * _columns;
+            write( HeaderSize + 3 * sizeof(float) * sample,
+               tile.positions[j], 3 * sizeof(float) * tile.columnCount );
+            write( normalsStart + 3 * sizeof(float) * sample,
+               tile.normals[j], 3 * sizeof(float) * tile.columnCount );
+         }
+      }
+   }
+};
+
+
+void usage( const char * programName ) {
+   fprintf( stderr,
+      "Usage: %s [options] --export-grid <file>\n"
+      "       %s [options] --export-double-curve <file>\n"
+      "       %s [options] --export-metrics <file> <steps>\n"
+      "       %s [options] --certify-immersion\n"
+      "       %s [options] --benchmark\n"
+      "       %s [--seed <n>] [--tolerance <x>] --verify <cases>\n"
+      "Options:\n"
+      "  --time <t>             time in [0,1] (default 0)\n"
+      "  --strips <n>           total number of strips (default %d)\n"
+      "  --stages <corrugate> <push> <twist> <unpush> <uncorrugate>\n"
+      "                         times at which the stages of the eversion start\n"
+      "                         (default %.2f %.2f %.2f %.2f %.2f)\n"
+      "  --resolution <u> <v>   latitudinal and longitudinal patches per strip\n"
+      "                         (default %d %d)\n"
+      "  --tile <rows> <cols>   patches per tile (default %d %d)\n"
+      "  --layout <layout>      of the exported grid: interleaved (vertex and\n"
+      "                         normal of each sample, the default), split\n"
+      "                         (all vertices, then all normals), or packed\n"
+      "                         (8 bytes per sample, quantized)\n"
+      "  --half-strips          generate half-strips\n"
+      "  --arc-length           space samples equally in arc length\n"
+      "  --trig-recurrence <n>  columns per call to the math library for the\n"
+      "                         sines and cosines of v (default 16; 1 = all)\n"
+      "  --kernel <name>        build of the sampling loops to use (generic, avx2,\n"
+      "                         avx512; default: the best supported by the CPU)\n"
+      "  --export-double-curve <file>\n"
+      "                         write the self-intersection curve of the whole\n"
+      "                         sphere as polylines, in Wavefront OBJ format\n"
+      "  --export-metrics <file> <steps>\n"
+      "                         write the area, signed volume and bending energy\n"
+      "                         of the whole sphere at times 0, 1/steps, ..., 1\n"
+      "                         as CSV, one line per time as it is computed\n"
+      "  --certify-immersion    prove that the normal never vanishes, at any time,\n"
+      "                         except within the caps around the poles\n"
+      "  --pole-cap <u>         size of those caps (default %g)\n"
+      "  --max-depth <n>        bisections of a box before giving up (default %d)\n"
+      "  --benchmark            time the generation of one strip in each stage\n"
+      "                         (and count the operations on jets per sample,\n"
+      "                         if built with -DCOUNT_JET_OPERATIONS), in the\n"
+      "                         fastest configuration for this machine, found by\n"
+      "                         timing candidates once and caching the result\n"
+      "  --retune               time the candidates again, ignoring the cache\n"
+      "  --no-tuning            benchmark with 1 thread and a single tile\n"
+      "  --threads <n>          number of threads (default: one per core)\n"
+      "  --verify <cases>       compare the samples of the fast ways of generating\n"
+      "                         the surface with those of the original code,\n"
+      "                         over random cases, and print the errors\n"
+      "  --seed <n>             seed of the random cases (default %u)\n"
+      "  --tolerance <x>        largest error allowed (default %g)\n",
+      programName, programName, programName, programName, programName,
+      programName,
+      defaultNumStrips,
+      defaultStageStarts[0], defaultStageStarts[1], defaultStageStarts[2],
+      defaultStageStarts[3], defaultStageStarts[4],
+      defaultNumberOfLatitudinalPatchesPerHemisphere,
+      defaultNumberOfLongitudinalPatchesPerStrip,
+      defaultTileSize, defaultTileSize,
+      defaultPoleCap, defaultMaxDepth,
+      defaultSeed, defaultTolerance
+   );
+   exit( 1 );
+}
+
+// Writes the grid of samples of one strip, tile by tile.
+void exportGrid(
+   const char * gridFileName, VertexLayout layout, bool packed,
+   int tileRows, int tileColumns,
+   double time, int numStrips, const double * stageStarts,
+   int u_count, int v_count,
+   bool showHalfStrips, bool useArcLengthSpacing
+) {
+   FILE * file = fopen( gridFileName, "wb" );
+   if ( file == 0 ) {
+      fprintf( stderr, "Could not open %s for writing\n", gridFileName );
+      exit( 1 );
+   }
+
+   // Packed vertices are quantized against the box of the whole grid,
+   // so it is generated twice: once to find the box, then to write it.
+   GridBounds bounds;
+   PackingBox box;
+   if ( packed ) {
+      generateGeometryTiled(
+         &bounds, tileRows, tileColumns,
+         time, numStrips,
+         0.0, u_count, 1.0,
+         0.0, v_count, showHalfStrips ? 0.5 : 1.0,
+         useArcLengthSpacing ? SPACING_ARC_LENGTH : SPACING_UNIFORM,
+         -1.0,
+         stageStarts[0], stageStarts[1], stageStarts[2],
+         stageStarts[3], stageStarts[4]
+      );
+      box = packingBox( bounds.min, bounds.max );
+   }
+
+   GridFileWriter writer(
+      file, 1 + u_count, 1 + v_count, layout, packed ? &box : 0
+   );
+   generateGeometryTiled(
+      &writer, tileRows, tileColumns,
+      time, numStrips,
+      0.0, u_count, 1.0,
+      0.0, v_count, showHalfStrips ? 0.5 : 1.0,
+      useArcLengthSpacing ? SPACING_ARC_LENGTH : SPACING_UNIFORM,
+      -1.0,
+      stageStarts[0], stageStarts[1], stageStarts[2],
+      stageStarts[3], stageStarts[4]
+   );
+   bool failed = writer.hasFailed();
+   if ( fclose( file ) != 0 ) failed = true;
+   if ( failed ) {
+      fprintf( stderr, "Error while writing %s\n", gridFileName );
+      exit( 1 );
+   }
+}
+
+// Writes the double curve of the whole sphere, computed from one strip
+// (a whole one, even if only half strips are shown elsewhere).
+void exportDoubleCurve(
+   const char * curveFileName,
+   double time, int numStrips, const double * stageStarts,
+   int u_count, int v_count,
+   bool useArcLengthSpacing
+) {
+   int j;
+   GLPoint ** grid = new GLPointPointer[1 + u_count];
+   for (j = u_count; j >= 0; --j)
+      grid[j] = new GLPoint[1 + v_count];
+   generateGeometry(
+      grid,
+      time, numStrips,
+      0.0, u_count, 1.0,
+      0.0, v_count, 1.0,
+      useArcLengthSpacing ? SPACING_ARC_LENGTH : SPACING_UNIFORM,
+      -1.0,
+      stageStarts[0], stageStarts[1], stageStarts[2],
+      stageStarts[3], stageStarts[4]
+   );
+
+   SurfaceMesh mesh;
+   buildSurfaceMesh( grid, u_count, v_count, numStrips, &mesh );
+   for (j = u_count; j >= 0; --j)
+      delete [] grid[j];
+   delete [] grid;
+
+   std::vector< Polyline > polylines;
+   findDoubleCurve( mesh, polylines );
+   if ( ! writePolylinesAsOBJ( curveFileName, polylines ) ) {
+      fprintf( stderr, "Error while writing %s\n", curveFileName );
+      exit( 1 );
+   }
+}
+
+// Writes the metrics of the whole sphere over the whole eversion,
+// generating the surface at each time tile by tile.
+void exportMetrics(
+   const char * metricsFileName, int steps,
+   int tileRows, int tileColumns, int threads,
+   int numStrips, const double * stageStarts,
+   int u_count, int v_count,
+   bool useArcLengthSpacing
+) {
+   FILE * file = fopen( metricsFileName, "w" );
+   if ( file == 0 ) {
+      fprintf( stderr, "Could not open %s for writing\n", metricsFileName );
+      exit( 1 );
+   }
+   fprintf( file, "time,area,volume,bending_energy\n" );
+   for ( int i = 0; i <= steps; ++i ) {
+      double time = (double)i / steps;
+      SurfaceMetrics metrics;
+      computeSurfaceMetrics(
+         &metrics, tileRows, tileColumns, threads,
+         time, numStrips, u_count, v_count,
+         useArcLengthSpacing ? SPACING_ARC_LENGTH : SPACING_UNIFORM,
+         -1.0,
+         stageStarts[0], stageStarts[1], stageStarts[2],
+         stageStarts[3], stageStarts[4]
+      );
+      fprintf( file, "%.17g,%.17g,%.17g,%.17g\n",
+         time, metrics.area, metrics.volume, metrics.bendingEnergy );
+      // So that the file can be plotted while the sweep is running.
+      fflush( file );
+   }
+   bool failed = ferror( file ) != 0;
+   if ( fclose( file ) != 0 ) failed = true;
+   if ( failed ) {
+      fprintf( stderr, "Error while writing %s\n", metricsFileName );
+      exit( 1 );
+   }
+}
+
+// Prints the average cache miss ratio of drawing the given triangles
+// as they are and reordered by optimizeVertexCache(), which is timed.
+static void printCacheMissRatios(
+   const char * name, std::vector< unsigned int > & triangles,
+   unsigned int vertexCount
+) {
+   double before16 = averageCacheMissRatio( triangles, 16 );
+   double before32 = averageCacheMissRatio( triangles, 32 );
+   std::chrono::steady_clock::time_point start
+      = std::chrono::steady_clock::now();
+   optimizeVertexCache( triangles, vertexCount );
+   double milliseconds = std::chrono::duration< double, std::milli >(
+      std::chrono::steady_clock::now() - start
+   ).count();
+   printf( "%-14s %10ld %8.3f %8.3f %10.3f %8.3f %10.1f\n",
+      name, (long)triangles.size() / 3, before16, before32,
+      averageCacheMissRatio( triangles, 16 ),
+      averageCacheMissRatio( triangles, 32 ), milliseconds );
+}
+
+// Times the generation of the grid of samples of one strip in the middle
+// of each stage, and prints the operations on jets done per sample
+// if they are counted, then the average cache miss ratios of drawing
+// the strip and the whole (welded) sphere, before and after reordering
+// their triangles for the vertex cache.
+// Unless tuning is false, the grid is sampled in the fastest way,
+// found by tuneGeometry() (ignoring its cache if retuning),
+// with only the given kernel, unless it is 0.
+void benchmark(
+   int numStrips, const double * stageStarts,
+   int u_count, int v_count,
+   bool showHalfStrips, bool useArcLengthSpacing,
+   bool tuning, bool retuning, const char * kernel
+) {
+   static const char * const stageNames[NumEversionStages] = {
+      "bend in", "corrugate", "push through", "twist", "unpush", "uncorrugate"
+   };
+   static const char * const operationNames[NumJetOperations] = {
+      "add", "mul", "sin", "cos", "pow", "fmod"
+   };
+   const double minimumSeconds = 0.25;
+
+   int j;
+   GLPoint ** grid = new GLPointPointer[1 + u_count];
+   for (j = u_count; j >= 0; --j)
+      grid[j] = new GLPoint[1 + v_count];
+   long samples = (long)( 1 + u_count ) * ( 1 + v_count );
+
+   if ( tuning ) {
+      GeometryConfiguration configuration;
+      tuneGeometry( &configuration, u_count, v_count, numStrips,
+         ! retuning, kernel, stdout );
+   }
+   int threads, tileRows, tileColumns;
+   getSamplingThreads( &threads, &tileRows, &tileColumns );
+   printf( "%d strips, grid of %d x %d samples\n",
+      numStrips, 1 + u_count, 1 + v_count );
+   printf( "Configuration: %s kernel, %d threads, tiles of %d x %d samples"
+      " (0 = all)%s\n", getGeometryKernel(), threads, tileRows, tileColumns,
+      tuning ? ", tuned" : "" );
+   printf( "%-14s %12s %12s\n", "stage", "us/grid", "ns/sample" );
+   double stageTimes[NumEversionStages];
+   for ( int s = 0; s < NumEversionStages; ++s ) {
+      double time = 0, bendtime = 0.5;
+      if ( s != STAGE_BEND_IN ) {
+         double end = s+1 < NumEversionStages ? stageStarts[s] : 1.0;
+         time = 0.5 * ( stageStarts[s-1] + end );
+         bendtime = -1.0;
+      }
+      stageTimes[s] = time;
+
+      int repetitions = 0;
+      double seconds = 0;
+      std::chrono::steady_clock::time_point start
+         = std::chrono::steady_clock::now();
+      do {
+         generateGeometry(
+            grid,
+            time, numStrips,
+            0.0, u_count, 1.0,
+            0.0, v_count, showHalfStrips ? 0.5 : 1.0,
+            useArcLengthSpacing ? SPACING_ARC_LENGTH : SPACING_UNIFORM,
+            bendtime,
+            stageStarts[0], stageStarts[1], stageStarts[2],
+            stageStarts[3], stageStarts[4]
+         );
+         ++ repetitions;
+         seconds = std::chrono::duration< double >(
+            std::chrono::steady_clock::now() - start
+         ).count();
+      } while ( seconds < minimumSeconds );
+      printf( "%-14s %12.1f %12.1f\n", stageNames[s],
+         1e6 * seconds / repetitions, 1e9 * seconds / repetitions / samples );
+   }
+
+   // Counted over one more grid per stage, then over one sample
+   // per stage evaluated on its own, with nothing shared between samples.
+   JetOperationCounts gridCounts, pointCounts;
+   resetJetOperationCounts();
+   for ( int s = 0; s < NumEversionStages; ++s )
+      generateGeometry(
+         grid,
+         stageTimes[s], numStrips,
+         0.0, u_count, 1.0,
+         0.0, v_count, showHalfStrips ? 0.5 : 1.0,
+         useArcLengthSpacing ? SPACING_ARC_LENGTH : SPACING_UNIFORM,
+         s == STAGE_BEND_IN ? 0.5 : -1.0,
+         stageStarts[0], stageStarts[1], stageStarts[2],
+         stageStarts[3], stageStarts[4]
+      );
+   getJetOperationCounts( &gridCounts );
+   resetJetOperationCounts();
+   for ( int s = 0; s < NumEversionStages; ++s ) {
+      GLJetPoint jet;
+      evaluateSurface(
+         &jet, 0.5, 0.25,
+         stageTimes[s], numStrips,
+         s == STAGE_BEND_IN ? 0.5 : -1.0,
+         stageStarts[0], stageStarts[1], stageStarts[2],
+         stageStarts[3], stageStarts[4]
+      );
+   }
+   if ( getJetOperationCounts( &pointCounts ) ) {
+      printf( "Operations on jets per sample, in the grid and alone "
+         "(timings above are slowed down by counting them):\n" );
+      printf( "%-14s %-7s", "stage", "jet" );
+      for ( int i = 0; i < NumJetOperations; ++i )
+         printf( " %14s", operationNames[i] );
+      printf( "\n" );
+      for ( int s = 0; s < NumEversionStages; ++s )
+         for ( int o = 0; o < NumJetOrders; ++o ) {
+            printf( "%-14s %-7s", o == 0 ? stageNames[s] : "",
+               o == TWO_JET ? "2-jet" : "3-jet" );
+            for ( int i = 0; i < NumJetOperations; ++i )
+               printf( " %8.2f %5ld",
+                  (double)gridCounts.count[s][o][i] / samples,
+                  pointCounts.count[s][o][i] );
+            printf( "\n" );
+         }
+   }
+   else
+      printf( "Build with -DCOUNT_JET_OPERATIONS "
+         "to count the operations on jets per sample\n" );
+
+   printf( "Vertices transformed per triangle (ACMR), with a FIFO cache"
+      " of 16 and 32 vertices:\n" );
+   printf( "%-14s %10s %17s %19s\n", "", "", "as built", "reordered" );
+   printf( "%-14s %10s %8s %8s %10s %8s %10s\n", "mesh", "triangles",
+      "16", "32", "16", "32", "ms" );
+   std::vector< unsigned int > triangles;
+   appendGridTriangles( triangles, u_count, v_count, 1 + v_count );
+   printCacheMissRatios( "one strip", triangles, (unsigned int)samples );
+   // The sphere is welded from whole strips, even if only half strips
+   // were timed above.
+   if ( showHalfStrips )
+      generateGeometry(
+         grid,
+         stageTimes[ NumEversionStages-1 ], numStrips,
+         0.0, u_count, 1.0,
+         0.0, v_count, 1.0,
+         useArcLengthSpacing ? SPACING_ARC_LENGTH : SPACING_UNIFORM,
+         -1.0,
+         stageStarts[0], stageStarts[1], stageStarts[2],
+         stageStarts[3], stageStarts[4]
+      );
+   SurfaceMesh mesh;
+   buildSurfaceMesh( grid, u_count, v_count, numStrips, &mesh );
+   triangles.assign( mesh.triangles.begin(), mesh.triangles.end() );
+   printCacheMissRatios( "whole sphere", triangles,
+      (unsigned int)mesh.numberOfVertices() );
+
+   for (j = u_count; j >= 0; --j)
+      delete [] grid[j];
+   delete [] grid;
+}
+
+// Proves that the surface is immersed at all times, and prints the proof.
+// Returns false if that could not be proven.
+bool certify(
+   int numStrips, const double * stageStarts,
+   double poleCap, int maxDepth, int threads
+) {
+   std::chrono::steady_clock::time_point start
+      = std::chrono::steady_clock::now();
+   ImmersionCertificate certificate;
+   certifyImmersion(
+      &certificate, 0.0, 1.0, numStrips,
+      poleCap, 1.0, 0.0, 1.0,
+      maxDepth, threads,
+      stageStarts[0], stageStarts[1], stageStarts[2],
+      stageStarts[3], stageStarts[4]
+   );
+   double seconds = std::chrono::duration< double >(
+      std::chrono::steady_clock::now() - start
+   ).count();
+
+   printf( "%d strips, stages starting at %g %g %g %g %g, u in [%g,1]\n",
+      numStrips, stageStarts[0], stageStarts[1], stageStarts[2],
+      stageStarts[3], stageStarts[4], poleCap );
+   if ( certificate.isCertified )
+      printf( "Immersion certified: |n| >= %g everywhere\n",
+         certificate.normalLengthLowerBound );
+   else
+      printf( "Immersion NOT certified: |n| could not be proven non-zero\n"
+         "over %ld boxes within u in [%g,%g], v in [%g,%g], time in [%g,%g]\n",
+         certificate.uncertifiedBoxCount,
+         certificate.uncertifiedMin[0], certificate.uncertifiedMax[0],
+         certificate.uncertifiedMin[1], certificate.uncertifiedMax[1],
+         certificate.uncertifiedMin[2], certificate.uncertifiedMax[2] );
+   printf( "Smallest |n| sampled: %g at u = %g, v = %g, time = %g\n",
+      certificate.minimumNormalLength,
+      certificate.minimumU, certificate.minimumV, certificate.minimumTime );
+   printf( "%ld boxes evaluated in %.1f s on %d threads\n",
+      certificate.boxCount, seconds,
+      threads > 0 ? threads : numberOfThreads() );
+   return certificate.isCertified;
+}
+
+int main( int argc, char *argv[] ) {
+
+   double time = 0;
+   int numStrips = defaultNumStrips;
+   int u_count = defaultNumberOfLatitudinalPatchesPerHemisphere;
+   int v_count = defaultNumberOfLongitudinalPatchesPerStrip;
+   int tileRows = defaultTileSize, tileColumns = defaultTileSize;
+   bool showHalfStrips = false;
+   bool useArcLengthSpacing = false;
+   const char * gridFileName = 0;
+   VertexLayout gridLayout = LAYOUT_INTERLEAVED;
+   bool packingGrid = false;
+   const char * curveFileName = 0;
+   const char * metricsFileName = 0;
+   int metricsSteps = 0;
+   bool certifyingImmersion = false;
+   bool benchmarking = false;
+   bool tuning = true, retuning = false;
+   const char * kernel = 0;
+   double stageStarts[5];
+   for ( int i = 0; i < 5; ++i )
+      stageStarts[i] = defaultStageStarts[i];
+   double poleCap = defaultPoleCap;
+   int maxDepth = defaultMaxDepth;
+   int threads = 0;
+   int verifyingCases = 0;
+   unsigned seed = defaultSeed;
+   double tolerance = defaultTolerance;
+
+   for ( int i = 1; i < argc; ++i ) {
+      if ( strcmp( argv[i], "--time" ) == 0 && i+1 < argc )
+         time = atof( argv[++i] );
+      else if ( strcmp( argv[i], "--strips" ) == 0 && i+1 < argc )
+         numStrips = atoi( argv[++i] );
+      else if ( strcmp( argv[i], "--stages" ) == 0 && i+5 < argc ) {
+         for ( int j = 0; j < 5; ++j )
+            stageStarts[j] = atof( argv[++i] );
+      }
+      else if ( strcmp( argv[i], "--resolution" ) == 0 && i+2 < argc ) {
+         u_count = atoi( argv[++i] );
+         v_count = atoi( argv[++i] );
+      }
+      else if ( strcmp( argv[i], "--tile" ) == 0 && i+2 < argc ) {
+         tileRows = atoi( argv[++i] );
+         tileColumns = atoi( argv[++i] );
+      }
+      else if ( strcmp( argv[i], "--layout" ) == 0 && i+1 < argc ) {
+         ++ i;
+         if ( strcmp( argv[i], "interleaved" ) == 0 )
+            gridLayout = LAYOUT_INTERLEAVED;
+         else if ( strcmp( argv[i], "split" ) == 0 )
+            gridLayout = LAYOUT_SPLIT;
+         else if ( strcmp( argv[i], "packed" ) == 0 )
+            packingGrid = true;
+         else
+            usage( argv[0] );
+      }
+      else if ( strcmp( argv[i], "--half-strips" ) == 0 )
+         showHalfStrips = true;
+      else if ( strcmp( argv[i], "--arc-length" ) == 0 )
+         useArcLengthSpacing = true;
+      else if ( strcmp( argv[i], "--trig-recurrence" ) == 0 && i+1 < argc )
+         setTrigonometricRecurrenceInterval( atoi( argv[++i] ) );
+      else if ( strcmp( argv[i], "--kernel" ) == 0 && i+1 < argc ) {
+         kernel = argv[++i];
+         if ( ! setGeometryKernel( kernel ) ) {
+            fprintf( stderr, "Kernel %s is unknown or not supported\n", kernel );
+            exit( 1 );
+         }
+      }
+      else if ( strcmp( argv[i], "--export-grid" ) == 0 && i+1 < argc )
+         gridFileName = argv[++i];
+      else if ( strcmp( argv[i], "--export-double-curve" ) == 0 && i+1 < argc )
+         curveFileName = argv[++i];
+      else if ( strcmp( argv[i], "--export-metrics" ) == 0 && i+2 < argc ) {
+         metricsFileName = argv[++i];
+         metricsSteps = atoi( argv[++i] );
+      }
+      else if ( strcmp( argv[i], "--certify-immersion" ) == 0 )
+         certifyingImmersion = true;
+      else if ( strcmp( argv[i], "--benchmark" ) == 0 )
+         benchmarking = true;
+      else if ( strcmp( argv[i], "--retune" ) == 0 )
+         retuning = true;
+      else if ( strcmp( argv[i], "--no-tuning" ) == 0 )
+         tuning = false;
+      else if ( strcmp( argv[i], "--pole-cap" ) == 0 && i+1 < argc )
+         poleCap = atof( argv[++i] );
+      else if ( strcmp( argv[i], "--max-depth" ) == 0 && i+1 < argc )
+         maxDepth = atoi( argv[++i] );
+      else if ( strcmp( argv[i], "--threads" ) == 0 && i+1 < argc )
+         threads = atoi( argv[++i] );
+      else if ( strcmp( argv[i], "--verify" ) == 0 && i+1 < argc )
+         verifyingCases = atoi( argv[++i] );
+      else if ( strcmp( argv[i], "--seed" ) == 0 && i+1 < argc )
+         seed = (unsigned)strtoul( argv[++i], 0, 10 );
+      else if ( strcmp( argv[i], "--tolerance" ) == 0 && i+1 < argc )
+         tolerance = atof( argv[++i] );
+      else
+         usage( argv[0] );
+   }
+   if (
+      (
+         gridFileName == 0 && curveFileName == 0 && metricsFileName == 0
+         && ! certifyingImmersion && ! benchmarking && verifyingCases < 1
+      )
+      || numStrips < 1 || u_count < 1 || v_count < 1
+      || ( metricsFileName != 0 && metricsSteps < 1 )
+   )
+      usage( argv[0] );
+   if ( time < 0.0 ) time = 0.0;
+   else if ( time > 1.0 ) time = 1.0;
+
+   if ( gridFileName != 0 )
+      exportGrid(
+         gridFileName, gridLayout, packingGrid, tileRows, tileColumns,
+         time, numStrips, stageStarts, u_count, v_count,
+         showHalfStrips, useArcLengthSpacing
+      );
+   if ( curveFileName != 0 )
+      exportDoubleCurve(
+         curveFileName,
+         time, numStrips, stageStarts, u_count, v_count,
+         useArcLengthSpacing
+      );
+   if ( metricsFileName != 0 )
+      exportMetrics(
+         metricsFileName, metricsSteps,
+         tileRows, tileColumns, threads,
+         numStrips, stageStarts, u_count, v_count,
+         useArcLengthSpacing
+      );
+   if ( benchmarking )
+      benchmark(
+         numStrips, stageStarts, u_count, v_count,
+         showHalfStrips, useArcLengthSpacing,
+         tuning, retuning, kernel
+      );
+   if (
+      certifyingImmersion
+      && ! certify( numStrips, stageStarts, poleCap, maxDepth, threads )
+   )
+      return 2;
+   if (
+      verifyingCases > 0
+      && ! verifyGeometry( verifyingCases, seed, tolerance, stdout )
+   )
+      return 2;
+   return 0;
+}
@@ -0,0 +1,223 @@
+
+#include "crossSection.h"
+#include "parallel.h"
+#include <math.h>
+#include <algorithm>
+
+
+// An edge of the mesh crossed by the plane, and how to refine the crossing:
+// the edge runs from corner0 to corner1 of the given triangle.
+struct EdgeCrossing {
+   CurvePointKey key;
+   int triangle, corner0, corner1;
+   float point[3];
+
+   bool operator<( const EdgeCrossing & c ) const { return key < c.key; }
+};
+
+// Returns the corner (0, 1 or 2) of the triangle at the given vertex.
+static int cornerOf( const SurfaceMesh & mesh, int triangle, int vertex ) {
+   const int * t = &mesh.triangles[3*triangle];
+   return t[0] == vertex ? 0 : t[1] == vertex ? 1 : 2;
+}
+
+// Finds the point where the plane n.x + d = 0 crosses the edge between
+// samples p and q of the strip, in the strip's own coordinates,
+// and stores it in point[] in the coordinates of the mesh.
+// Without Newton steps, this is where the plane crosses the mesh.
+static void refineCrossing(
+   const double n[3], double d,
+   const GLJetPoint & p, const GLJetPoint & q,
+   const float rotation[9],
+   int newtonSteps,
+   double time, int numStrips, double bendtime,
+   double corrStart, double pushStart, double twistStart,
+   double unpushStart, double uncorrStart,
+   float point[3]
+) {
+   double fp = n[0]*p.vertex[0] + n[1]*p.vertex[1] + n[2]*p.vertex[2] + d;
+   double fq = n[0]*q.vertex[0] + n[1]*q.vertex[1] + n[2]*q.vertex[2] + d;
+   float x[3];
+
+   if ( ( fp >= 0 ) == ( fq >= 0 ) ) {
+      // p or q lies on the plane, and rounding put both on the same side,
+      // so the endpoint closer to the plane is as good as it gets.
+      const float * v = fabs( fp ) <= fabs( fq ) ? p.vertex : q.vertex;
+      for ( int i = 0; i < 3; ++i )
+         x[i] = v[i];
+      newtonSteps = 0;
+   }
+   else {
+      double s = fp / ( fp - fq );
+      for ( int i = 0; i < 3; ++i )
+         x[i] = (float)( p.vertex[i] + s*( q.vertex[i] - p.vertex[i] ) );
+   }
+
+   if ( newtonSteps > 0 ) {
+      double du = q.u - p.u, dv = q.v - p.v;
+      double dfp = 0, dfq = 0;
+      for ( int i = 0; i < 3; ++i ) {
+         dfp += n[i] * ( p.du[i]*du + p.dv[i]*dv );
+         dfq += n[i] * ( q.du[i]*du + q.dv[i]*dv );
+      }
+
+      // The first guess is where the cubic Hermite interpolant of
+      // the distance along the edge, from its values and derivatives
+      // at p and q, crosses zero. This costs no evaluations of the surface,
+      // and is much closer than linear interpolation where the edge is curved.
+      // Here and below, the crossing is kept bracketed between the last
+      // points found on either side, and a Newton step leaving the bracket
+      // is replaced by bisection.
+      double low = 0, high = 1;   // p's side, q's side
+      double s = fp / ( fp - fq );
+      for ( int step = 0; step < 8; ++step ) {
+         double h[4], dh[4];
+         hermiteBasis( s, h, dh );
+         double f = h[0]*fp + h[1]*fq + h[2]*dfp + h[3]*dfq;
+         double df = dh[0]*fp + dh[1]*fq + dh[2]*dfp + dh[3]*dfq;
+         if ( ( f >= 0 ) == ( fp >= 0 ) ) low = s; else high = s;
+         double next = df != 0 ? s - f/df : low;
+         s = next >= low && next <= high ? next : ( low + high ) / 2;
+      }
+
+      // Then Newton's method on the surface itself,
+      // with one more evaluation at the result of the last step.
+      low = 0;
+      high = 1;
+      for ( int step = 0; step <= newtonSteps; ++step ) {
+         GLJetPoint jet;
+         if ( ! evaluateSurface( &jet, p.u + s*du, p.v + s*dv, time, numStrips,
+               bendtime, corrStart, pushStart, twistStart, unpushStart, uncorrStart ) )
+            break;
+         for ( int i = 0; i < 3; ++i )
+            x[i] = jet.vertex[i];
+         if ( step == newtonSteps )
+            break;
+
+         double f = n[0]*x[0] + n[1]*x[1] + n[2]*x[2] + d;
+         if ( f == 0 )
+            break;
+         if ( ( f >= 0 ) == ( fp >= 0 ) ) low = s; else high = s;
+         double df = 0;
+         for ( int i = 0; i < 3; ++i )
+            df += n[i] * ( jet.du[i]*du + jet.dv[i]*dv );
+         double next = df != 0 ? s - f/df : low;
+         s = next >= low && next <= high ? next : ( low + high ) / 2;
+      }
+   }
+
+   for ( int i = 0; i < 3; ++i )
+      point[i] = rotation[3*i]*x[0] + rotation[3*i+1]*x[1] + rotation[3*i+2]*x[2];
+}
+
+void findCrossSection(
+   const Plane & plane,
+   const SurfaceMesh & mesh,
+   GLJetPoint ** jets, int columns,
+   std::vector< Polyline > & polylines,
+   int newtonSteps,
+   int threads,
+
+   double time,
+   int numStrips,
+
+   double bendtime,
+
+   double corrStart,
+   double pushStart,
+   double twistStart,
+   double unpushStart,
+   double uncorrStart
+) {
+   polylines.clear();
+   int numVertices = mesh.numberOfVertices();
+   int numTriangles = mesh.numberOfTriangles();
+
+   // Which side of the plane each vertex is on (zero counts as positive).
+   const Vector3 & normal = plane.getNormal();
+   std::vector< bool > isAbove( numVertices );
+   for ( int v = 0; v < numVertices; ++v ) {
+      const float * p = mesh.vertex( v );
+      isAbove[v] = plane.distance( Point3( p[0], p[1], p[2] ) ) >= 0;
+   }
+
+   // Each triangle with vertices on both sides of the plane
+   // has two edges crossing it, which give a segment of the curve.
+   std::vector< EdgeCrossing > crossings;
+   std::vector< CurveSegment > segments;
+   for ( int t = 0; t < numTriangles; ++t ) {
+      const int * v = &mesh.triangles[3*t];
+      if ( isAbove[v[0]] == isAbove[v[1]] && isAbove[v[1]] == isAbove[v[2]] )
+         continue;
+      CurveSegment segment;
+      int count = 0;
+      for ( int i = 0; i < 3 && count < 2; ++i ) {
+         int p = v[i], q = v[(i+1)%3];
+         if ( isAbove[p] == isAbove[q] )
+            continue;
+         if ( p > q ) { int tmp = p; p = q; q = tmp; }
+         EdgeCrossing crossing;
+         crossing.key.vertex0 = p;
+         crossing.key.vertex1 = q;
+         crossing.key.triangle = -1;
+         crossing.triangle = t;
+         crossing.corner0 = cornerOf( mesh, t, p );
+         crossing.corner1 = cornerOf( mesh, t, q );
+         crossings.push_back( crossing );
+         segment.key[count++] = crossing.key;
+      }
+      segments.push_back( segment );
+   }
+
+   // Each crossing is shared by the triangles on either side of its edge,
+   // but only needs to be refined once.
+   std::sort( crossings.begin(), crossings.end() );
+   crossings.erase(
+      std::unique( crossings.begin(), crossings.end(),
+         []( const EdgeCrossing & a, const EdgeCrossing & b ) {
+            return a.key == b.key;
+         } ),
+      crossings.end()
+   );
+
+   double d = plane.distance( Point3( 0, 0, 0 ) );
+   parallelFor( (int)crossings.size(), [&]( int c, int ) {
+      EdgeCrossing & crossing = crossings[c];
+      int t = crossing.triangle;
+      float rotation[9];
+      stripInstanceRotation(
+         mesh.triangleHemisphere[t], mesh.triangleStrip[t], numStrips, rotation
+      );
+
+      // The plane in the coordinates of the strip, i.e. rotated
+      // by the inverse (transpose) of the strip's rotation.
+      double n[3];
+      for ( int i = 0; i < 3; ++i )
+         n[i] = rotation[i]*normal.x() + rotation[3+i]*normal.y()
+            + rotation[6+i]*normal.z();
+
+      int p = mesh.triangleSamples[3*t + crossing.corner0];
+      int q = mesh.triangleSamples[3*t + crossing.corner1];
+      refineCrossing( n, d,
+         jets[p/(columns+1)][p%(columns+1)], jets[q/(columns+1)][q%(columns+1)],
+         rotation, newtonSteps,
+         time, numStrips, bendtime,
+         corrStart, pushStart, twistStart, unpushStart, uncorrStart,
+         crossing.point );
+   }, threads, 16 );
+
+   for ( int s = 0; s < (int)segments.size(); ++s ) {
+      CurveSegment & segment = segments[s];
+      for ( int e = 0; e < 2; ++e ) {
+         EdgeCrossing key;
+         key.key = segment.key[e];
+         const EdgeCrossing & crossing
+            = *std::lower_bound( crossings.begin(), crossings.end(), key );
+         for ( int i = 0; i < 3; ++i )
+            segment.point[e][i] = crossing.point[i];
+      }
+   }
+   std::sort( segments.begin(), segments.end() );
+
+   chainCurveSegments( segments, polylines );
+}
@@ -0,0 +1,45 @@
+
+#ifndef CROSSSECTION_H
+#define CROSSSECTION_H
+
+
+#include "surfaceMesh.h"
+#include "mathutil.h"
+
+
+// Finds the curve where the surface crosses the plane (the cross-section
+// of the surface by the plane), as a set of polylines.
+// jets is the (1+rows) by (1+columns) grid of samples of one strip
+// computed by generateJetGeometry(), and mesh is built from it
+// by buildSurfaceMesh(); the plane is in the coordinates of the mesh.
+// The crossings of the edges of the mesh are found by linear interpolation,
+// then refined by newtonSteps steps of Newton's method along each edge
+// in (u,v), using the partial derivatives of the surface,
+// so that the points of the polylines lie on the surface itself
+// rather than on the mesh.
+// The time and the remaining arguments must be those given
+// to generateJetGeometry().
+// Crossings are refined in parallel by the given number of threads
+// (0 means one per core).
+void findCrossSection(
+   const Plane & plane,
+   const SurfaceMesh & mesh,
+   GLJetPoint ** jets, int columns,
+   std::vector< Polyline > & polylines,
+   int newtonSteps = 3,
+   int threads = 0,
+
+   double time = 0.0,
+   int numStrips = 8,
+
+   double bendtime = -1.0,
+
+   double corrStart   = 0.00,
+   double pushStart   = 0.10,
+   double twistStart  = 0.23,
+   double unpushStart = 0.60,
+   double uncorrStart = 0.93
+);
+
+
+#endif /* CROSSSECTION_H */
@@ -0,0 +1,232 @@
+
+#include "doubleCurve.h"
+#include "parallel.h"
+#include <math.h>
+#include <algorithm>
+
+
+// Returns the determinant of [b-a, c-a, d-a],
+// which is positive if d is above the plane through a, b, c
+// (seen from above, a, b, c are counterclockwise).
+static double orientation(
+   const float * a, const float * b, const float * c, const float * d
+) {
+   double bx = b[0]-a[0], by = b[1]-a[1], bz = b[2]-a[2];
+   double cx = c[0]-a[0], cy = c[1]-a[1], cz = c[2]-a[2];
+   double dx = d[0]-a[0], dy = d[1]-a[1], dz = d[2]-a[2];
+   return bx*(cy*dz - cz*dy) + by*(cz*dx - cx*dz) + bz*(cx*dy - cy*dx);
+}
+
+// Returns +1 or -1, according to which side of the line through
+// the edge (u,w) the line through the edge (p,q) passes.
+// Computed with the vertices of each edge in increasing order,
+// so that the answer is the same (up to sign) for every triangle
+// sharing the edge (u,w). Zero counts as negative.
+static int edgeSide( const SurfaceMesh & mesh, int p, int q, int u, int w ) {
+   int sign = 1;
+   if ( u > w ) { int tmp = u; u = w; w = tmp; sign = -sign; }
+   double o = orientation(
+      mesh.vertex( p ), mesh.vertex( q ), mesh.vertex( u ), mesh.vertex( w )
+   );
+   return o > 0 ? sign : -sign;
+}
+
+// Tests each edge of the first triangle against the second triangle,
+// appending the points where they cross to point[] and key[].
+static void findCrossings(
+   const SurfaceMesh & mesh, int edgeTriangle, int triangle,
+   float point[][3], CurvePointKey key[], int & count
+) {
+   const int * e = &mesh.triangles[3*edgeTriangle];
+   const int * t = &mesh.triangles[3*triangle];
+   const float * a = mesh.vertex( t[0] );
+   const float * b = mesh.vertex( t[1] );
+   const float * c = mesh.vertex( t[2] );
+
+   for ( int i = 0; i < 3; ++i ) {
+      int p = e[i], q = e[(i+1)%3];
+      if ( p > q ) { int tmp = p; p = q; q = tmp; }
+      double dp = orientation( a, b, c, mesh.vertex( p ) );
+      double dq = orientation( a, b, c, mesh.vertex( q ) );
+      if ( ( dp > 0 ) == ( dq > 0 ) )
+         continue;
+      int side = edgeSide( mesh, p, q, t[0], t[1] );
+      if (
+         edgeSide( mesh, p, q, t[1], t[2] ) != side
+         || edgeSide( mesh, p, q, t[2], t[0] ) != side
+      )
+         continue;
+
+      if ( count < 6 ) {
+         const float * vp = mesh.vertex( p );
+         const float * vq = mesh.vertex( q );
+         double s = dp / ( dp - dq );
+         for ( int j = 0; j < 3; ++j )
+            point[count][j] = (float)( vp[j] + s*( vq[j] - vp[j] ) );
+         key[count].vertex0 = p;
+         key[count].vertex1 = q;
+         key[count].triangle = triangle;
+      }
+      ++ count;
+   }
+}
+
+// Returns true if the triangles have a vertex in common.
+static bool shareVertex( const SurfaceMesh & mesh, int t0, int t1 ) {
+   const int * a = &mesh.triangles[3*t0];
+   const int * b = &mesh.triangles[3*t1];
+   for ( int i = 0; i < 3; ++i )
+      for ( int j = 0; j < 3; ++j )
+         if ( a[i] == b[j] )
+            return true;
+   return false;
+}
+
+void findDoubleCurve(
+   const SurfaceMesh & mesh,
+   std::vector< Polyline > & polylines,
+   int threads
+) {
+   int numTriangles = mesh.numberOfTriangles();
+   polylines.clear();
+   if ( numTriangles < 2 )
+      return;
+
+   // Bounding boxes of the triangles, and of the whole mesh.
+   std::vector< float > boxes( 6*numTriangles );
+   float meshMin[3] = { HUGE_VALF, HUGE_VALF, HUGE_VALF };
+   float meshMax[3] = { -HUGE_VALF, -HUGE_VALF, -HUGE_VALF };
+   double totalSize = 0;
+   for ( int t = 0; t < numTriangles; ++t ) {
+      float * box = &boxes[6*t];
+      for ( int i = 0; i < 3; ++i ) {
+         box[i] = HUGE_VALF;
+         box[3+i] = -HUGE_VALF;
+      }
+      for ( int v = 0; v < 3; ++v ) {
+         const float * p = mesh.vertex( mesh.triangles[3*t+v] );
+         for ( int i = 0; i < 3; ++i ) {
+            if ( p[i] < box[i] ) box[i] = p[i];
+            if ( p[i] > box[3+i] ) box[3+i] = p[i];
+         }
+      }
+      for ( int i = 0; i < 3; ++i ) {
+         if ( box[i] < meshMin[i] ) meshMin[i] = box[i];
+         if ( box[3+i] > meshMax[i] ) meshMax[i] = box[3+i];
+         totalSize += box[3+i] - box[i];
+      }
+   }
+
+   // A grid of cells about as wide as a triangle.
+   const int maxCellsPerAxis = 128;
+   double cellSize = totalSize / ( 3*numTriangles );
+   int cells[3];
+   for ( int i = 0; i < 3; ++i ) {
+      double extent = meshMax[i] - meshMin[i];
+      if ( cellSize < extent / maxCellsPerAxis )
+         cellSize = extent / maxCellsPerAxis;
+   }
+   if ( cellSize <= 0 ) cellSize = 1;
+   for ( int i = 0; i < 3; ++i ) {
+      cells[i] = 1 + (int)( ( meshMax[i] - meshMin[i] ) / cellSize );
+      if ( cells[i] > maxCellsPerAxis ) cells[i] = maxCellsPerAxis;
+   }
+
+   // Returns the cell containing the given coordinate along an axis.
+   auto cellOf = [&]( float x, int i ) {
+      int c = (int)( ( x - meshMin[i] ) / cellSize );
+      return c < 0 ? 0 : c >= cells[i] ? cells[i]-1 : c;
+   };
+
+   // List the triangles overlapping each cell,
+   // as (cell,triangle) pairs sorted by cell.
+   std::vector< std::pair< int, int > > entries;
+   entries.reserve( 2*numTriangles );
+   for ( int t = 0; t < numTriangles; ++t ) {
+      const float * box = &boxes[6*t];
+      int c0[3], c1[3];
+      for ( int i = 0; i < 3; ++i ) {
+         c0[i] = cellOf( box[i], i );
+         c1[i] = cellOf( box[3+i], i );
+      }
+      for ( int x = c0[0]; x <= c1[0]; ++x )
+         for ( int y = c0[1]; y <= c1[1]; ++y )
+            for ( int z = c0[2]; z <= c1[2]; ++z )
+               entries.push_back( std::make_pair(
+                  ( x*cells[1] + y )*cells[2] + z, t
+               ) );
+   }
+   std::sort( entries.begin(), entries.end() );
+
+   // The ranges of entries of cells with more than one triangle.
+   std::vector< int > cellStart;
+   for ( int i = 0, j; i < (int)entries.size(); i = j ) {
+      for ( j = i+1; j < (int)entries.size() && entries[j].first == entries[i].first; ++j )
+         ;
+      if ( j - i > 1 )
+         cellStart.push_back( i );
+   }
+   int numCells = (int)cellStart.size();
+   cellStart.push_back( (int)entries.size() );
+
+   threads = threadsForParallelFor( numCells, threads );
+   std::vector< std::vector< CurveSegment > > found( threads );
+
+   parallelFor( numCells, [&]( int c, int thread ) {
+      int begin = cellStart[c], end = begin;
+      int cell = entries[begin].first;
+      while ( end < (int)entries.size() && entries[end].first == cell )
+         ++ end;
+
+      for ( int i = begin; i < end; ++i ) {
+         int t0 = entries[i].second;
+         const float * box0 = &boxes[6*t0];
+         for ( int j = i+1; j < end; ++j ) {
+            int t1 = entries[j].second;
+            const float * box1 = &boxes[6*t1];
+
+            // Only test pairs whose boxes overlap, and only in the cell
+            // containing the minimum corner of the overlap,
+            // so that each pair is tested once.
+            int overlapCell[3];
+            bool overlap = true;
+            for ( int k = 0; k < 3 && overlap; ++k ) {
+               if ( box0[k] > box1[3+k] || box1[k] > box0[3+k] )
+                  overlap = false;
+               else
+                  overlapCell[k] = cellOf( box0[k] > box1[k] ? box0[k] : box1[k], k );
+            }
+            if ( ! overlap ) continue;
+            if ( ( overlapCell[0]*cells[1] + overlapCell[1] )*cells[2]
+                  + overlapCell[2] != cell )
+               continue;
+            if ( shareVertex( mesh, t0, t1 ) )
+               continue;
+
+            float point[6][3];
+            CurvePointKey key[6];
+            int count = 0;
+            findCrossings( mesh, t0, t1, point, key, count );
+            findCrossings( mesh, t1, t0, point, key, count );
+            if ( count != 2 )
+               continue;   // no intersection, or a degenerate one
+
+            CurveSegment segment;
+            for ( int e = 0; e < 2; ++e ) {
+               for ( int k = 0; k < 3; ++k )
+                  segment.point[e][k] = point[e][k];
+               segment.key[e] = key[e];
+            }
+            found[thread].push_back( segment );
+         }
+      }
+   }, threads, 16 );
+
+   std::vector< CurveSegment > segments;
+   for ( int t = 0; t < threads; ++t )
+      segments.insert( segments.end(), found[t].begin(), found[t].end() );
+   // Independent of how the work was divided among threads.
+   std::sort( segments.begin(), segments.end() );
+
+   chainCurveSegments( segments, polylines );
+}
@@ -0,0 +1,23 @@
+
+#ifndef DOUBLECURVE_H
+#define DOUBLECURVE_H
+
+
+#include "surfaceMesh.h"
+
+
+// Finds the self-intersection curve (the "double curve") of the mesh,
+// i.e. where two sheets of the surface pass through each other,
+// as a set of polylines.
+// Triangles that share a vertex are not tested against each other.
+// Candidate pairs of triangles are found with a uniform grid of cells
+// (a spatial hash), whose cells are processed in parallel
+// by the given number of threads (0 means one per core).
+void findDoubleCurve(
+   const SurfaceMesh & mesh,
+   std::vector< Polyline > & polylines,
+   int threads = 0
+);
+
+
+#endif /* DOUBLECURVE_H */
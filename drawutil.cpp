@@ -1,6 +1,7 @@
 
 #include "drawutil.h"
 #include "fontdata.h"
+#include "glState.h"
 #include <GL/glut.h>
 #include <string.h>   /* for strlen() */
 
@@ -201,7 +202,7 @@ void drawShadedCircle(
          // now, weight is in [0,1].  1 corresponds to "near", 0 to "far".
          Point3 colour = farColour + (nearColour-farColour)*weight;
          glColor3fv( colour.get() );
-         glLineWidth( farThickness + (nearThickness-farThickness)*weight );
+         cachedLineWidth( farThickness + (nearThickness-farThickness)*weight );
          glBegin( GL_LINES );
             glVertex3fv( oldPoint.get() );
             glVertex3fv( newPoint.get() );
@@ -343,7 +344,7 @@ void drawShadedRay(
 
       Point3 colour = farColour + (nearColour-farColour)*v;
       glColor3fv( colour.get() );
-      glLineWidth( farThickness + (nearThickness-farThickness)*v );
+      cachedLineWidth( farThickness + (nearThickness-farThickness)*v );
 
       glBegin( GL_LINES );
          glVertex3fv( oldPoint.get() );
@@ -423,22 +424,22 @@ void drawString(
          // opaque texel as a GL_POINT, or even a small quad,
          // rather than rendering a textured quad for each character.
 
-         glBindTexture( GL_TEXTURE_2D, FontData::getTextureName() );
-         glTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP );
-         glTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP );
-         glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,
+         cachedBindTexture( GL_TEXTURE_2D, FontData::getTextureName() );
+         cachedTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP );
+         cachedTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP );
+         cachedTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,
             isBlended ? GL_LINEAR : GL_NEAREST );
-         glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,
+         cachedTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,
             isBlended ? GL_LINEAR : GL_NEAREST );
-         glTexEnvf( GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE,
+         cachedTexEnvi( GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE,
             // Each fragment's alpha will be multiplied
             // by the alpha value in the texture map.
             GL_MODULATE
          );
-         glEnable( GL_TEXTURE_2D );
-         glEnable( GL_BLEND );
-         glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
-         glShadeModel( GL_FLAT );
+         cachedEnable( GL_TEXTURE_2D );
+         cachedEnable( GL_BLEND );
+         cachedBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+         cachedShadeModel( GL_FLAT );
 
          if ( fontHeightType == DU_FONT_ASCENT ) {
             float true_height = height
@@ -471,8 +472,8 @@ void drawString(
                glVertex2f(j*width,height);
             }
          glEnd();
-         glDisable( GL_BLEND );
-         glDisable( GL_TEXTURE_2D );
+         cachedDisable( GL_BLEND );
+         cachedDisable( GL_TEXTURE_2D );
       }
       else {
          float ascent; // in world space units
@@ -496,12 +497,12 @@ void drawString(
          if ( isBlended ) {
             // This will draw the text with anti-aliased strokes,
             // making it easier to read small text.
-            glEnable( GL_LINE_SMOOTH );
-            glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
-            glEnable( GL_BLEND );
+            cachedEnable( GL_LINE_SMOOTH );
+            cachedBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+            cachedEnable( GL_BLEND );
          }
          if ( thickness != 1 )
-            glLineWidth( thickness );
+            cachedLineWidth( thickness );
 
          float s = ascent / G_FONT_ASCENT; // scale factor
          glScalef( s, s, 1 );
@@ -509,10 +510,10 @@ void drawString(
             glutStrokeCharacter( GLUT_STROKE_MONO_ROMAN, buffer[j] );
 
          if ( thickness != 1 )
-            glLineWidth( 1 );
+            cachedLineWidth( 1 );
          if ( isBlended ) {
-            glDisable( GL_LINE_SMOOTH );
-            glDisable( GL_BLEND );
+            cachedDisable( GL_LINE_SMOOTH );
+            cachedDisable( GL_BLEND );
          }
       }
    glPopMatrix();
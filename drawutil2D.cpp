@@ -1,6 +1,7 @@
 
 #include "drawutil2D.h"
 #include "fontdata.h"
+#include "glState.h"
 #ifdef _WIN32
 #include "global.h"  /* for M_PI */
 #endif
@@ -450,22 +451,22 @@ void OpenGL2DInterface::drawString(
       // opaque texel as a GL_POINT, or even a small quad,
       // rather than rendering a textured quad for each character.
 
-      glBindTexture( GL_TEXTURE_2D, FontData::getTextureName() );
-      glTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP );
-      glTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP );
-      glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,
+      cachedBindTexture( GL_TEXTURE_2D, FontData::getTextureName() );
+      cachedTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP );
+      cachedTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP );
+      cachedTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,
          isBlended ? GL_LINEAR : GL_NEAREST );
-      glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,
+      cachedTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,
          isBlended ? GL_LINEAR : GL_NEAREST );
-      glTexEnvf( GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE,
+      cachedTexEnvi( GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE,
          // Each fragment's alpha will be multiplied
          // by the alpha value in the texture map.
          GL_MODULATE
       );
-      glEnable( GL_TEXTURE_2D );
-      glEnable( GL_BLEND );
-      glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
-      glShadeModel( GL_FLAT );
+      cachedEnable( GL_TEXTURE_2D );
+      cachedEnable( GL_BLEND );
+      cachedBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+      cachedShadeModel( GL_FLAT );
 
       float y_ = y; // just to convert y to floating-point type
       if ( fontHeightType == FONT_ASCENT ) {
@@ -506,8 +507,8 @@ void OpenGL2DInterface::drawString(
             glVertex2f(x+j*width,y_+height);
          }
       glEnd();
-      glDisable( GL_BLEND );
-      glDisable( GL_TEXTURE_2D );
+      cachedDisable( GL_BLEND );
+      cachedDisable( GL_TEXTURE_2D );
    }
    else {
       float ascent; // in pixels
@@ -534,12 +535,12 @@ void OpenGL2DInterface::drawString(
          if ( isBlended ) {
             // This will draw the text with anti-aliased strokes,
             // making it easier to read small text.
-            glEnable( GL_LINE_SMOOTH );
-            glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
-            glEnable( GL_BLEND );
+            cachedEnable( GL_LINE_SMOOTH );
+            cachedBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+            cachedEnable( GL_BLEND );
          }
          if ( thickness != 1 )
-            glLineWidth( thickness );
+            cachedLineWidth( thickness );
 
          // We scale the text to make its height that desired by the caller.
          float s = ascent / G_FONT_ASCENT; // scale factor
@@ -548,10 +549,10 @@ void OpenGL2DInterface::drawString(
             glutStrokeCharacter( GLUT_STROKE_MONO_ROMAN, buffer[j] );
 
          if ( thickness != 1 )
-            glLineWidth( 1 );
+            cachedLineWidth( 1 );
          if ( isBlended ) {
-            glDisable( GL_LINE_SMOOTH );
-            glDisable( GL_BLEND );
+            cachedDisable( GL_LINE_SMOOTH );
+            cachedDisable( GL_BLEND );
          }
       glPopMatrix();
    }
@@ -0,0 +1,945 @@
+/*
+    This file is part of "sphereEversion",
+    a program by Michael McGuffin.
+    The code in this file was almost entirely taken
+    (with slight adaptations) from the source code of
+    "evert", a program written by Nathaniel Thurston.
+    evert's source code can be down loaded from
+        http://www.geom.umn.edu/docs/outreach/oi/software.html
+        http://www.geom.uiuc.edu/docs/outreach/oi/software.html
+
+    Grateful acknowledgements go out to Nathaniel Thurston,
+    Silvio Levy, and the Geometry Center (University of Minnesota)
+    for making evert's source code freely available to the public.
+*/
+
+/*
+    Jets, and the functions defining the surface in terms of them.
+
+    There is deliberately no include guard: this file is included
+    once per type of scalar, each time inside a different namespace
+    that defines Real to be the scalar type, e.g.
+
+       namespace exact {
+          typedef double Real;
+          #include "evertSurface.h"
+       }
+
+    Besides the usual arithmetic operators, Real must support
+    sin(), cos(), pow() and fmod() (which must return a value in [0,d)
+    for a positive modulus d), comparisons with doubles,
+    and PowerDerivatives(f, n, x0, x1, x2, x3), which sets
+    xi to the i-th derivative of f^n.
+
+    Every arithmetic operation on a jet, Sin, Cos, ^ and %= invokes
+    JET_OPERATION(order, operation), where order is TWO_JET or THREE_JET
+    and operation is a JetOperation (see generateGeometry.h).
+    It does nothing unless the includer defines it, e.g. to count them;
+    it is undefined again at the end of this file.
+    Operations on vectors of jets are counted as the operations
+    on jets they are made of.
+*/
+
+#ifndef JET_OPERATION
+#define JET_OPERATION(order, operation)
+#endif
+
+// ----------------------------------------
+
+class TwoJet D(const class ThreeJet x, int index);
+class TwoJet {
+  public: /* this is a hack, but needed for now */
+  Real f;
+  Real fu, fv;
+  Real fuv;
+
+  TwoJet() {}
+  TwoJet(Real d, Real du, Real dv)
+   { f = d; fu = du; fv = dv; fuv = 0; }
+  TwoJet(Real d, Real du, Real dv, Real duv)
+   { f = d; fu = du; fv = dv; fuv = duv; }
+#if 0
+  operator double() { return f; }
+#endif
+  bool operator<(double d) { return f < d; }
+  bool operator>(double d) { return f > d; }
+  bool operator<=(double d) { return f <= d; }
+  bool operator>=(double d) { return f >= d; }
+  Real df_du() { return fu; }
+  Real df_dv() { return fv; }
+  Real d2f_dudv() { return fuv; }
+  void operator +=(TwoJet x)
+   { JET_OPERATION(TWO_JET, JET_ADD);
+     f += x.f; fu += x.fu; fv += x.fv; fuv += x.fuv; }
+  void operator +=(double d)
+   { JET_OPERATION(TWO_JET, JET_ADD); f += d; }
+  void operator *=(TwoJet x)
+   {
+     JET_OPERATION(TWO_JET, JET_MULTIPLY);
+     fuv = f*x.fuv + fu*x.fv + fv*x.fu + fuv*x.f;
+     fu = f*x.fu + fu*x.f;
+     fv = f*x.fv + fv*x.f;
+     f *= x.f;
+   }
+  void operator *=(double d)
+   { JET_OPERATION(TWO_JET, JET_MULTIPLY);
+     f *= d; fu *= d; fv *= d; fuv *= d; }
+  void operator %=(double d)
+   { JET_OPERATION(TWO_JET, JET_FMOD);
+     f = fmod(f, d); if (f < 0) f += d; }
+  void operator ^=(double n)
+   {
+    JET_OPERATION(TWO_JET, JET_POWER);
+    if (f > 0) {
+     Real x0 = pow(f, n);
+     Real x1 = n * x0/f;
+     Real x2 = (n-1)*x1/f;
+     fuv = x1*fuv + x2*fu*fv;
+     fu = x1*fu;
+     fv = x1*fv;
+     f = x0;
+    }
+   }
+  void Annihilate(int index)
+   { if (index == 0) fu = 0;
+     else if (index == 1) fv = 0;
+     fuv = 0;
+   }
+  void TakeSin() {
+   JET_OPERATION(TWO_JET, JET_SIN);
+   *this *= 2*M_PI;
+   Real s = sin(f), c = cos(f);
+   f = s; fu = fu*c; fv = fv*c; fuv = c*fuv - s*fu*fv;
+  }
+  void TakeCos() {
+   JET_OPERATION(TWO_JET, JET_COS);
+   *this *= 2*M_PI;
+   Real s = cos(f), c = -sin(f);
+   f = s; fu = fu*c; fv = fv*c; fuv = c*fuv - s*fu*fv;
+  }
+
+  friend TwoJet operator+(const TwoJet x, const TwoJet y);
+  friend TwoJet operator*(const TwoJet x, const TwoJet y);
+  friend TwoJet operator+(const TwoJet x, double d);
+  friend TwoJet operator*(const TwoJet x, double d);
+  friend TwoJet Sin(const TwoJet x);
+  friend TwoJet Cos(const TwoJet x);
+  friend TwoJet SinGiven(const TwoJet x, Real s, Real c);
+  friend TwoJet CosGiven(const TwoJet x, Real s, Real c);
+  friend TwoJet operator^(const TwoJet x, double n);
+  friend TwoJet Annihilate(const TwoJet x, int index);
+  friend TwoJet Interpolate(const TwoJet v1, const TwoJet v2, const TwoJet weight);
+  friend class TwoJet D(const class ThreeJet x, int index);
+  friend class ThreeJet;
+};
+
+// ----------------------------------------
+
+TwoJet operator+(const TwoJet x, const TwoJet y) {
+  JET_OPERATION(TWO_JET, JET_ADD);
+  return TwoJet(x.f+y.f, x.fu+y.fu, x.fv+y.fv, x.fuv + y.fuv);
+}
+
+TwoJet operator*(const TwoJet x, const TwoJet y) {
+  JET_OPERATION(TWO_JET, JET_MULTIPLY);
+  return TwoJet(
+    x.f*y.f,
+    x.f*y.fu + x.fu*y.f,
+    x.f*y.fv + x.fv*y.f,
+    x.f*y.fuv + x.fu*y.fv + x.fv*y.fu + x.fuv*y.f
+  );
+}
+
+TwoJet operator+(const TwoJet x, double d) {
+  JET_OPERATION(TWO_JET, JET_ADD);
+  return TwoJet( x.f + d, x.fu, x.fv, x.fuv);
+}
+
+TwoJet operator*(const TwoJet x, double d) {
+  JET_OPERATION(TWO_JET, JET_MULTIPLY);
+  return TwoJet( d*x.f, d*x.fu, d*x.fv, d*x.fuv);
+}
+
+TwoJet Sin(const TwoJet x) {
+  JET_OPERATION(TWO_JET, JET_SIN);
+  TwoJet t = x*(2*M_PI);
+  Real s = sin(t.f);
+  Real c = cos(t.f);
+  return TwoJet(s, c*t.fu, c*t.fv, c*t.fuv - s*t.fu*t.fv);
+}
+
+TwoJet Cos(const TwoJet x) {
+  JET_OPERATION(TWO_JET, JET_COS);
+  TwoJet t = x*(2*M_PI);
+  Real s = cos(t.f);
+  Real c = -sin(t.f);
+  return TwoJet(s, c*t.fu, c*t.fv, c*t.fuv - s*t.fu*t.fv);
+}
+
+// Same as Sin(x) and Cos(x), given s = sin(2*pi*x.f) and c = cos(2*pi*x.f),
+// e.g. from a recurrence rather than from the math library.
+// They still count as a Sin and a Cos.
+TwoJet SinGiven(const TwoJet x, Real s, Real c) {
+  JET_OPERATION(TWO_JET, JET_SIN);
+  TwoJet t = x*(2*M_PI);
+  return TwoJet(s, c*t.fu, c*t.fv, c*t.fuv - s*t.fu*t.fv);
+}
+
+TwoJet CosGiven(const TwoJet x, Real s, Real c) {
+  JET_OPERATION(TWO_JET, JET_COS);
+  TwoJet t = x*(2*M_PI);
+  return TwoJet(c, -s*t.fu, -s*t.fv, -s*t.fuv - c*t.fu*t.fv);
+}
+
+TwoJet operator^(const TwoJet x, double n) {
+  JET_OPERATION(TWO_JET, JET_POWER);
+  Real x0, x1, x2, x3;
+  PowerDerivatives(x.f, n, x0, x1, x2, x3);
+  return TwoJet(x0, x1*x.fu, x1*x.fv, x1*x.fuv + x2*x.fu*x.fv);
+}
+
+TwoJet Annihilate(const TwoJet x, int index) {
+  return TwoJet(x.f, index == 1 ? x.fu : 0, index == 0 ? x.fv : 0, 0);
+}
+
+TwoJet Interpolate(const TwoJet v1, const TwoJet v2, const TwoJet weight) {
+  return (v1) * ((weight) * (-1) + 1) + v2*weight;
+}
+
+
+// ----------------------------------------
+
+class ThreeJet {
+public: // hack
+  Real f;
+private:
+  Real fu, fv;
+  Real fuu, fuv, fvv;
+  Real fuuv, fuvv;
+
+  ThreeJet(Real d, Real du, Real dv, Real duu, Real duv, Real dvv,
+   Real duuv, Real duvv)
+   { f = d; fu = du; fv = dv; fuu = duu; fuv = duv; fvv = dvv;
+     fuuv = duuv; fuvv = duvv; }
+  public:
+  ThreeJet() {}
+  ThreeJet(Real d, Real du, Real dv)
+   { f = d; fu = du; fv = dv; fuu = fuv = fvv = fuuv = fuvv = 0;}
+  operator TwoJet() { return TwoJet(f, fu, fv, fuv); }
+#if 0
+  operator double() { return f; }
+#endif
+  bool operator<(double d) { return f < d; }
+  bool operator>(double d) { return f > d; }
+  bool operator<=(double d) { return f <= d; }
+  bool operator>=(double d) { return f >= d; }
+  void operator %=(double d)
+   { JET_OPERATION(THREE_JET, JET_FMOD);
+     f = fmod(f, d); if (f < 0) f += d; }
+  friend ThreeJet operator+(const ThreeJet x, const ThreeJet y);
+  friend ThreeJet operator*(const ThreeJet x, const ThreeJet y);
+  friend ThreeJet operator+(const ThreeJet x, double d);
+  friend ThreeJet operator*(const ThreeJet x, double d);
+  friend ThreeJet Sin(const ThreeJet x);
+  friend ThreeJet Cos(const ThreeJet x);
+  friend ThreeJet operator^(const ThreeJet x, double n);
+  friend ThreeJet Annihilate(const ThreeJet x, int index);
+  friend ThreeJet Interpolate(const ThreeJet v1, const ThreeJet v2, const ThreeJet weight);
+  friend class TwoJet D(const class ThreeJet x, int index);
+};
+
+// ----------------------------------------
+
+ThreeJet operator+(const ThreeJet x, const ThreeJet y) {
+  JET_OPERATION(THREE_JET, JET_ADD);
+  ThreeJet result;
+  result.f = x.f + y.f;
+  result.fu = x.fu + y.fu;
+  result.fv = x.fv + y.fv;
+  result.fuu = x.fuu + y.fuu;
+  result.fuv = x.fuv + y.fuv;
+  result.fvv = x.fvv + y.fvv;
+  result.fuuv = x.fuuv + y.fuuv;
+  result.fuvv = x.fuvv + y.fuvv;
+  return result;
+}
+
+ThreeJet operator*(const ThreeJet x, const ThreeJet y) {
+  JET_OPERATION(THREE_JET, JET_MULTIPLY);
+  ThreeJet result;
+  result.f = x.f*y.f;
+  result.fu = x.f*y.fu + x.fu*y.f;
+  result.fv = x.f*y.fv + x.fv*y.f;
+  result.fuu = x.f*y.fuu + 2*x.fu*y.fu + x.fuu*y.f;
+  result.fuv = x.f*y.fuv + x.fu*y.fv + x.fv*y.fu + x.fuv*y.f;
+  result.fvv = x.f*y.fvv + 2*x.fv*y.fv + x.fvv*y.f;
+  result.fuuv = x.f*y.fuuv + 2*x.fu*y.fuv + x.fv*y.fuu
+           + 2*x.fuv*y.fu + x.fuu*y.fv + x.fuuv*y.f;
+  result.fuvv = x.f*y.fuvv + 2*x.fv*y.fuv + x.fu*y.fvv
+           + 2*x.fuv*y.fv + x.fvv*y.fu + x.fuvv*y.f;
+  return result;
+}
+
+ThreeJet operator+(const ThreeJet x, double d) {
+  JET_OPERATION(THREE_JET, JET_ADD);
+  ThreeJet result;
+  result = x;
+  result.f += d;
+  return result;
+}
+
+ThreeJet operator*(const ThreeJet x, double d) {
+  JET_OPERATION(THREE_JET, JET_MULTIPLY);
+  ThreeJet result;
+  result.f = d*x.f;
+  result.fu = d*x.fu;
+  result.fv = d*x.fv;
+  result.fuu = d*x.fuu;
+  result.fuv = d*x.fuv;
+  result.fvv = d*x.fvv;
+  result.fuuv = d*x.fuuv;
+  result.fuvv = d*x.fuvv;
+  return result;
+}
+
+ThreeJet Sin(const ThreeJet x) {
+  JET_OPERATION(THREE_JET, JET_SIN);
+  ThreeJet result;
+  ThreeJet t = x*(2*M_PI);
+  Real s = sin(t.f);
+  Real c = cos(t.f);
+  result.f = s;
+  result.fu = c*t.fu;
+  result.fv = c*t.fv;
+  result.fuu = c*t.fuu - s*t.fu*t.fu;
+  result.fuv = c*t.fuv - s*t.fu*t.fv;
+  result.fvv = c*t.fvv - s*t.fv*t.fv;
+  result.fuuv = c*t.fuuv - s*(2*t.fu*t.fuv + t.fv*t.fuu) - c*t.fu*t.fu*t.fv;
+  result.fuvv = c*t.fuvv - s*(2*t.fv*t.fuv + t.fu*t.fvv) - c*t.fu*t.fv*t.fv;
+  return result;
+}
+
+ThreeJet Cos(const ThreeJet x) {
+  JET_OPERATION(THREE_JET, JET_COS);
+  ThreeJet result;
+  ThreeJet t = x*(2*M_PI);
+  Real s = cos(t.f);
+  Real c = -sin(t.f);
+  result.f = s;
+  result.fu = c*t.fu;
+  result.fv = c*t.fv;
+  result.fuu = c*t.fuu - s*t.fu*t.fu;
+  result.fuv = c*t.fuv - s*t.fu*t.fv;
+  result.fvv = c*t.fvv - s*t.fv*t.fv;
+  result.fuuv = c*t.fuuv - s*(2*t.fu*t.fuv + t.fv*t.fuu) - c*t.fu*t.fu*t.fv;
+  result.fuvv = c*t.fuvv - s*(2*t.fv*t.fuv + t.fu*t.fvv) - c*t.fu*t.fv*t.fv;
+  return result;
+}
+
+ThreeJet operator^(const ThreeJet x, double n) {
+  JET_OPERATION(THREE_JET, JET_POWER);
+  Real x0, x1, x2, x3;
+  PowerDerivatives(x.f, n, x0, x1, x2, x3);
+  ThreeJet result;
+  result.f = x0;
+  result.fu = x1*x.fu;
+  result.fv = x1*x.fv;
+  result.fuu = x1*x.fuu + x2*x.fu*x.fu;
+  result.fuv = x1*x.fuv + x2*x.fu*x.fv;
+  result.fvv = x1*x.fvv + x2*x.fv*x.fv;
+  result.fuuv = x1*x.fuuv + x2*(2*x.fu*x.fuv + x.fv*x.fuu) + x3*x.fu*x.fu*x.fv;
+  result.fuvv = x1*x.fuvv + x2*(2*x.fv*x.fuv + x.fu*x.fvv) + x3*x.fu*x.fv*x.fv;
+  return result;
+}
+
+TwoJet D(const ThreeJet x, int index) {
+  TwoJet result;
+  if (index == 0) {
+    result.f = x.fu;
+    result.fu = x.fuu;
+    result.fv = x.fuv;
+    result.fuv = x.fuuv;
+  } else if (index == 1) {
+    result.f = x.fv;
+    result.fu = x.fuv;
+    result.fv = x.fvv;
+    result.fuv = x.fuvv;
+  } else {
+    result.f = result.fu = result.fv =
+    result.fuv = 0;
+  }
+  return result;
+}
+
+ThreeJet Annihilate(const ThreeJet x, int index) {
+  ThreeJet result = ThreeJet(x.f,0,0);
+  if (index == 0) {
+    result.fv = x.fv;
+    result.fvv = x.fvv;
+  } else if (index == 1) {
+    result.fu = x.fu;
+    result.fuu = x.fuu;
+  }
+  return result;
+}
+
+ThreeJet Interpolate(const ThreeJet v1, const ThreeJet v2, const ThreeJet weight) {
+  return (v1) * ((weight) * (-1) + 1) + v2*weight;
+}
+
+// ----------------------------------------
+
+struct TwoJetVec {
+  TwoJet x;
+  TwoJet y;
+  TwoJet z;
+  TwoJetVec() {}
+  TwoJetVec(TwoJet a, TwoJet b, TwoJet c) { x = a; y = b; z = c; }
+};
+
+TwoJetVec operator+(TwoJetVec v, TwoJetVec w);
+TwoJetVec operator*(TwoJetVec v, TwoJet  a);
+TwoJetVec operator*(TwoJetVec v, double a);
+TwoJetVec AnnihilateVec(TwoJetVec v, int index);
+TwoJetVec Cross(TwoJetVec v, TwoJetVec w);
+TwoJet Dot(TwoJetVec v, TwoJetVec w);
+TwoJetVec Normalize(TwoJetVec v);
+TwoJetVec RotateZ(TwoJetVec v, TwoJet angle);
+TwoJetVec RotateZ(TwoJetVec v, TwoJet s, TwoJet c);
+TwoJetVec RotateY(TwoJetVec v, TwoJet angle);
+TwoJetVec RotateX(TwoJetVec v, TwoJet angle);
+TwoJetVec InterpolateVec(TwoJetVec v1, TwoJetVec v2, TwoJet weight);
+TwoJet Length(TwoJetVec v);
+
+// ----------------------------------------
+
+TwoJetVec operator+(TwoJetVec v, TwoJetVec w) {
+  TwoJetVec result;
+  result.x = v.x + w.x;
+  result.y = v.y + w.y;
+  result.z = v.z + w.z;
+  return result;
+}
+
+TwoJetVec operator*(TwoJetVec v, TwoJet  a) {
+  TwoJetVec result;
+  result.x = v.x*a;
+  result.y = v.y*a;
+  result.z = v.z*a;
+  return result;
+}
+
+TwoJetVec operator*(TwoJetVec v, double a) {
+  TwoJetVec result;
+  result.x = v.x*a;
+  result.y = v.y*a;
+  result.z = v.z*a;
+  return result;
+}
+
+TwoJetVec AnnihilateVec(TwoJetVec v, int index) {
+  TwoJetVec result;
+  result.x = Annihilate(v.x, index);
+  result.y = Annihilate(v.y, index);
+  result.z = Annihilate(v.z, index);
+  return result;
+}
+
+TwoJetVec Cross(TwoJetVec v, TwoJetVec w) {
+  TwoJetVec result;
+  result.x = v.y*w.z + v.z*w.y*-1;
+  result.y = v.z*w.x + v.x*w.z*-1;
+  result.z = v.x*w.y + v.y*w.x*-1;
+  return result;
+}
+
+TwoJet Dot(TwoJetVec v, TwoJetVec w) {
+  return v.x*w.x + v.y*w.y + v.z*w.z;
+}
+
+TwoJetVec Normalize(TwoJetVec v) {
+  TwoJet a;
+  a = Dot(v,v);
+  if (a > 0)
+    a = a^-0.5;
+  else
+    a = TwoJet(0, 0, 0);
+  return v*a;
+}
+
+TwoJetVec RotateZ(TwoJetVec v, TwoJet angle) {
+  return RotateZ(v, Sin (angle), Cos (angle));
+}
+
+/* s and c are the Sin and Cos of the angle */
+TwoJetVec RotateZ(TwoJetVec v, TwoJet s, TwoJet c) {
+  TwoJetVec result;
+  result.x =          v.x*c + v.y*s;
+  result.y = v.x*s*-1 + v.y*c;
+  result.z = v.z;
+  return result;
+}
+
+TwoJetVec RotateY(TwoJetVec v, TwoJet angle) {
+  TwoJetVec result;
+  TwoJet s, c;
+  s = Sin (angle);
+  c = Cos (angle);
+  result.x = v.x*c + v.z*s*-1;
+  result.y = v.y;
+  result.z = v.x*s + v.z*c    ;
+  return result;
+}
+
+TwoJetVec RotateX(TwoJetVec v, TwoJet angle) {
+  TwoJetVec result;
+  TwoJet s,c;
+  s = Sin (angle);
+  c = Cos (angle);
+  result.x = v.x;
+  result.y = v.y*c + v.z*s;
+  result.z = v.y*s*-1 + v.z*c;
+  return result;
+}
+
+TwoJetVec InterpolateVec(TwoJetVec v1, TwoJetVec v2, TwoJet weight) {
+  return (v1) * (weight*-1 + 1) + v2*weight;
+}
+
+TwoJet Length(TwoJetVec v)
+{
+  return (TwoJet(v.x^2) + TwoJet(v.y^2)) ^ (.5);
+}
+
+// ----------------------------------------
+
+struct ThreeJetVec {
+  ThreeJet x;
+  ThreeJet y;
+  ThreeJet z;
+  operator TwoJetVec() { return TwoJetVec(x,y,z); }
+};
+
+ThreeJetVec operator+(ThreeJetVec v, ThreeJetVec w);
+ThreeJetVec operator*(ThreeJetVec v, ThreeJet  a);
+ThreeJetVec operator*(ThreeJetVec v, double a);
+ThreeJetVec AnnihilateVec(ThreeJetVec v, int index);
+ThreeJetVec Cross(ThreeJetVec v, ThreeJetVec w);
+ThreeJet Dot(ThreeJetVec v, ThreeJetVec w);
+TwoJetVec D(ThreeJetVec x, int index);
+ThreeJetVec Normalize(ThreeJetVec v);
+ThreeJetVec RotateZ(ThreeJetVec v, ThreeJet angle);
+ThreeJetVec RotateY(ThreeJetVec v, ThreeJet angle);
+ThreeJetVec RotateX(ThreeJetVec v, ThreeJet angle);
+ThreeJetVec InterpolateVec(ThreeJetVec v1, ThreeJetVec v2, ThreeJet weight);
+ThreeJet Length(ThreeJetVec v);
+
+// ----------------------------------------
+
+ThreeJetVec operator+(ThreeJetVec v, ThreeJetVec w) {
+  ThreeJetVec result;
+  result.x = v.x + w.x;
+  result.y = v.y + w.y;
+  result.z = v.z + w.z;
+  return result;
+}
+
+ThreeJetVec operator*(ThreeJetVec v, ThreeJet  a) {
+  ThreeJetVec result;
+  result.x = v.x*a;
+  result.y = v.y*a;
+  result.z = v.z*a;
+  return result;
+}
+
+ThreeJetVec operator*(ThreeJetVec v, double a) {
+  ThreeJetVec result;
+  result.x = v.x*a;
+  result.y = v.y*a;
+  result.z = v.z*a;
+  return result;
+}
+
+ThreeJetVec AnnihilateVec(ThreeJetVec v, int index) {
+  ThreeJetVec result;
+  result.x = Annihilate(v.x, index);
+  result.y = Annihilate(v.y, index);
+  result.z = Annihilate(v.z, index);
+  return result;
+}
+
+TwoJetVec D(ThreeJetVec x, int index) {
+  TwoJetVec result;
+  result.x = D(x.x, index);
+  result.y = D(x.y, index);
+  result.z = D(x.z, index);
+  return result;
+}
+
+ThreeJetVec Cross(ThreeJetVec v, ThreeJetVec w) {
+  ThreeJetVec result;
+  result.x = v.y*w.z + v.z*w.y*-1;
+  result.y = v.z*w.x + v.x*w.z*-1;
+  result.z = v.x*w.y + v.y*w.x*-1;
+  return result;
+}
+
+ThreeJet Dot(ThreeJetVec v, ThreeJetVec w) {
+  return v.x*w.x + v.y*w.y + v.z*w.z;
+}
+
+ThreeJetVec Normalize(ThreeJetVec v) {
+  ThreeJet a;
+  a = Dot(v,v);
+  if (a > 0)
+    a = a^-0.5;
+  else
+    a = ThreeJet(0, 0, 0);
+  return v*a;
+}
+
+ThreeJetVec RotateZ(ThreeJetVec v, ThreeJet angle) {
+  ThreeJetVec result;
+  ThreeJet s,c;
+  s = Sin (angle);
+  c = Cos (angle);
+  result.x =          v.x*c + v.y*s;
+  result.y = v.x*s*-1 + v.y*c;
+  result.z = v.z;
+  return result;
+}
+
+ThreeJetVec RotateY(ThreeJetVec v, ThreeJet angle) {
+  ThreeJetVec result;
+  ThreeJet s, c;
+  s = Sin (angle);
+  c = Cos (angle);
+  result.x = v.x*c + v.z*s*-1;
+  result.y = v.y;
+  result.z = v.x*s + v.z*c    ;
+  return result;
+}
+
+ThreeJetVec RotateX(ThreeJetVec v, ThreeJet angle) {
+  ThreeJetVec result;
+  ThreeJet s,c;
+  s = Sin (angle);
+  c = Cos (angle);
+  result.x = v.x;
+  result.y = v.y*c + v.z*s;
+  result.z = v.y*s*-1 + v.z*c;
+  return result;
+}
+
+ThreeJetVec InterpolateVec(ThreeJetVec v1, ThreeJetVec v2, ThreeJet weight) {
+  return (v1) * (weight*-1 + 1) + v2*weight;
+}
+
+ThreeJet Length(ThreeJetVec v)
+{
+  return (ThreeJet(v.x^2) + ThreeJet(v.y^2)) ^ (.5);
+}
+
+// ----------------------------------------
+
+/*
+   The figure eight added to the stage surface at a given u
+   depends on v only through a few sines and cosines of v,
+   and otherwise only on u and t. The two parts are computed
+   separately, so that either can be reused across a row
+   (or column) of samples.
+*/
+
+/* The part of the figure eight that depends on v */
+struct FigureEightTrig {
+   TwoJet v;                        /* v modulo 1 */
+   TwoJet sin2v, cos2v, cosv;       /* Sin(v*2), Cos(v*2), Cos(v) */
+   TwoJet sinRotation, cosRotation; /* Sin and Cos of v/numStrips */
+};
+
+/* The part of the figure eight that depends on u (and t) */
+struct FigureEightFrame {
+   TwoJetVec p;        /* point on the stage surface */
+   TwoJetVec w, h;     /* axes of the figure eight */
+   TwoJetVec bend;
+   TwoJet form;
+};
+
+FigureEightTrig FigureEightTrigAt(TwoJet v, int numStrips) {
+
+   FigureEightTrig trig;
+   TwoJet angle = v*(1.0/numStrips);
+   trig.sinRotation = Sin (angle);
+   trig.cosRotation = Cos (angle);
+   v %= 1;
+   trig.v = v;
+   trig.sin2v = Sin (v*2);
+   trig.cos2v = Cos (v*2);
+   trig.cosv = Cos (v);
+   return trig;
+}
+
+FigureEightFrame FigureEightFrameAt(ThreeJetVec p, ThreeJet u, ThreeJet form, ThreeJet scale) {
+
+   FigureEightFrame frame;
+   ThreeJet size = form * scale;
+   form = form*2 + form*form*-1;
+   TwoJetVec dv = AnnihilateVec(D(p, 1), 1);
+   p = AnnihilateVec(p, 1);
+   TwoJetVec du = Normalize(D(p, 0));
+   TwoJetVec normal = Normalize(Cross(du, dv));
+   frame.h = normal*TwoJet(size);
+   /* Same as Normalize(Cross(frame.h, du))*(TwoJet(size)*1.1),
+      since size is never positive (form is not negative, scale is not
+      positive), but also bounded in interval arithmetic where size is
+      close to 0 */
+   frame.w = Normalize(Cross(normal, du))*(TwoJet(size)*-1.1);
+   frame.bend = du*D(size, 0)*(D(u, 0)^(-1));
+   frame.form = form;
+   frame.p = p;
+   return frame;
+}
+
+TwoJetVec FigureEight(TwoJetVec w, TwoJetVec h, TwoJetVec bend, TwoJet form, const FigureEightTrig & trig) {
+
+   TwoJet height;
+   TwoJet v = trig.v;
+   height = (trig.cos2v + -1) * (-1);
+   if (v > 0.25 && v < 0.75)
+      height = height*-1 + 4;
+   height = height*0.6;
+   h = h + bend*(height*height*(1/64.0));
+   return w*trig.sin2v + (h) * (Interpolate((trig.cosv + -1) * (-2), height, form)) ;
+}
+
+TwoJetVec AddFigureEight(const FigureEightFrame & frame, const FigureEightTrig & trig) {
+
+   return RotateZ(
+      frame.p + FigureEight(frame.w, frame.h, frame.bend, frame.form, trig),
+      trig.sinRotation, trig.cosRotation
+   );
+}
+
+TwoJetVec AddFigureEight(ThreeJetVec p, ThreeJet u, TwoJet v, ThreeJet form, ThreeJet scale, int numStrips) {
+
+   return AddFigureEight(
+      FigureEightFrameAt(p, u, form, scale),
+      FigureEightTrigAt(v, numStrips)
+   );
+}
+
+// ----------------------------------------
+
+ThreeJetVec Arc(ThreeJet u, ThreeJet v, double xsize, double ysize, double zsize) {
+
+   ThreeJetVec result;
+   u = u*0.25;
+   result.x = Sin (u) * Sin (v) * xsize;
+   result.y = Sin (u) * Cos (v) * ysize;
+   result.z = Cos (u) * zsize;
+   return result;
+}
+
+ThreeJetVec Straight(ThreeJet u, ThreeJet v, double xsize, double ysize, double zsize) {
+
+   ThreeJetVec result;
+   u = u*0.25;
+#if 0
+   u = (u) * (-0.15915494) + 1; /* 1/2pi */
+#endif
+   result.x = Sin (v) * xsize;
+   result.y = Cos (v) * ysize;
+   result.z = Cos (u) * zsize;
+   return result;
+}
+
+ThreeJet Param1(ThreeJet x) {
+
+   double offset = 0;
+   x %= 4;
+   if (x > 2) { x = x+(-2); offset = 2; }
+   if (x <= 1) return x*2 + (x^2)*(-1) + offset;
+   else return (x^2) + x*(-2) + (2 + offset);
+}
+
+ThreeJet Param2(ThreeJet x) {
+
+   double offset = 0;
+   x %= 4;
+   if (x > 2) { x = x+(-2); offset = 2; }
+   if (x <= 1) return (x^2) + offset;
+   else return (x^2)*(-1) + x*4 + (-2 + offset);
+}
+
+static inline ThreeJet TInterp(Real x) {
+   return ThreeJet(x,0,0);
+}
+
+ThreeJet UInterp(ThreeJet x) {
+
+   x %= 2;
+   if (x > 1)
+      x = x*(-1) + 2;
+   return (x^2)*3 + (x^3) * (-2);
+}
+
+#define FFPOW 3
+ThreeJet FFInterp(ThreeJet x) {
+
+   x %= 2;
+   if (x > 1)
+      x = x*(-1) + 2;
+   x = x*1.06 + -0.05;
+   if (x < 0) return ThreeJet(0, 0, 0);
+   else if (x > 1) return ThreeJet(0, 0, 0) + 1;
+   else return (x ^ (FFPOW-1)) * (FFPOW) + (x^FFPOW) * (-FFPOW+1);
+}
+
+#define FSPOW 3
+ThreeJet FSInterp(ThreeJet x) {
+
+   x %= 2;
+   if (x > 1)
+      x = x*(-1) + 2;
+   return ((x ^ (FSPOW-1)) * (FSPOW) + (x^FSPOW) * (-FSPOW+1)) * (-0.2);
+}
+
+ThreeJetVec Stage0(ThreeJet u, ThreeJet v) {
+   return Straight(u, v, 1, 1, 1);
+}
+
+ThreeJetVec Stage1(ThreeJet u, ThreeJet v) {
+   return Arc(u, v, 1, 1, 1);
+}
+
+ThreeJetVec Stage2(ThreeJet u, ThreeJet v) {
+   return InterpolateVec(
+      Arc(Param1(u), v, 0.9, 0.9, -1),
+      Arc(Param2(u), v, 1, 1, 0.5),
+      UInterp(u)
+   );
+}
+
+ThreeJetVec Stage3(ThreeJet u, ThreeJet v) {
+
+   return InterpolateVec(
+      Arc(Param1(u), v,-0.9,-0.9,-1),
+      Arc(Param2(u), v,-1, 1,-0.5),
+      UInterp(u)
+   );
+}
+
+ThreeJetVec Stage4(ThreeJet u, ThreeJet v) {
+   return Arc(u, v, -1,-1, -1);
+}
+
+ThreeJetVec Scene01(ThreeJet u, ThreeJet v, Real t) {
+   return InterpolateVec(Stage0(u,v), Stage1(u,v), TInterp(t));
+}
+
+ThreeJetVec Scene12(ThreeJet u, ThreeJet v, Real t) {
+   return InterpolateVec(Stage1(u,v), Stage2(u,v), TInterp(t));
+}
+
+ThreeJetVec Scene23(ThreeJet u, ThreeJet v, Real t) {
+
+   ThreeJet tmp = TInterp(t);
+   t = tmp.f * 0.5;
+   Real tt = (u <= 1) ? t : -t;
+   return InterpolateVec(
+      RotateZ(Arc(Param1(u), v, 0.9, 0.9,-1), ThreeJet(tt,0,0)),
+      RotateY(Arc(Param2(u), v, 1, 1, 0.5), ThreeJet(t,0,0)),
+      UInterp(u)
+  );
+}
+
+ThreeJetVec Scene34(ThreeJet u, ThreeJet v, Real t) {
+   return InterpolateVec(Stage3(u,v), Stage4(u,v), TInterp(t));
+}
+
+/*
+   Each stage of the eversion is given by a function of (u,v,t),
+   and by a function of (u,t) giving its FigureEightFrame.
+*/
+
+FigureEightFrame BendInFrame(ThreeJet u, Real t) {
+
+   ThreeJet tmp = TInterp(t);
+   t = tmp.f;
+   return FigureEightFrameAt(
+      Scene01(u, ThreeJet(0, 0, 1), t),
+      u, ThreeJet(0, 0, 0), FSInterp(u)
+   );
+}
+
+FigureEightFrame CorrugateFrame(ThreeJet u, Real t) {
+
+   ThreeJet tmp = TInterp(t);
+   t = tmp.f;
+   return FigureEightFrameAt(
+      Stage1(u, ThreeJet(0, 0, 1)),
+      u, FFInterp(u) * ThreeJet(t,0,0), FSInterp(u)
+   );
+}
+
+FigureEightFrame PushThroughFrame(ThreeJet u, Real t) {
+
+   return FigureEightFrameAt(
+      Scene12(u,ThreeJet(0, 0, 1),t),
+      u, FFInterp(u), FSInterp(u)
+   );
+}
+
+FigureEightFrame TwistFrame(ThreeJet u, Real t) {
+
+   return FigureEightFrameAt(
+      Scene23(u,ThreeJet(0, 0, 1),t),
+      u, FFInterp(u), FSInterp(u)
+   );
+}
+
+FigureEightFrame UnPushFrame(ThreeJet u, Real t) {
+
+   return FigureEightFrameAt(
+      Scene34(u,ThreeJet(0, 0, 1),t),
+      u, FFInterp(u), FSInterp(u)
+   );
+}
+
+FigureEightFrame UnCorrugateFrame(ThreeJet u, Real t) {
+
+   ThreeJet tmp;
+   tmp = TInterp((t) * (-1) + 1);
+   t = tmp.f;
+
+   return FigureEightFrameAt(
+      Stage4(u,ThreeJet(0, 0, 1)),
+      u, FFInterp(u) * ThreeJet(t,0,0), FSInterp(u)
+   );
+}
+
+TwoJetVec BendIn(ThreeJet u, ThreeJet v, Real t, int numStrips) {
+   return AddFigureEight(BendInFrame(u, t), FigureEightTrigAt(v, numStrips));
+}
+
+TwoJetVec Corrugate(ThreeJet u, ThreeJet v, Real t, int numStrips) {
+   return AddFigureEight(CorrugateFrame(u, t), FigureEightTrigAt(v, numStrips));
+}
+
+TwoJetVec PushThrough(ThreeJet u, ThreeJet v, Real t, int numStrips) {
+   return AddFigureEight(PushThroughFrame(u, t), FigureEightTrigAt(v, numStrips));
+}
+
+TwoJetVec Twist(ThreeJet u, ThreeJet v, Real t, int numStrips) {
+   return AddFigureEight(TwistFrame(u, t), FigureEightTrigAt(v, numStrips));
+}
+
+TwoJetVec UnPush(ThreeJet u, ThreeJet v, Real t, int numStrips) {
+   return AddFigureEight(UnPushFrame(u, t), FigureEightTrigAt(v, numStrips));
+}
+
+TwoJetVec UnCorrugate(ThreeJet u, ThreeJet v, Real t, int numStrips) {
+   return AddFigureEight(UnCorrugateFrame(u, t), FigureEightTrigAt(v, numStrips));
+}
+
+#undef JET_OPERATION
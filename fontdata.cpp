@@ -2,6 +2,7 @@
 #include "fontdata.h"
 #include "fontDefinition.h"
 #include "global.h"
+#include "glState.h"
 #ifdef _WIN32
 #include <GL/glut.h>
 #else
@@ -33,7 +34,7 @@ void FontData::initializeTexture() {
    _isTextureInitialized = true;
 
    glGenTextures( 1, &_textureName );
-   glBindTexture( GL_TEXTURE_2D, _textureName );
+   cachedBindTexture( GL_TEXTURE_2D, _textureName );
    glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
    glTexImage2D(
       GL_TEXTURE_2D,     // target
@@ -54,11 +55,11 @@ void FontData::initializeTexture() {
    // But we call these to at least setup a nice default state.
    // (The below code also provides an example
    // to client programmers who have access to this source code.)
-   glTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP );
-   glTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP );
-   glTexParameteri( GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR );
-   glTexParameteri( GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR );
-   glTexEnvf( GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE,
+   cachedTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP );
+   cachedTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP );
+   cachedTexParameteri( GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR );
+   cachedTexParameteri( GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR );
+   cachedTexEnvi( GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE,
       // Each fragment's alpha will be multiplied
       // by the alpha value in the texture map.
       GL_MODULATE
@@ -1,23 +1,22 @@
 /*
     This file is part of "sphereEversion",
     a program by Michael McGuffin.
-    The code in this file was almost entirely taken
-    (with slight adaptations) from the source code of
+    The surface itself is defined in evertSurface.h,
+    which was almost entirely taken from the source code of
     "evert", a program written by Nathaniel Thurston.
-    evert's source code can be down loaded from
-        http://www.geom.umn.edu/docs/outreach/oi/software.html
-        http://www.geom.uiuc.edu/docs/outreach/oi/software.html
-
-    Grateful acknowledgements go out to Nathaniel Thurston,
-    Silvio Levy, and the Geometry Center (University of Minnesota)
-    for making evert's source code freely available to the public.
+    This file samples that surface.
 */
 
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <algorithm>
 
 #include "generateGeometry.h"
+#include "interval.h"
+#include "parallel.h"
+#include "global.h"
 
 #ifdef _WIN32
 #define M_PI 3.1415926535897932384626433832795
@@ -25,890 +24,1643 @@
 
 // ----------------------------------------
 
-class TwoJet D(const class ThreeJet x, int index);
-class TwoJet {
-  public: /* this is a hack, but needed for now */
-  double f;
-  double fu, fv;
-  double fuv;
-
-  TwoJet() {}
-  TwoJet(double d, double du, double dv)
-   { f = d; fu = du; fv = dv; fuv = 0; }
-  TwoJet(double d, double du, double dv, double duv)
-   { f = d; fu = du; fv = dv; fuv = duv; }
-#if 0
-  operator double() { return f; }
-#endif
-  bool operator<(double d) { return f < d; }
-  bool operator>(double d) { return f > d; }
-  bool operator<=(double d) { return f <= d; }
-  bool operator>=(double d) { return f >= d; }
-  double df_du() { return fu; }
-  double df_dv() { return fv; }
-  double d2f_dudv() { return fuv; }
-  void operator +=(TwoJet x)
-   { f += x.f; fu += x.fu; fv += x.fv; fuv += x.fuv; }
-  void operator +=(double d)
-   { f += d; }
-  void operator *=(TwoJet x)
-   {
-     fuv = f*x.fuv + fu*x.fv + fv*x.fu + fuv*x.f;
-     fu = f*x.fu + fu*x.f;
-     fv = f*x.fv + fv*x.f;
-     f *= x.f;
-   }
-  void operator *=(double d)
-   { f *= d; fu *= d; fv *= d; fuv *= d; }
-  void operator %=(double d)
-   { f = fmod(f, d); if (f < 0) f += d; }
-  void operator ^=(double n)
-   {
-    if (f > 0) {
-     double x0 = pow(f, n);
-     double x1 = n * x0/f;
-     double x2 = (n-1)*x1/f;
-     fuv = x1*fuv + x2*fu*fv;
-     fu = x1*fu;
-     fv = x1*fv;
-     f = x0;
-    }
-   }
-  void Annihilate(int index)
-   { if (index == 0) fu = 0;
-     else if (index == 1) fv = 0;
-     fuv = 0;
-   }
-  void TakeSin() {
-   *this *= 2*M_PI;
-   double s = sin(f), c = cos(f);
-   f = s; fu = fu*c; fv = fv*c; fuv = c*fuv - s*fu*fv;
-  }
-  void TakeCos() {
-   *this *= 2*M_PI;
-   double s = cos(f), c = -sin(f);
-   f = s; fu = fu*c; fv = fv*c; fuv = c*fuv - s*fu*fv;
-  }
-
-  friend TwoJet operator+(const TwoJet x, const TwoJet y);
-  friend TwoJet operator*(const TwoJet x, const TwoJet y);
-  friend TwoJet operator+(const TwoJet x, double d);
-  friend TwoJet operator*(const TwoJet x, double d);
-  friend TwoJet Sin(const TwoJet x);
-  friend TwoJet Cos(const TwoJet x);
-  friend TwoJet operator^(const TwoJet x, double n);
-  friend TwoJet Annihilate(const TwoJet x, int index);
-  friend TwoJet Interpolate(const TwoJet v1, const TwoJet v2, const TwoJet weight);
-  friend class TwoJet D(const class ThreeJet x, int index);
-  friend class ThreeJet;
-};
+// Sets xi to the i-th derivative of f^n.
+static inline void PowerDerivatives(
+  double f, double n, double & x0, double & x1, double & x2, double & x3
+) {
+  x0 = pow(f, n);
+  x1 = (f == 0) ? 0 : n * x0/f;
+  x2 = (f == 0) ? 0 : (n-1) * x1/f;
+  x3 = (f == 0) ? 0 : (n-2) * x2/f;
+}
 
 // ----------------------------------------
 
-TwoJet operator+(const TwoJet x, const TwoJet y) {
-  return TwoJet(x.f+y.f, x.fu+y.fu, x.fv+y.fv, x.fuv + y.fuv);
-}
+#ifdef COUNT_JET_OPERATIONS
 
-TwoJet operator*(const TwoJet x, const TwoJet y) {
-  return TwoJet(
-    x.f*y.f,
-    x.f*y.fu + x.fu*y.f,
-    x.f*y.fv + x.fv*y.f,
-    x.f*y.fuv + x.fu*y.fv + x.fv*y.fu + x.fuv*y.f
-  );
-}
+#include <atomic>
 
-TwoJet operator+(const TwoJet x, double d) {
-  return TwoJet( x.f + d, x.fu, x.fv, x.fuv);
-}
+static std::atomic<long>
+   jetOperationCounts[NumEversionStages][NumJetOrders][NumJetOperations];
+static EversionStage countedStage = STAGE_CORRUGATE;
 
-TwoJet operator*(const TwoJet x, double d) {
-  return TwoJet( d*x.f, d*x.fu, d*x.fv, d*x.fuv);
-}
+#define COUNTED_JET_OPERATION(order, operation) \
+   jetOperationCounts[countedStage][order][operation].fetch_add( \
+      1, std::memory_order_relaxed)
+#define SET_COUNTED_STAGE(stage) (countedStage = (stage))
 
-TwoJet Sin(const TwoJet x) {
-  TwoJet t = x*(2*M_PI);
-  double s = sin(t.f);
-  double c = cos(t.f);
-  return TwoJet(s, c*t.fu, c*t.fv, c*t.fuv - s*t.fu*t.fv);
+bool getJetOperationCounts(JetOperationCounts * counts) {
+   for (int s = 0; s < NumEversionStages; ++s)
+      for (int o = 0; o < NumJetOrders; ++o)
+         for (int i = 0; i < NumJetOperations; ++i)
+            counts->count[s][o][i] = jetOperationCounts[s][o][i].load();
+   return true;
 }
 
-TwoJet Cos(const TwoJet x) {
-  TwoJet t = x*(2*M_PI);
-  double s = cos(t.f);
-  double c = -sin(t.f);
-  return TwoJet(s, c*t.fu, c*t.fv, c*t.fuv - s*t.fu*t.fv);
+void resetJetOperationCounts() {
+   for (int s = 0; s < NumEversionStages; ++s)
+      for (int o = 0; o < NumJetOrders; ++o)
+         for (int i = 0; i < NumJetOperations; ++i)
+            jetOperationCounts[s][o][i] = 0;
 }
 
-TwoJet operator^(const TwoJet x, double n) {
-  double x0 = pow(x.f, n);
-  double x1 = (x.f == 0) ? 0 : n * x0/x.f;
-  double x2 = (x.f == 0) ? 0 : (n-1)*x1/x.f;
-  return TwoJet(x0, x1*x.fu, x1*x.fv, x1*x.fuv + x2*x.fu*x.fv);
-}
+#else
 
-TwoJet Annihilate(const TwoJet x, int index) {
-  return TwoJet(x.f, index == 1 ? x.fu : 0, index == 0 ? x.fv : 0, 0);
+bool getJetOperationCounts(JetOperationCounts * counts) {
+   for (int s = 0; s < NumEversionStages; ++s)
+      for (int o = 0; o < NumJetOrders; ++o)
+         for (int i = 0; i < NumJetOperations; ++i)
+            counts->count[s][o][i] = 0;
+   return false;
 }
 
-TwoJet Interpolate(const TwoJet v1, const TwoJet v2, const TwoJet weight) {
-  return (v1) * ((weight) * (-1) + 1) + v2*weight;
+void resetJetOperationCounts() {
 }
 
+#define COUNTED_JET_OPERATION(order, operation)
+#define SET_COUNTED_STAGE(stage)
 
-// ----------------------------------------
+#endif
+
+// Only the operations on exact jets are counted.
+namespace exact {
+   typedef double Real;
+   #define JET_OPERATION COUNTED_JET_OPERATION
+   #include "evertSurface.h"
+   #include "sampleSurface.h"
+}
+
+/*
+   The same surface, sampled by the same code compiled for wider
+   instruction sets, i.e. with the compiler free to use them;
+   see selectGeometryKernel().
+   Each build is in a namespace of its own, so that the linker
+   can never substitute one of its functions for a generic one.
+*/
+#if (defined(__x86_64__) || defined(__i386__)) \
+   && defined(__GNUC__) && !defined(__clang__)
+#define HAVE_GEOMETRY_KERNEL_VARIANTS
+
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+namespace exact_avx2 {
+   typedef double Real;
+   #define JET_OPERATION COUNTED_JET_OPERATION
+   #include "evertSurface.h"
+   #include "sampleSurface.h"
+}
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512dq,avx512vl,avx2,fma")
+namespace exact_avx512 {
+   typedef double Real;
+   #define JET_OPERATION COUNTED_JET_OPERATION
+   #include "evertSurface.h"
+   #include "sampleSurface.h"
+}
+#pragma GCC pop_options
 
-class ThreeJet {
-public: // hack
-  double f;
-private:
-  double fu, fv;
-  double fuu, fuv, fvv;
-  double fuuv, fuvv;
-
-  ThreeJet(double d, double du, double dv, double duu, double duv, double dvv,
-   double duuv, double duvv)
-   { f = d; fu = du; fv = dv; fuu = duu; fuv = duv; fvv = dvv;
-     fuuv = duuv; fuvv = duvv; }
-  public:
-  ThreeJet() {}
-  ThreeJet(double d, double du, double dv)
-   { f = d; fu = du; fv = dv; fuu = fuv = fvv = fuuv = fuvv = 0;}
-  operator TwoJet() { return TwoJet(f, fu, fv, fuv); }
-#if 0
-  operator double() { return f; }
 #endif
-  bool operator<(double d) { return f < d; }
-  bool operator>(double d) { return f > d; }
-  bool operator<=(double d) { return f <= d; }
-  bool operator>=(double d) { return f >= d; }
-  void operator %=(double d)
-   { f = fmod(f, d); if (f < 0) f += d; }
-  friend ThreeJet operator+(const ThreeJet x, const ThreeJet y);
-  friend ThreeJet operator*(const ThreeJet x, const ThreeJet y);
-  friend ThreeJet operator+(const ThreeJet x, double d);
-  friend ThreeJet operator*(const ThreeJet x, double d);
-  friend ThreeJet Sin(const ThreeJet x);
-  friend ThreeJet Cos(const ThreeJet x);
-  friend ThreeJet operator^(const ThreeJet x, double n);
-  friend ThreeJet Annihilate(const ThreeJet x, int index);
-  friend ThreeJet Interpolate(const ThreeJet v1, const ThreeJet v2, const ThreeJet weight);
-  friend class TwoJet D(const class ThreeJet x, int index);
-};
 
-// ----------------------------------------
+// The same surface, evaluated over boxes of parameters
+// rather than at points; see boundSurface().
+namespace bounds {
+   typedef Interval Real;
+   #include "evertSurface.h"
+}
+
+using namespace exact;
+
+/* Columns of equally spaced samples per call to the math library */
+static int trigRecurrenceInterval = 16;
+
+void setTrigonometricRecurrenceInterval(int columns) {
+   trigRecurrenceInterval = columns < 1 ? 1 : columns;
+}
 
-ThreeJet operator+(const ThreeJet x, const ThreeJet y) {
-  ThreeJet result;
-  result.f = x.f + y.f;
-  result.fu = x.fu + y.fu;
-  result.fv = x.fv + y.fv;
-  result.fuu = x.fuu + y.fuu;
-  result.fuv = x.fuv + y.fuv;
-  result.fvv = x.fvv + y.fvv;
-  result.fuuv = x.fuuv + y.fuuv;
-  result.fuvv = x.fuvv + y.fuvv;
-  return result;
-}
-
-ThreeJet operator*(const ThreeJet x, const ThreeJet y) {
-  ThreeJet result;
-  result.f = x.f*y.f;
-  result.fu = x.f*y.fu + x.fu*y.f;
-  result.fv = x.f*y.fv + x.fv*y.f;
-  result.fuu = x.f*y.fuu + 2*x.fu*y.fu + x.fuu*y.f;
-  result.fuv = x.f*y.fuv + x.fu*y.fv + x.fv*y.fu + x.fuv*y.f;
-  result.fvv = x.f*y.fvv + 2*x.fv*y.fv + x.fvv*y.f;
-  result.fuuv = x.f*y.fuuv + 2*x.fu*y.fuv + x.fv*y.fuu
-           + 2*x.fuv*y.fu + x.fuu*y.fv + x.fuuv*y.f;
-  result.fuvv = x.f*y.fuvv + 2*x.fv*y.fuv + x.fu*y.fvv
-           + 2*x.fuv*y.fv + x.fvv*y.fu + x.fuvv*y.f;
-  return result;
-}
-
-ThreeJet operator+(const ThreeJet x, double d) {
-  ThreeJet result;
-  result = x;
-  result.f += d;
-  return result;
-}
-
-ThreeJet operator*(const ThreeJet x, double d) {
-  ThreeJet result;
-  result.f = d*x.f;
-  result.fu = d*x.fu;
-  result.fv = d*x.fv;
-  result.fuu = d*x.fuu;
-  result.fuv = d*x.fuv;
-  result.fvv = d*x.fvv;
-  result.fuuv = d*x.fuuv;
-  result.fuvv = d*x.fuvv;
-  return result;
-}
-
-ThreeJet Sin(const ThreeJet x) {
-  ThreeJet result;
-  ThreeJet t = x*(2*M_PI);
-  double s = sin(t.f);
-  double c = cos(t.f);
-  result.f = s;
-  result.fu = c*t.fu;
-  result.fv = c*t.fv;
-  result.fuu = c*t.fuu - s*t.fu*t.fu;
-  result.fuv = c*t.fuv - s*t.fu*t.fv;
-  result.fvv = c*t.fvv - s*t.fv*t.fv;
-  result.fuuv = c*t.fuuv - s*(2*t.fu*t.fuv + t.fv*t.fuu) - c*t.fu*t.fu*t.fv;
-  result.fuvv = c*t.fuvv - s*(2*t.fv*t.fuv + t.fu*t.fvv) - c*t.fu*t.fv*t.fv;
-  return result;
-}
-
-ThreeJet Cos(const ThreeJet x) {
-  ThreeJet result;
-  ThreeJet t = x*(2*M_PI);
-  double s = cos(t.f);
-  double c = -sin(t.f);
-  result.f = s;
-  result.fu = c*t.fu;
-  result.fv = c*t.fv;
-  result.fuu = c*t.fuu - s*t.fu*t.fu;
-  result.fuv = c*t.fuv - s*t.fu*t.fv;
-  result.fvv = c*t.fvv - s*t.fv*t.fv;
-  result.fuuv = c*t.fuuv - s*(2*t.fu*t.fuv + t.fv*t.fuu) - c*t.fu*t.fu*t.fv;
-  result.fuvv = c*t.fuvv - s*(2*t.fv*t.fuv + t.fu*t.fvv) - c*t.fu*t.fv*t.fv;
-  return result;
-}
-
-ThreeJet operator^(const ThreeJet x, double n) {
-  double x0 = pow(x.f, n);
-  double x1 = (x.f == 0) ? 0 : n * x0/x.f;
-  double x2 = (x.f == 0) ? 0 : (n-1) * x1/x.f;
-  double x3 = (x.f == 0) ? 0 : (n-2) * x2/x.f;
-  ThreeJet result;
-  result.f = x0;
-  result.fu = x1*x.fu;
-  result.fv = x1*x.fv;
-  result.fuu = x1*x.fuu + x2*x.fu*x.fu;
-  result.fuv = x1*x.fuv + x2*x.fu*x.fv;
-  result.fvv = x1*x.fvv + x2*x.fv*x.fv;
-  result.fuuv = x1*x.fuuv + x2*(2*x.fu*x.fuv + x.fv*x.fuu) + x3*x.fu*x.fu*x.fv;
-  result.fuvv = x1*x.fuvv + x2*(2*x.fv*x.fuv + x.fu*x.fvv) + x3*x.fu*x.fv*x.fv;
-  return result;
-}
-
-TwoJet D(const ThreeJet x, int index) {
-  TwoJet result;
-  if (index == 0) {
-    result.f = x.fu;
-    result.fu = x.fuu;
-    result.fv = x.fuv;
-    result.fuv = x.fuuv;
-  } else if (index == 1) {
-    result.f = x.fv;
-    result.fu = x.fuv;
-    result.fv = x.fvv;
-    result.fuv = x.fuvv;
-  } else {
-    result.f = result.fu = result.fv =
-    result.fuv = 0;
-  }
-  return result;
-}
-
-ThreeJet Annihilate(const ThreeJet x, int index) {
-  ThreeJet result = ThreeJet(x.f,0,0);
-  if (index == 0) {
-    result.fv = x.fv;
-    result.fvv = x.fvv;
-  } else if (index == 1) {
-    result.fu = x.fu;
-    result.fuu = x.fuu;
-  }
-  return result;
-}
-
-ThreeJet Interpolate(const ThreeJet v1, const ThreeJet v2, const ThreeJet weight) {
-  return (v1) * ((weight) * (-1) + 1) + v2*weight;
+int getTrigonometricRecurrenceInterval() {
+   return trigRecurrenceInterval;
 }
 
 // ----------------------------------------
 
-struct TwoJetVec {
-  TwoJet x;
-  TwoJet y;
-  TwoJet z;
-  TwoJetVec() {}
-  TwoJetVec(TwoJet a, TwoJet b, TwoJet c) { x = a; y = b; z = c; }
+typedef void PrintSceneFunction(
+   EversionStage stage,
+   const double * uSamples,
+   const double * vSamples,
+   bool equallySpacedV,
+   double t,
+   GLPoint ** geometryMatrix,
+   float ** positionMatrix,
+   float ** normalMatrix,
+   GLJetPoint ** jetMatrix,
+   int numStrips,
+   int firstRow, int rowCount,
+   int firstColumn, int columnCount
+);
+
+/* One build of printScene(), and whether the CPU can run it */
+struct GeometryKernel {
+   const char * name;
+   bool (*isSupported)();
+   PrintSceneFunction * printScene;
 };
 
-TwoJetVec operator+(TwoJetVec v, TwoJetVec w);
-TwoJetVec operator*(TwoJetVec v, TwoJet  a);
-TwoJetVec operator*(TwoJetVec v, double a);
-TwoJetVec AnnihilateVec(TwoJetVec v, int index);
-TwoJetVec Cross(TwoJetVec v, TwoJetVec w);
-TwoJet Dot(TwoJetVec v, TwoJetVec w);
-TwoJetVec Normalize(TwoJetVec v);
-TwoJetVec RotateZ(TwoJetVec v, TwoJet angle);
-TwoJetVec RotateY(TwoJetVec v, TwoJet angle);
-TwoJetVec RotateX(TwoJetVec v, TwoJet angle);
-TwoJetVec InterpolateVec(TwoJetVec v1, TwoJetVec v2, TwoJet weight);
-TwoJet Length(TwoJetVec v);
-
-// ----------------------------------------
+static bool isAlwaysSupported() {
+   return true;
+}
 
-TwoJetVec operator+(TwoJetVec v, TwoJetVec w) {
-  TwoJetVec result;
-  result.x = v.x + w.x;
-  result.y = v.y + w.y;
-  result.z = v.z + w.z;
-  return result;
+#ifdef HAVE_GEOMETRY_KERNEL_VARIANTS
+static bool isAVX2Supported() {
+   __builtin_cpu_init();
+   return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
 }
 
-TwoJetVec operator*(TwoJetVec v, TwoJet  a) {
-  TwoJetVec result;
-  result.x = v.x*a;
-  result.y = v.y*a;
-  result.z = v.z*a;
-  return result;
+static bool isAVX512Supported() {
+   __builtin_cpu_init();
+   return isAVX2Supported() && __builtin_cpu_supports("avx512f")
+      && __builtin_cpu_supports("avx512dq") && __builtin_cpu_supports("avx512vl");
 }
+#endif
 
-TwoJetVec operator*(TwoJetVec v, double a) {
-  TwoJetVec result;
-  result.x = v.x*a;
-  result.y = v.y*a;
-  result.z = v.z*a;
-  return result;
+/* From the most generic to the most specific */
+static const GeometryKernel geometryKernels[] = {
+   { "generic", isAlwaysSupported, exact::printScene },
+#ifdef HAVE_GEOMETRY_KERNEL_VARIANTS
+   { "avx2", isAVX2Supported, exact_avx2::printScene },
+   { "avx512", isAVX512Supported, exact_avx512::printScene },
+#endif
+};
+static const int numGeometryKernels
+   = sizeof(geometryKernels) / sizeof(geometryKernels[0]);
+
+static const GeometryKernel * findGeometryKernel(const char * name) {
+   for (int i = 0; i < numGeometryKernels; ++i)
+      if (strcmp(geometryKernels[i].name, name) == 0)
+         return &geometryKernels[i];
+   return NULL;
 }
 
-TwoJetVec AnnihilateVec(TwoJetVec v, int index) {
-  TwoJetVec result;
-  result.x = Annihilate(v.x, index);
-  result.y = Annihilate(v.y, index);
-  result.z = Annihilate(v.z, index);
-  return result;
+static void logGeometryKernel(const GeometryKernel * kernel, const char * reason) {
+   fprintf(stderr, "sphereEversion: sampling the surface "
+      "with the %s kernel (%s)\n", kernel->name, reason);
 }
 
-TwoJetVec Cross(TwoJetVec v, TwoJetVec w) {
-  TwoJetVec result;
-  result.x = v.y*w.z + v.z*w.y*-1;
-  result.y = v.z*w.x + v.x*w.z*-1;
-  result.z = v.x*w.y + v.y*w.x*-1;
-  return result;
+/*
+   Picks the most specific kernel that the CPU supports,
+   unless the environment variable SPHERE_EVERSION_KERNEL
+   names one that it supports, and logs the choice.
+*/
+static const GeometryKernel * selectGeometryKernel() {
+   const GeometryKernel * kernel = NULL;
+   const char * reason = "the best supported by this CPU";
+   const char * requested = getenv("SPHERE_EVERSION_KERNEL");
+   if (requested != NULL && requested[0] != '\0') {
+      kernel = findGeometryKernel(requested);
+      if (kernel == NULL)
+         fprintf(stderr, "sphereEversion: unknown kernel "
+            "SPHERE_EVERSION_KERNEL=%s\n", requested);
+      else if (!kernel->isSupported()) {
+         fprintf(stderr, "sphereEversion: kernel "
+            "SPHERE_EVERSION_KERNEL=%s is not supported by this CPU\n",
+            requested);
+         kernel = NULL;
+      }
+      else
+         reason = "set by SPHERE_EVERSION_KERNEL";
+   }
+   if (kernel == NULL)
+      for (int i = numGeometryKernels-1; i >= 0 && kernel == NULL; --i)
+         if (geometryKernels[i].isSupported())
+            kernel = &geometryKernels[i];
+   logGeometryKernel(kernel, reason);
+   return kernel;
 }
 
-TwoJet Dot(TwoJetVec v, TwoJetVec w) {
-  return v.x*w.x + v.y*w.y + v.z*w.z;
+static const GeometryKernel * selectedGeometryKernel() {
+   static const GeometryKernel * selectedKernel = selectGeometryKernel();
+   return selectedKernel;
 }
 
-TwoJetVec Normalize(TwoJetVec v) {
-  TwoJet a;
-  a = Dot(v,v);
-  if (a > 0)
-    a = a^-0.5;
-  else
-    a = TwoJet(0, 0, 0);
-  return v*a;
+static const GeometryKernel * chosenGeometryKernel = NULL;
+
+static const GeometryKernel * geometryKernel() {
+   if (chosenGeometryKernel != NULL)
+      return chosenGeometryKernel;
+   return selectedGeometryKernel();
 }
 
-TwoJetVec RotateZ(TwoJetVec v, TwoJet angle) {
-  TwoJetVec result;
-  TwoJet s,c;
-  s = Sin (angle);
-  c = Cos (angle);
-  result.x =          v.x*c + v.y*s;
-  result.y = v.x*s*-1 + v.y*c;
-  result.z = v.z;
-  return result;
+int getGeometryKernels(const char ** names, int maxCount) {
+   int count = 0;
+   for (int i = 0; i < numGeometryKernels && count < maxCount; ++i)
+      if (geometryKernels[i].isSupported())
+         names[count++] = geometryKernels[i].name;
+   return count;
 }
 
-TwoJetVec RotateY(TwoJetVec v, TwoJet angle) {
-  TwoJetVec result;
-  TwoJet s, c;
-  s = Sin (angle);
-  c = Cos (angle);
-  result.x = v.x*c + v.z*s*-1;
-  result.y = v.y;
-  result.z = v.x*s + v.z*c    ;
-  return result;
+const char * getGeometryKernel() {
+   return geometryKernel()->name;
 }
 
-TwoJetVec RotateX(TwoJetVec v, TwoJet angle) {
-  TwoJetVec result;
-  TwoJet s,c;
-  s = Sin (angle);
-  c = Cos (angle);
-  result.x = v.x;
-  result.y = v.y*c + v.z*s;
-  result.z = v.y*s*-1 + v.z*c;
-  return result;
+const char * getDefaultGeometryKernel() {
+   return selectedGeometryKernel()->name;
 }
 
-TwoJetVec InterpolateVec(TwoJetVec v1, TwoJetVec v2, TwoJet weight) {
-  return (v1) * (weight*-1 + 1) + v2*weight;
+void logGeometryKernel(const char * reason) {
+   logGeometryKernel(geometryKernel(), reason);
 }
 
-TwoJet Length(TwoJetVec v)
-{
-  return (TwoJet(v.x^2) + TwoJet(v.y^2)) ^ (.5);
+bool setGeometryKernel(const char * name) {
+   const GeometryKernel * kernel = findGeometryKernel(name);
+   if (kernel == NULL || !kernel->isSupported())
+      return false;
+   chosenGeometryKernel = kernel;
+   return true;
 }
 
 // ----------------------------------------
 
-struct ThreeJetVec {
-  ThreeJet x;
-  ThreeJet y;
-  ThreeJet z;
-  operator TwoJetVec() { return TwoJetVec(x,y,z); }
-};
-
-ThreeJetVec operator+(ThreeJetVec v, ThreeJetVec w);
-ThreeJetVec operator*(ThreeJetVec v, ThreeJet  a);
-ThreeJetVec operator*(ThreeJetVec v, double a);
-ThreeJetVec AnnihilateVec(ThreeJetVec v, int index);
-ThreeJetVec Cross(ThreeJetVec v, ThreeJetVec w);
-ThreeJet Dot(ThreeJetVec v, ThreeJetVec w);
-TwoJetVec D(ThreeJetVec x, int index);
-ThreeJetVec Normalize(ThreeJetVec v);
-ThreeJetVec RotateZ(ThreeJetVec v, ThreeJet angle);
-ThreeJetVec RotateY(ThreeJetVec v, ThreeJet angle);
-ThreeJetVec RotateX(ThreeJetVec v, ThreeJet angle);
-ThreeJetVec InterpolateVec(ThreeJetVec v1, ThreeJetVec v2, ThreeJet weight);
-ThreeJet Length(ThreeJetVec v);
-
-// ----------------------------------------
+/* How printSceneInTiles() spreads the samples over threads */
+static int samplingThreads = 1;
+static int samplingTileRows = 0, samplingTileColumns = 0;
 
-ThreeJetVec operator+(ThreeJetVec v, ThreeJetVec w) {
-  ThreeJetVec result;
-  result.x = v.x + w.x;
-  result.y = v.y + w.y;
-  result.z = v.z + w.z;
-  return result;
+void setSamplingThreads(int threads, int tileRows, int tileColumns) {
+   samplingThreads = threads < 0 ? 0 : threads;
+   samplingTileRows = tileRows < 0 ? 0 : tileRows;
+   samplingTileColumns = tileColumns < 0 ? 0 : tileColumns;
 }
 
-ThreeJetVec operator*(ThreeJetVec v, ThreeJet  a) {
-  ThreeJetVec result;
-  result.x = v.x*a;
-  result.y = v.y*a;
-  result.z = v.z*a;
-  return result;
+void getSamplingThreads(int * threads, int * tileRows, int * tileColumns) {
+   *threads = samplingThreads;
+   *tileRows = samplingTileRows;
+   *tileColumns = samplingTileColumns;
 }
 
-ThreeJetVec operator*(ThreeJetVec v, double a) {
-  ThreeJetVec result;
-  result.x = v.x*a;
-  result.y = v.y*a;
-  result.z = v.z*a;
-  return result;
+/*
+   Same as printScene() over all rowCount by columnCount samples,
+   but split into tiles of samples (which, unlike those of
+   generateGeometryTiled(), share no samples), evaluated in parallel
+   as set by setSamplingThreads().
+*/
+static void printSceneInTiles(
+   EversionStage stage,
+   const double * uSamples,
+   const double * vSamples,
+   bool equallySpacedV,
+   double t,
+   GLPoint ** geometryMatrix,
+   float ** positionMatrix,
+   float ** normalMatrix,
+   GLJetPoint ** jetMatrix,
+   int numStrips,
+   int rowCount, int columnCount
+) {
+   PrintSceneFunction * printScene = geometryKernel()->printScene;
+   int tileRows = samplingTileRows, tileColumns = samplingTileColumns;
+   if (tileRows <= 0 || tileRows > rowCount) tileRows = rowCount;
+   if (tileColumns <= 0 || tileColumns > columnCount) tileColumns = columnCount;
+   int tilesPerRow = (columnCount + tileColumns - 1) / tileColumns;
+   int tileCount = tilesPerRow * ((rowCount + tileRows - 1) / tileRows);
+
+   if (tileCount == 1) {
+      printScene(stage, uSamples, vSamples, equallySpacedV, t,
+         geometryMatrix, positionMatrix, normalMatrix, jetMatrix,
+         numStrips, 0, rowCount, 0, columnCount);
+      return;
+   }
+   parallelFor(tileCount, [&](int tile, int) {
+      int firstRow = (tile / tilesPerRow) * tileRows;
+      int firstColumn = (tile % tilesPerRow) * tileColumns;
+      int rows = firstRow + tileRows > rowCount ? rowCount - firstRow : tileRows;
+      int columns = firstColumn + tileColumns > columnCount
+         ? columnCount - firstColumn : tileColumns;
+      // The rows of the tile, starting at its first column.
+      std::vector<GLPoint *> points(geometryMatrix != NULL ? rows : 0);
+      std::vector<float *> positions(positionMatrix != NULL ? rows : 0);
+      std::vector<float *> normals(positionMatrix != NULL ? rows : 0);
+      std::vector<GLJetPoint *> jets(jetMatrix != NULL ? rows : 0);
+      for (int j = 0; j < rows; ++j) {
+         if (geometryMatrix != NULL)
+            points[j] = geometryMatrix[firstRow + j] + firstColumn;
+         if (positionMatrix != NULL) {
+            positions[j] = positionMatrix[firstRow + j] + 3*firstColumn;
+            normals[j] = normalMatrix[firstRow + j] + 3*firstColumn;
+         }
+         if (jetMatrix != NULL)
+            jets[j] = jetMatrix[firstRow + j] + firstColumn;
+      }
+      printScene(stage, uSamples, vSamples, equallySpacedV, t,
+         geometryMatrix != NULL ? &points[0] : NULL,
+         positionMatrix != NULL ? &positions[0] : NULL,
+         positionMatrix != NULL ? &normals[0] : NULL,
+         jetMatrix != NULL ? &jets[0] : NULL,
+         numStrips, firstRow, rows, firstColumn, columns);
+   }, samplingThreads);
 }
 
-ThreeJetVec AnnihilateVec(ThreeJetVec v, int index) {
-  ThreeJetVec result;
-  result.x = Annihilate(v.x, index);
-  result.y = Annihilate(v.y, index);
-  result.z = Annihilate(v.z, index);
-  return result;
-}
 
-TwoJetVec D(ThreeJetVec x, int index) {
-  TwoJetVec result;
-  result.x = D(x.x, index);
-  result.y = D(x.y, index);
-  result.z = D(x.z, index);
-  return result;
-}
+// ----------------------------------------
 
-ThreeJetVec Cross(ThreeJetVec v, ThreeJetVec w) {
-  ThreeJetVec result;
-  result.x = v.y*w.z + v.z*w.y*-1;
-  result.y = v.z*w.x + v.x*w.z*-1;
-  result.z = v.x*w.y + v.y*w.x*-1;
-  return result;
-}
+/*
+   Given the speed (i.e. the length of the derivative) of the surface
+   at pilotCount+1 equally spaced parameter values in [min,max],
+   fills in count+1 parameter values, from min to max,
+   that are approximately equally spaced in arc length.
+*/
+static void equalizeArcLength(
+   const double * speed, int pilotCount,
+   double min, double max, int count,
+   double * samples
+) {
+   int i, p;
+   double * length = new double[pilotCount+1];
+   double step = (max-min) / pilotCount;
+
+   // cumulative arc length, by the trapezoid rule
+   length[0] = 0;
+   for (p = 1; p <= pilotCount; ++p)
+      length[p] = length[p-1] + 0.5*(speed[p-1] + speed[p])*step;
+
+   if (length[pilotCount] > 0) {
+      for (p = 0, i = 0; i <= count; ++i) {
+         double target = length[pilotCount] * i / count;
+         while (p < pilotCount-1 && length[p+1] < target)
+            ++p;
+         double segment = length[p+1] - length[p];
+         double fraction = segment > 0 ? (target - length[p]) / segment : 0;
+         if (fraction < 0) fraction = 0;
+         else if (fraction > 1) fraction = 1;
+         samples[i] = min + (p + fraction)*step;
+      }
+   } else {
+      for (i = 0; i <= count; ++i)
+         samples[i] = min + i*(max-min)/count;
+   }
+   samples[0] = min;
+   samples[count] = max;
 
-ThreeJet Dot(ThreeJetVec v, ThreeJetVec w) {
-  return v.x*w.x + v.y*w.y + v.z*w.z;
+   delete [] length;
 }
 
-ThreeJetVec Normalize(ThreeJetVec v) {
-  ThreeJet a;
-  a = Dot(v,v);
-  if (a > 0)
-    a = a^-0.5;
-  else
-    a = ThreeJet(0, 0, 0);
-  return v*a;
-}
+/*
+   Fills in the (1+ucount) and (1+vcount) parameter values
+   at which the surface is sampled.
+*/
+static void computeSamples(
+   SurfaceTimeFunction *func,
+   double t,
+   int numStrips,
+   double umin, double umax, int ucount,
+   double vmin, double vmax, int vcount,
+   SampleSpacing spacing,
+   double * uSamples,
+   double * vSamples
+) {
+   int j, k;
 
-ThreeJetVec RotateZ(ThreeJetVec v, ThreeJet angle) {
-  ThreeJetVec result;
-  ThreeJet s,c;
-  s = Sin (angle);
-  c = Cos (angle);
-  result.x =          v.x*c + v.y*s;
-  result.y = v.x*s*-1 + v.y*c;
-  result.z = v.z;
-  return result;
+   if (spacing == SPACING_ARC_LENGTH) {
+      // The speeds are measured on a coarse pilot grid,
+      // averaged over each row (for u) and each column (for v),
+      // so that the resulting grid remains a tensor product grid.
+      int pilotU = ucount < 8 ? 16 : ucount < 64 ? 2*ucount : 128;
+      int pilotV = vcount < 8 ? 16 : vcount < 64 ? 2*vcount : 128;
+      double * speedu = new double[pilotU+1];
+      double * speedv = new double[pilotV+1];
+      for (k = 0; k <= pilotV; ++k)
+         speedv[k] = 0;
+      for (j = 0; j <= pilotU; ++j) {
+         double u = umin + j*(umax-umin)/pilotU;
+         speedu[j] = 0;
+         for (k = 0; k <= pilotV; ++k) {
+            double v = vmin + k*(vmax-vmin)/pilotV;
+            TwoJetVec p = (*func)( ThreeJet(u, 1, 0), ThreeJet(v, 0, 1), t, numStrips );
+            speedu[j] += calcSpeedU(p) / (pilotV+1);
+            speedv[k] += calcSpeedV(p) / (pilotU+1);
+         }
+      }
+      equalizeArcLength(speedu, pilotU, umin, umax, ucount, uSamples);
+      equalizeArcLength(speedv, pilotV, vmin, vmax, vcount, vSamples);
+      delete [] speedu;
+      delete [] speedv;
+   } else {
+      double delta_u = (umax-umin) / ucount;
+      double delta_v = (vmax-vmin) / vcount;
+      for (j = 0; j <= ucount; ++j)
+         uSamples[j] = umin + j*delta_u;
+      for (k = 0; k <= vcount; ++k)
+         vSamples[k] = vmin + k*delta_v;
+   }
 }
 
-ThreeJetVec RotateY(ThreeJetVec v, ThreeJet angle) {
-  ThreeJetVec result;
-  ThreeJet s, c;
-  s = Sin (angle);
-  c = Cos (angle);
-  result.x = v.x*c + v.z*s*-1;
-  result.y = v.y;
-  result.z = v.x*s + v.z*c    ;
-  return result;
-}
+// ----------------------------------------
 
-ThreeJetVec RotateX(ThreeJetVec v, ThreeJet angle) {
-  ThreeJetVec result;
-  ThreeJet s,c;
-  s = Sin (angle);
-  c = Cos (angle);
-  result.x = v.x;
-  result.y = v.y*c + v.z*s;
-  result.z = v.y*s*-1 + v.z*c;
-  return result;
+void hermiteBasis(double s, double h[4], double dh[4]) {
+   double s2 = s*s, s3 = s2*s;
+   h[0] = 2*s3 - 3*s2 + 1;
+   h[1] = -2*s3 + 3*s2;
+   h[2] = s3 - 2*s2 + s;
+   h[3] = s3 - s2;
+   dh[0] = 6*s2 - 6*s;
+   dh[1] = -6*s2 + 6*s;
+   dh[2] = 3*s2 - 4*s + 1;
+   dh[3] = 3*s2 - 2*s;
 }
 
-ThreeJetVec InterpolateVec(ThreeJetVec v1, ThreeJetVec v2, ThreeJet weight) {
-  return (v1) * (weight*-1 + 1) + v2*weight;
+/*
+   Evaluates the bicubic Hermite patch spanned by the four corners
+   p[0][0] = (u0,v0), p[0][1] = (u0,v1), p[1][0] = (u1,v0), p[1][1] = (u1,v1),
+   at the point whose local coordinates within the patch have
+   the basis functions hs, dhs (along u) and ht, dht (along v).
+*/
+static void evaluateHermitePatch(
+   const GLJetPoint * p[2][2],
+   const double hs[4], const double dhs[4],
+   const double ht[4], const double dht[4],
+   const double st[2], // bilinear weights along u and v, for fallback normals
+   GLPoint * point
+) {
+   double hu = p[1][0]->u - p[0][0]->u;
+   double hv = p[0][1]->v - p[0][0]->v;
+   double position[3], ds[3], dt[3];
+   int c, a, b;
+
+   for (c = 0; c < 3; ++c) {
+      // The geometry matrix of the patch, for component c.
+      double G[4][4];
+      for (a = 0; a < 2; ++a)
+         for (b = 0; b < 2; ++b) {
+            G[a][b] = p[a][b]->vertex[c];
+            G[a][b+2] = p[a][b]->dv[c] * hv;
+            G[a+2][b] = p[a][b]->du[c] * hu;
+            G[a+2][b+2] = p[a][b]->duv[c] * hu * hv;
+         }
+      position[c] = ds[c] = dt[c] = 0;
+      for (a = 0; a < 4; ++a) {
+         double g = G[a][0]*ht[0] + G[a][1]*ht[1] + G[a][2]*ht[2] + G[a][3]*ht[3];
+         double gt = G[a][0]*dht[0] + G[a][1]*dht[1] + G[a][2]*dht[2] + G[a][3]*dht[3];
+         position[c] += hs[a]*g;
+         ds[c] += dhs[a]*g;
+         dt[c] += hs[a]*gt;
+      }
+   }
+
+   double nx = ds[1]*dt[2] - ds[2]*dt[1];
+   double ny = ds[2]*dt[0] - ds[0]*dt[2];
+   double nz = ds[0]*dt[1] - ds[1]*dt[0];
+   double n = nx*nx + ny*ny + nz*nz;
+
+   point->vertex[0] = position[0];
+   point->vertex[1] = position[1];
+   point->vertex[2] = position[2];
+   if (n > 1e-24 * hu*hu*hv*hv) {
+      n = sqrt(1/n);
+      point->normal[0] = -nx*n;
+      point->normal[1] = -ny*n;
+      point->normal[2] = -nz*n;
+   } else {
+      // Degenerate (e.g. at a pole): blend the exact normals of the corners.
+      for (c = 0; c < 3; ++c)
+         point->normal[c] =
+            (1-st[0])*((1-st[1])*p[0][0]->normal[c] + st[1]*p[0][1]->normal[c])
+            + st[0]*((1-st[1])*p[1][0]->normal[c] + st[1]*p[1][1]->normal[c]);
+   }
 }
 
-ThreeJet Length(ThreeJetVec v)
-{
-  return (ThreeJet(v.x^2) + ThreeJet(v.y^2)) ^ (.5);
+/*
+   Fills in the fine grid of points by evaluating, at refinement^2
+   points per patch of the coarse grid of jets, the bicubic Hermite patch
+   defined by the corners of that patch.
+*/
+static void upsampleHermite(
+   GLJetPoint ** jetMatrix, int ucount, int vcount,
+   int refinement,
+   GLPoint ** geometryMatrix
+) {
+   int j, k, a, b;
+   double (*hs)[4] = new double[refinement+1][4];
+   double (*dhs)[4] = new double[refinement+1][4];
+
+   // The basis functions are the same for every patch.
+   for (a = 0; a <= refinement; ++a)
+      hermiteBasis((double)a / refinement, hs[a], dhs[a]);
+
+   for (j = 0; j < ucount; ++j)
+      for (k = 0; k < vcount; ++k) {
+         const GLJetPoint * p[2][2] = {
+            { &jetMatrix[j][k], &jetMatrix[j][k+1] },
+            { &jetMatrix[j+1][k], &jetMatrix[j+1][k+1] }
+         };
+         // Each patch fills in its interior and its lower edges;
+         // the last row and column of patches also fill in their upper edges.
+         int aMax = j == ucount-1 ? refinement : refinement-1;
+         int bMax = k == vcount-1 ? refinement : refinement-1;
+         for (a = 0; a <= aMax; ++a)
+            for (b = 0; b <= bMax; ++b) {
+               double st[2] = { (double)a / refinement, (double)b / refinement };
+               evaluateHermitePatch(p, hs[a], dhs[a], hs[b], dhs[b], st,
+                  &geometryMatrix[j*refinement + a][k*refinement + b]);
+            }
+      }
+
+   delete [] hs;
+   delete [] dhs;
 }
 
 // ----------------------------------------
 
-TwoJetVec FigureEight(TwoJetVec w, TwoJetVec h, TwoJetVec bend, TwoJet form, TwoJet v) {
+/*
+   Picks the stage of the eversion that is active at the given time
+   (given both as a function of (u,v) and as an EversionStage,
+   see StageFrameFunction()),
+   and rescales the time to the [0,1] interval of that stage.
+   Returns false if no stage is active.
+   Operations on jets are counted under that stage from then on.
+*/
+static bool selectScene(
+   double time,
+   double bendtime,
+   double corrStart,
+   double pushStart,
+   double twistStart,
+   double unpushStart,
+   double uncorrStart,
+   SurfaceTimeFunction ** func,
+   EversionStage * stage,
+   double * t
+) {
+   if (bendtime >= 0.0) {
+      *func = BendIn;
+      *stage = STAGE_BEND_IN;
+      *t = bendtime;
+   } else {
+
+      /* time = (time - howfar) / chunk */
 
-   TwoJet height;
-   v %= 1;
-   height = (Cos (v*2) + -1) * (-1);
-   if (v > 0.25 && v < 0.75)
-      height = height*-1 + 4;
-   height = height*0.6;
-   h = h + bend*(height*height*(1/64.0));
-   return w*Sin (v*2) + (h) * (Interpolate((Cos (v) + -1) * (-2), height, form)) ;
+      if (time >= uncorrStart) {
+         *func = UnCorrugate;
+         *stage = STAGE_UNCORRUGATE;
+         *t = (time - uncorrStart) / (1.0 - uncorrStart);
+      } else if (time >= unpushStart) {
+         *func = UnPush;
+         *stage = STAGE_UNPUSH;
+         *t = (time - unpushStart) / (uncorrStart - unpushStart);
+      } else if (time >= twistStart) {
+         *func = Twist;
+         *stage = STAGE_TWIST;
+         *t = (time - twistStart) / (unpushStart - twistStart);
+      } else if (time >= pushStart) {
+         *func = PushThrough;
+         *stage = STAGE_PUSH_THROUGH;
+         *t = (time - pushStart) / (twistStart - pushStart);
+      } else if (time >= corrStart) {
+         *func = Corrugate;
+         *stage = STAGE_CORRUGATE;
+         *t = (time - corrStart) / (pushStart - corrStart);
+      } else
+         return false;
+   }
+   SET_COUNTED_STAGE(*stage);
+   return true;
 }
 
-TwoJetVec AddFigureEight(ThreeJetVec p, ThreeJet u, TwoJet v, ThreeJet form, ThreeJet scale, int numStrips) {
+/*
+   The body of generateGeometry() and generateJetGeometry(),
+   writing the samples into whichever of the matrices are non-NULL
+   (positionMatrix and normalMatrix go together; see printScene()).
+*/
+static void generateSamples(
+   GLPoint ** geometryMatrix,
+   float ** positionMatrix,
+   float ** normalMatrix,
+   GLJetPoint ** jetMatrix,
+   double time,
+   int numStrips,
 
-   ThreeJet size = form * scale;
-   form = form*2 + form*form*-1;
-   TwoJetVec dv = AnnihilateVec(D(p, 1), 1);
-   p = AnnihilateVec(p, 1);
-   TwoJetVec du = Normalize(D(p, 0));
-   TwoJetVec h = Normalize(Cross(du, dv))*TwoJet(size);
-   TwoJetVec w = Normalize(Cross(h, du))*(TwoJet(size)*1.1);
-   return RotateZ(
-      TwoJetVec(p) +
-      FigureEight(w, h, du*D(size, 0)*(D(u, 0)^(-1)), form, v),
-      v*(1.0/numStrips)
-   );
-}
+   double u_min,
+   int u_count,
+   double u_max,
+   double v_min,
+   int v_count,
+   double v_max,
 
-// ----------------------------------------
+   SampleSpacing spacing,
 
-ThreeJetVec Arc(ThreeJet u, ThreeJet v, double xsize, double ysize, double zsize) {
+   double bendtime,
 
-   ThreeJetVec result;
-   u = u*0.25;
-   result.x = Sin (u) * Sin (v) * xsize;
-   result.y = Sin (u) * Cos (v) * ysize;
-   result.z = Cos (u) * zsize;
-   return result;
-}
+   double corrStart,
+   double pushStart,
+   double twistStart,
+   double unpushStart,
+   double uncorrStart
+) {
+   SurfaceTimeFunction * func;
+   EversionStage stage;
+   double t;
 
-ThreeJetVec Straight(ThreeJet u, ThreeJet v, double xsize, double ysize, double zsize) {
+   if ((NULL == geometryMatrix && NULL == positionMatrix && NULL == jetMatrix)
+         || u_count <= 0 || v_count <= 0)
+      return;
+   if (!selectScene(time, bendtime, corrStart, pushStart, twistStart,
+         unpushStart, uncorrStart, &func, &stage, &t))
+      return;
 
-   ThreeJetVec result;
-   u = u*0.25;
-#if 0
-   u = (u) * (-0.15915494) + 1; /* 1/2pi */
-#endif
-   result.x = Sin (v) * xsize;
-   result.y = Cos (v) * ysize;
-   result.z = Cos (u) * zsize;
-   return result;
+   double * uSamples = new double[u_count+1];
+   double * vSamples = new double[v_count+1];
+   computeSamples(func, t, numStrips, u_min, u_max, u_count,
+      v_min, v_max, v_count, spacing, uSamples, vSamples);
+   printSceneInTiles(stage, uSamples, vSamples, spacing == SPACING_UNIFORM,
+      t, geometryMatrix, positionMatrix, normalMatrix, jetMatrix,
+      numStrips, u_count+1, v_count+1);
+   delete [] uSamples;
+   delete [] vSamples;
 }
 
-ThreeJet Param1(ThreeJet x) {
+/*
+   Refer to generateGeometry.h for
+   documentation on this function.
+*/
+void generateGeometry(
+   GLPoint ** geometryMatrix,
+   double time,
+   int numStrips,
 
-   double offset = 0;
-   x %= 4;
-   if (x > 2) { x = x+(-2); offset = 2; }
-   if (x <= 1) return x*2 + (x^2)*(-1) + offset;
-   else return (x^2) + x*(-2) + (2 + offset);
-}
+   double u_min,
+   int u_count,
+   double u_max,
+   double v_min,
+   int v_count,
+   double v_max,
 
-ThreeJet Param2(ThreeJet x) {
+   SampleSpacing spacing,
 
-   double offset = 0;
-   x %= 4;
-   if (x > 2) { x = x+(-2); offset = 2; }
-   if (x <= 1) return (x^2) + offset;
-   else return (x^2)*(-1) + x*4 + (-2 + offset);
-}
+   double bendtime,
 
-static inline ThreeJet TInterp(double x) {
-   return ThreeJet(x,0,0);
+   double corrStart,
+   double pushStart,
+   double twistStart,
+   double unpushStart,
+   double uncorrStart
+) {
+   if (NULL == geometryMatrix)
+      return;
+
+   generateJetGeometry(geometryMatrix, NULL, time, numStrips,
+      u_min, u_count, u_max, v_min, v_count, v_max, spacing,
+      bendtime, corrStart, pushStart, twistStart, unpushStart, uncorrStart);
 }
 
-ThreeJet UInterp(ThreeJet x) {
+/*
+   Refer to generateGeometry.h for
+   documentation on this function.
+*/
+void generateGeometry(
+   const VertexStreams & streams,
+   double time,
+   int numStrips,
 
-   x %= 2;
-   if (x > 1)
-      x = x*(-1) + 2;
-   return (x^2)*3 + (x^3) * (-2);
-}
+   double u_min,
+   int u_count,
+   double u_max,
+   double v_min,
+   int v_count,
+   double v_max,
 
-#define FFPOW 3
-ThreeJet FFInterp(ThreeJet x) {
+   SampleSpacing spacing,
 
-   x %= 2;
-   if (x > 1)
-      x = x*(-1) + 2;
-   x = x*1.06 + -0.05;
-   if (x < 0) return ThreeJet(0, 0, 0);
-   else if (x > 1) return ThreeJet(0, 0, 0) + 1;
-   else return (x ^ (FFPOW-1)) * (FFPOW) + (x^FFPOW) * (-FFPOW+1);
-}
+   double bendtime,
 
-#define FSPOW 3
-ThreeJet FSInterp(ThreeJet x) {
+   double corrStart,
+   double pushStart,
+   double twistStart,
+   double unpushStart,
+   double uncorrStart
+) {
+   int j;
 
-   x %= 2;
-   if (x > 1)
-      x = x*(-1) + 2;
-   return ((x ^ (FSPOW-1)) * (FSPOW) + (x^FSPOW) * (-FSPOW+1)) * (-0.2);
-}
+   if ((NULL == streams.points && NULL == streams.positions)
+         || u_count < 0 || streams.rowStride < 1 + v_count)
+      return;
 
-ThreeJetVec Stage0(ThreeJet u, ThreeJet v) {
-   return Straight(u, v, 1, 1, 1);
-}
+   // The samplers take rows; these point into the streams.
+   GLPoint ** geometryMatrix = NULL;
+   float ** positionMatrix = NULL, ** normalMatrix = NULL;
+   if (streams.points != NULL) {
+      geometryMatrix = new GLPointPointer[1 + u_count];
+      for (j = 0; j <= u_count; ++j)
+         geometryMatrix[j] = streams.points + (long)j * streams.rowStride;
+   }
+   if (streams.positions != NULL) {
+      positionMatrix = new float *[1 + u_count];
+      normalMatrix = new float *[1 + u_count];
+      for (j = 0; j <= u_count; ++j) {
+         positionMatrix[j] = streams.positions + 3L * j * streams.rowStride;
+         normalMatrix[j] = streams.normals + 3L * j * streams.rowStride;
+      }
+   }
 
-ThreeJetVec Stage1(ThreeJet u, ThreeJet v) {
-   return Arc(u, v, 1, 1, 1);
+   generateSamples(geometryMatrix, positionMatrix, normalMatrix, NULL,
+      time, numStrips,
+      u_min, u_count, u_max, v_min, v_count, v_max, spacing,
+      bendtime, corrStart, pushStart, twistStart, unpushStart, uncorrStart);
+
+   delete [] geometryMatrix;
+   delete [] positionMatrix;
+   delete [] normalMatrix;
 }
 
-ThreeJetVec Stage2(ThreeJet u, ThreeJet v) {
-   return InterpolateVec(
-      Arc(Param1(u), v, 0.9, 0.9, -1),
-      Arc(Param2(u), v, 1, 1, 0.5),
-      UInterp(u)
-   );
+/*
+   Refer to generateGeometry.h for
+   documentation on this function.
+*/
+void generateGeometry(
+   GLPoint * vertices,
+   int rowStride,
+   double time,
+   int numStrips,
+
+   double u_min,
+   int u_count,
+   double u_max,
+   double v_min,
+   int v_count,
+   double v_max,
+
+   SampleSpacing spacing,
+
+   double bendtime,
+
+   double corrStart,
+   double pushStart,
+   double twistStart,
+   double unpushStart,
+   double uncorrStart
+) {
+   VertexStreams streams = { vertices, NULL, NULL, rowStride };
+   generateGeometry(streams, time, numStrips,
+      u_min, u_count, u_max, v_min, v_count, v_max, spacing,
+      bendtime, corrStart, pushStart, twistStart, unpushStart, uncorrStart);
 }
 
-ThreeJetVec Stage3(ThreeJet u, ThreeJet v) {
+/*
+   Refer to generateGeometry.h for
+   documentation on this function.
+*/
+void generateGeometryTiled(
+   GeometryTileSink * sink,
+   int tileRows,
+   int tileColumns,
+   double time,
+   int numStrips,
+
+   double u_min,
+   int u_count,
+   double u_max,
+   double v_min,
+   int v_count,
+   double v_max,
+
+   SampleSpacing spacing,
+
+   double bendtime,
+
+   double corrStart,
+   double pushStart,
+   double twistStart,
+   double unpushStart,
+   double uncorrStart
+) {
+   SurfaceTimeFunction * func;
+   EversionStage stage;
+   double t;
+   GeometryTile tile;
+   int j;
+
+   if (NULL == sink || u_count <= 0 || v_count <= 0)
+      return;
+   if (!selectScene(time, bendtime, corrStart, pushStart, twistStart,
+         unpushStart, uncorrStart, &func, &stage, &t))
+      return;
 
-   return InterpolateVec(
-      Arc(Param1(u), v,-0.9,-0.9,-1),
-      Arc(Param2(u), v,-1, 1,-0.5),
-      UInterp(u)
-   );
+   double * uSamples = new double[u_count+1];
+   double * vSamples = new double[v_count+1];
+   computeSamples(func, t, numStrips, u_min, u_max, u_count,
+      v_min, v_max, v_count, spacing, uSamples, vSamples);
+
+   if (tileRows <= 0 || tileRows > u_count) tileRows = u_count;
+   if (tileColumns <= 0 || tileColumns > v_count) tileColumns = v_count;
+
+   // One buffer, big enough for the largest tile, is reused for every tile.
+   VertexLayout layout = sink->vertexLayout();
+   tile.points = NULL;
+   if (layout & LAYOUT_INTERLEAVED) {
+      tile.points = new GLPointPointer[1 + tileRows];
+      for (j = tileRows; j >= 0; --j)
+         tile.points[j] = new GLPoint[1 + tileColumns];
+   }
+   tile.positions = tile.normals = NULL;
+   if (layout & LAYOUT_SPLIT) {
+      tile.positions = new float *[1 + tileRows];
+      tile.normals = new float *[1 + tileRows];
+      for (j = tileRows; j >= 0; --j) {
+         tile.positions[j] = new float[3 * (1 + tileColumns)];
+         tile.normals[j] = new float[3 * (1 + tileColumns)];
+      }
+   }
+   tile.jets = NULL;
+   if (sink->needsJets()) {
+      tile.jets = new GLJetPoint *[1 + tileRows];
+      for (j = tileRows; j >= 0; --j)
+         tile.jets[j] = new GLJetPoint[1 + tileColumns];
+   }
+
+   for (tile.firstRow = 0; tile.firstRow < u_count; tile.firstRow += tileRows) {
+      tile.rowCount = 1 + (
+         tile.firstRow + tileRows > u_count ? u_count - tile.firstRow : tileRows
+      );
+      for (
+         tile.firstColumn = 0;
+         tile.firstColumn < v_count;
+         tile.firstColumn += tileColumns
+      ) {
+         tile.columnCount = 1 + (
+            tile.firstColumn + tileColumns > v_count
+            ? v_count - tile.firstColumn : tileColumns
+         );
+         geometryKernel()->printScene(stage, uSamples, vSamples, spacing == SPACING_UNIFORM,
+            t, tile.points, tile.positions, tile.normals, tile.jets, numStrips,
+            tile.firstRow, tile.rowCount, tile.firstColumn, tile.columnCount );
+         sink->consumeTile( tile );
+      }
+   }
+
+   if (tile.points != NULL) {
+      for (j = tileRows; j >= 0; --j)
+         delete [] (tile.points[j]);
+      delete [] tile.points;
+   }
+   if (tile.positions != NULL) {
+      for (j = tileRows; j >= 0; --j) {
+         delete [] (tile.positions[j]);
+         delete [] (tile.normals[j]);
+      }
+      delete [] tile.positions;
+      delete [] tile.normals;
+   }
+   if (tile.jets != NULL) {
+      for (j = tileRows; j >= 0; --j)
+         delete [] (tile.jets[j]);
+      delete [] tile.jets;
+   }
+   delete [] uSamples;
+   delete [] vSamples;
 }
 
-ThreeJetVec Stage4(ThreeJet u, ThreeJet v) {
-   return Arc(u, v, -1,-1, -1);
+/*
+   Refer to generateGeometry.h for
+   documentation on this function.
+*/
+void generateGeometryUpsampled(
+   GLPoint ** geometryMatrix,
+   int refinement,
+   double time,
+   int numStrips,
+
+   double u_min,
+   int u_count,
+   double u_max,
+   double v_min,
+   int v_count,
+   double v_max,
+
+   SampleSpacing spacing,
+
+   double bendtime,
+
+   double corrStart,
+   double pushStart,
+   double twistStart,
+   double unpushStart,
+   double uncorrStart
+) {
+   SurfaceTimeFunction * func;
+   EversionStage stage;
+   double t;
+   int j;
+
+   if (refinement <= 1) {
+      generateGeometry(geometryMatrix, time, numStrips,
+         u_min, u_count, u_max, v_min, v_count, v_max, spacing,
+         bendtime, corrStart, pushStart, twistStart, unpushStart, uncorrStart);
+      return;
+   }
+   if (NULL == geometryMatrix || u_count <= 0 || v_count <= 0)
+      return;
+   if (!selectScene(time, bendtime, corrStart, pushStart, twistStart,
+         unpushStart, uncorrStart, &func, &stage, &t))
+      return;
+
+   GLJetPoint ** jetMatrix = new GLJetPoint *[u_count+1];
+   for (j = 0; j <= u_count; ++j)
+      jetMatrix[j] = new GLJetPoint[v_count+1];
+
+   generateJetGeometry(NULL, jetMatrix, time, numStrips,
+      u_min, u_count, u_max, v_min, v_count, v_max, spacing,
+      bendtime, corrStart, pushStart, twistStart, unpushStart, uncorrStart);
+   upsampleHermite(jetMatrix, u_count, v_count, refinement, geometryMatrix);
+
+   for (j = 0; j <= u_count; ++j)
+      delete [] jetMatrix[j];
+   delete [] jetMatrix;
 }
 
-ThreeJetVec Scene01(ThreeJet u, ThreeJet v, double t) {
-   return InterpolateVec(Stage0(u,v), Stage1(u,v), TInterp(t));
+/*
+   Refer to generateGeometry.h for
+   documentation on this function.
+*/
+void generateGeometryUpsampled(
+   const VertexStreams & streams,
+   int refinement,
+   double time,
+   int numStrips,
+
+   double u_min,
+   int u_count,
+   double u_max,
+   double v_min,
+   int v_count,
+   double v_max,
+
+   SampleSpacing spacing,
+
+   double bendtime,
+
+   double corrStart,
+   double pushStart,
+   double twistStart,
+   double unpushStart,
+   double uncorrStart
+) {
+   int j, k, i;
+
+   if (refinement <= 1) {
+      generateGeometry(streams, time, numStrips,
+         u_min, u_count, u_max, v_min, v_count, v_max, spacing,
+         bendtime, corrStart, pushStart, twistStart, unpushStart, uncorrStart);
+      return;
+   }
+   int rows = refinement * u_count, columns = refinement * v_count;
+   if ((NULL == streams.points && NULL == streams.positions)
+         || rows < 0 || streams.rowStride < 1 + columns)
+      return;
+
+   // Hermite upsampling writes GLPoints; without a stream of them,
+   // they go to a temporary buffer, and are then split.
+   GLPoint ** geometryMatrix = new GLPointPointer[1 + rows];
+   GLPoint * points = streams.points;
+   if (points == NULL)
+      points = new GLPoint[(long)(1 + rows) * streams.rowStride];
+   for (j = 0; j <= rows; ++j)
+      geometryMatrix[j] = points + (long)j * streams.rowStride;
+
+   generateGeometryUpsampled(geometryMatrix, refinement, time, numStrips,
+      u_min, u_count, u_max, v_min, v_count, v_max, spacing,
+      bendtime, corrStart, pushStart, twistStart, unpushStart, uncorrStart);
+
+   if (streams.positions != NULL)
+      for (j = 0; j <= rows; ++j) {
+         float * position = streams.positions + 3L * j * streams.rowStride;
+         float * normal = streams.normals + 3L * j * streams.rowStride;
+         for (k = 0; k <= columns; ++k)
+            for (i = 0; i < 3; ++i) {
+               position[3*k+i] = geometryMatrix[j][k].vertex[i];
+               normal[3*k+i] = geometryMatrix[j][k].normal[i];
+            }
+      }
+
+   if (points != streams.points)
+      delete [] points;
+   delete [] geometryMatrix;
 }
 
-ThreeJetVec Scene12(ThreeJet u, ThreeJet v, double t) {
-   return InterpolateVec(Stage1(u,v), Stage2(u,v), TInterp(t));
+/*
+   Refer to generateGeometry.h for
+   documentation on this function.
+*/
+void generateGeometryUpsampled(
+   GLPoint * vertices,
+   int rowStride,
+   int refinement,
+   double time,
+   int numStrips,
+
+   double u_min,
+   int u_count,
+   double u_max,
+   double v_min,
+   int v_count,
+   double v_max,
+
+   SampleSpacing spacing,
+
+   double bendtime,
+
+   double corrStart,
+   double pushStart,
+   double twistStart,
+   double unpushStart,
+   double uncorrStart
+) {
+   VertexStreams streams = { vertices, NULL, NULL, rowStride };
+   generateGeometryUpsampled(streams, refinement, time, numStrips,
+      u_min, u_count, u_max, v_min, v_count, v_max, spacing,
+      bendtime, corrStart, pushStart, twistStart, unpushStart, uncorrStart);
 }
 
-ThreeJetVec Scene23(ThreeJet u, ThreeJet v, double t) {
+/*
+   Refer to generateGeometry.h for
+   documentation on this function.
+*/
+void generateJetGeometry(
+   GLPoint ** geometryMatrix,
+   GLJetPoint ** jetMatrix,
+   double time,
+   int numStrips,
+
+   double u_min,
+   int u_count,
+   double u_max,
+   double v_min,
+   int v_count,
+   double v_max,
 
-   ThreeJet tmp = TInterp(t);
-   t = tmp.f * 0.5;
-   double tt = (u <= 1) ? t : -t;
-   return InterpolateVec(
-      RotateZ(Arc(Param1(u), v, 0.9, 0.9,-1), ThreeJet(tt,0,0)),
-      RotateY(Arc(Param2(u), v, 1, 1, 0.5), ThreeJet(t,0,0)),
-      UInterp(u)
-  );
+   SampleSpacing spacing,
+
+   double bendtime,
+
+   double corrStart,
+   double pushStart,
+   double twistStart,
+   double unpushStart,
+   double uncorrStart
+) {
+   generateSamples(geometryMatrix, NULL, NULL, jetMatrix, time, numStrips,
+      u_min, u_count, u_max, v_min, v_count, v_max, spacing,
+      bendtime, corrStart, pushStart, twistStart, unpushStart, uncorrStart);
 }
 
-ThreeJetVec Scene34(ThreeJet u, ThreeJet v, double t) {
-   return InterpolateVec(Stage3(u,v), Stage4(u,v), TInterp(t));
+/*
+   Refer to generateGeometry.h for
+   documentation on this function.
+*/
+bool evaluateSurface(
+   GLJetPoint * jet,
+   double u,
+   double v,
+   double time,
+   int numStrips,
+   double bendtime,
+   double corrStart,
+   double pushStart,
+   double twistStart,
+   double unpushStart,
+   double uncorrStart
+) {
+   SurfaceTimeFunction * func;
+   EversionStage stage;
+   double t;
+
+   if (!selectScene(time, bendtime, corrStart, pushStart, twistStart,
+         unpushStart, uncorrStart, &func, &stage, &t))
+      return false;
+
+   /* Same as one sample of printScene() */
+   SurfaceFrameFunction * frameFunc = StageFrameFunction(stage);
+   FigureEightFrame frame = (*frameFunc)(ThreeJet(u, 1, 0), t);
+   if (calcSpeedV(AddFigureEight(frame, FigureEightTrigAt(ThreeJet(0, 0, 1), numStrips))) == 0) {
+      double perturbed = u + ((u < 1) ? 1e-9 : -1e-9);
+      frame = (*frameFunc)(ThreeJet(perturbed, 1, 0), t);
+   }
+   printJet(AddFigureEight(frame, FigureEightTrigAt(ThreeJet(v, 0, 1), numStrips)),
+      u, v, jet);
+   return true;
 }
 
-TwoJetVec BendIn(ThreeJet u, ThreeJet v, double t, int numStrips) {
+// ----------------------------------------
 
-   ThreeJet tmp = TInterp(t);
-   t = tmp.f;
-   return AddFigureEight(
-      Scene01(u, ThreeJet(0, 0, 1), t),
-      u, v, ThreeJet(0, 0, 0), FSInterp(u),
-      numStrips
-   );
-}
+typedef bounds::TwoJetVec BoundedSurfaceTimeFunction(
+   bounds::ThreeJet u, bounds::ThreeJet v, Interval t, int numStrips
+);
 
-TwoJetVec Corrugate(ThreeJet u, ThreeJet v, double t, int numStrips) {
+// Bounds accumulated over the boxes visited by boundSurface().
+struct BoundsAccumulator {
+   bool isEmpty;
+   Interval vertex[3], normal[3];
+   double normalLength;
+};
 
-   ThreeJet tmp = TInterp(t);
-   t = tmp.f;
-   return AddFigureEight(
-      Stage1(u, ThreeJet(0, 0, 1)),
-      u, v, FFInterp(u) * ThreeJet(t,0,0), FSInterp(u),
-      numStrips
-   );
-}
+/* Where a box reaches past a breakpoint (by rounding, since boxes
+   are split at the breakpoints), both answers of each undecidable
+   comparison are tried (see Interval::Branches), for up to this many
+   comparisons; beyond that, the box is split instead */
+static const int maxUndecidedComparisons = 3;
 
-TwoJetVec PushThrough(ThreeJet u, ThreeJet v, double t, int numStrips) {
+/*
+   Adds the bounds of the surface given by p, over a box, to the accumulator.
+   Returns false if the surface came out unbounded.
+*/
+static bool accumulateBounds(
+   bounds::TwoJetVec p,
+   BoundsAccumulator * accumulator
+) {
+   Interval vertex[3] = { p.x.f, p.y.f, p.z.f };
+   Interval nx = p.y.df_du()*p.z.df_dv() - p.z.df_du()*p.y.df_dv();
+   Interval ny = p.z.df_du()*p.x.df_dv() - p.x.df_du()*p.z.df_dv();
+   Interval nz = p.x.df_du()*p.y.df_dv() - p.y.df_du()*p.x.df_dv();
+   Interval s = pow(nx, 2) + pow(ny, 2) + pow(nz, 2);
+   if (!vertex[0].isFinite() || !vertex[1].isFinite() || !vertex[2].isFinite()
+         || !s.isFinite())
+      return false;
+
+   /* Like printVertexAndNormal(), but the normal is only known
+      to be a unit vector (or zero) if s could be zero */
+   Interval normal[3] = { Interval(-1, 1), Interval(-1, 1), Interval(-1, 1) };
+   double normalLength = 0;
+   if (s.lo > 0) {
+      Interval r = pow(s, -0.5);
+      normal[0] = -nx*r;
+      normal[1] = -ny*r;
+      normal[2] = -nz*r;
+      normalLength = Interval::down(sqrt(s.lo));
+   }
 
-   return AddFigureEight(
-      Scene12(u,ThreeJet(0, 0, 1),t),
-      u, v, FFInterp(u), FSInterp(u),
-      numStrips
-   );
+   for (int i = 0; i < 3; ++i) {
+      normal[i] = Interval(fmax(normal[i].lo, -1), fmin(normal[i].hi, 1));
+      if (accumulator->isEmpty) {
+         accumulator->vertex[i] = vertex[i];
+         accumulator->normal[i] = normal[i];
+      } else {
+         accumulator->vertex[i] = hull(accumulator->vertex[i], vertex[i]);
+         accumulator->normal[i] = hull(accumulator->normal[i], normal[i]);
+      }
+   }
+   if (accumulator->isEmpty || normalLength < accumulator->normalLength)
+      accumulator->normalLength = normalLength;
+   accumulator->isEmpty = false;
+   return true;
 }
 
-TwoJetVec Twist(ThreeJet u, ThreeJet v, double t, int numStrips) {
+/*
+   Bounds the surface over a single box of parameters, all within
+   one stage, and adds the bounds to the accumulator.
+   Returns false if the bounds could not be established,
+   i.e. if too many comparisons were undecidable over the box,
+   or the surface came out unbounded.
+*/
+static bool boundBox(
+   BoundedSurfaceTimeFunction *func,
+   Interval u, Interval v, Interval t,
+   int numStrips,
+   BoundsAccumulator * accumulator
+) {
+   BoundsAccumulator boxAccumulator = *accumulator;
+   int undecided = 0;
+   for (unsigned choices = 0; choices < (1u << undecided); ++choices) {
+      Interval::Branches branches(choices);
+      bounds::TwoJetVec p = (*func)(
+         bounds::ThreeJet(u, 1, 0), bounds::ThreeJet(v, 0, 1), t, numStrips
+      );
+      if (branches.undecided() > undecided) {
+         undecided = branches.undecided();
+         if (undecided > maxUndecidedComparisons)
+            return false;
+      }
+      if (!accumulateBounds(p, &boxAccumulator))
+         return false;
+   }
+   *accumulator = boxAccumulator;
+   return true;
+}
 
-   return AddFigureEight(
-      Scene23(u,ThreeJet(0, 0, 1),t),
-      u, v, FFInterp(u), FSInterp(u),
-      numStrips
-   );
+/*
+   Bounds the surface over a box of parameters, all within one stage,
+   bisecting the box along its widest side for as long as the bounds
+   cannot be established, up to the given depth.
+   Returns false if the bounds could not be established.
+*/
+static bool boundBoxRecursively(
+   BoundedSurfaceTimeFunction *func,
+   Interval u, Interval v, Interval t,
+   int numStrips,
+   int depth,
+   BoundsAccumulator * accumulator
+) {
+   if (boundBox(func, u, v, t, numStrips, accumulator))
+      return true;
+   if (depth <= 0)
+      return false;
+
+   Interval a, b;
+   if (u.width() >= v.width() && u.width() >= t.width()) {
+      a = b = u;
+      a.hi = b.lo = u.mid();
+      return boundBoxRecursively(func, a, v, t, numStrips, depth-1, accumulator)
+         && boundBoxRecursively(func, b, v, t, numStrips, depth-1, accumulator);
+   } else if (v.width() >= t.width()) {
+      a = b = v;
+      a.hi = b.lo = v.mid();
+      return boundBoxRecursively(func, u, a, t, numStrips, depth-1, accumulator)
+         && boundBoxRecursively(func, u, b, t, numStrips, depth-1, accumulator);
+   } else {
+      a = b = t;
+      a.hi = b.lo = t.mid();
+      return boundBoxRecursively(func, u, v, a, numStrips, depth-1, accumulator)
+         && boundBoxRecursively(func, u, v, b, numStrips, depth-1, accumulator);
+   }
 }
 
-TwoJetVec UnPush(ThreeJet u, ThreeJet v, double t, int numStrips) {
+/*
+   Fills in breaks[] with min, the values in the sorted array
+   breakpoints[] that lie strictly between min and max, and max.
+   Returns the number of values filled in.
+*/
+static int splitAtBreakpoints(
+   double min, double max,
+   const double * breakpoints, int breakpointCount,
+   double * breaks
+) {
+   int count = 0;
+   breaks[count++] = min;
+   for (int i = 0; i < breakpointCount; ++i)
+      if (breakpoints[i] > min && breakpoints[i] < max)
+         breaks[count++] = breakpoints[i];
+   breaks[count++] = max;
+   return count;
+}
+
+/* Values of u and v at which the functions defining the surface
+   switch from one piece to another, for u in [0,2] and v in [0,1]
+   (FFInterp(), UInterp(), Param1(), Param2(), Scene23(), FigureEight()).
+   Boxes are split there, so that each box lies within one piece. */
+static const double uBreakpoints[] = {
+   0.05/1.06, 1.05/1.06, 1.0, 2.0 - 1.05/1.06, 2.0 - 0.05/1.06
+};
+static const int uBreakpointCount = sizeof(uBreakpoints)/sizeof(double);
+static const double vBreakpointSpacing = 0.25;
 
-   return AddFigureEight(
-      Scene34(u,ThreeJet(0, 0, 1),t),
-      u, v, FFInterp(u), FSInterp(u),
-      numStrips
-   );
+/*
+   Fills in breaks[] with v_min, the multiples of vBreakpointSpacing
+   that lie strictly between v_min and v_max, and v_max.
+   breaks[] must have room for vBreakCountMax(v_min, v_max) values.
+   Returns the number of values filled in.
+*/
+static int vBreakCountMax(double v_min, double v_max) {
+   return (int)((floor(v_max) - floor(v_min)) / vBreakpointSpacing) + 6;
+}
+static int splitAtVBreakpoints(double v_min, double v_max, double * breaks) {
+   int vBreakpointCount = vBreakCountMax(v_min, v_max) - 2;
+   double * vBreakpoints = new double[vBreakpointCount];
+   for (int i = 0; i < vBreakpointCount; ++i)
+      vBreakpoints[i] = floor(v_min) + vBreakpointSpacing*i;
+   int count = splitAtBreakpoints(v_min, v_max,
+      vBreakpoints, vBreakpointCount, breaks);
+   delete [] vBreakpoints;
+   return count;
 }
 
-TwoJetVec UnCorrugate(ThreeJet u, ThreeJet v, double t, int numStrips) {
+/*
+   Refer to generateGeometry.h for
+   documentation on this function.
+*/
+void boundSurface(
+   SurfaceBounds * surfaceBounds,
+   double time_min,
+   double time_max,
+   int numStrips,
 
-   ThreeJet tmp;
-   tmp = TInterp((t) * (-1) + 1);
-   t = tmp.f;
+   double u_min,
+   double u_max,
+   double v_min,
+   double v_max,
 
-   return AddFigureEight(
-      Stage4(u,ThreeJet(0, 0, 1)),
-      u, v, FFInterp(u) * ThreeJet(t,0,0), FSInterp(u),
-      numStrips
-   );
-}
+   double bendtime,
 
-// ----------------------------------------
+   double corrStart,
+   double pushStart,
+   double twistStart,
+   double unpushStart,
+   double uncorrStart
+) {
+   /* Maximum number of bisections of a box */
+   const int maxDepth = 12;
+
+   BoundedSurfaceTimeFunction * funcs[5] = {
+      bounds::Corrugate, bounds::PushThrough, bounds::Twist,
+      bounds::UnPush, bounds::UnCorrugate
+   };
+   double starts[6] = {
+      corrStart, pushStart, twistStart, unpushStart, uncorrStart, 1.0
+   };
+
+   BoundsAccumulator accumulator;
+   accumulator.isEmpty = true;
+   surfaceBounds->isBounded = false;
+   for (int i = 0; i < 3; ++i) {
+      surfaceBounds->vertexMin[i] = -HUGE_VALF;
+      surfaceBounds->vertexMax[i] = HUGE_VALF;
+      surfaceBounds->normalMin[i] = -1;
+      surfaceBounds->normalMax[i] = 1;
+   }
+   surfaceBounds->normalLengthLowerBound = 0;
 
-void printMesh(TwoJetVec p, GLPoint * point) {
+   if (u_min > u_max || v_min > v_max || time_min > time_max)
+      return;
 
-    double x = p.x.f ;
-    double y = p.y.f ;
-    double z = p.z.f ;
-    double nx = p.y.df_du()*p.z.df_dv()-p.z.df_du()*p.y.df_dv();
-    double ny = p.z.df_du()*p.x.df_dv()-p.x.df_du()*p.z.df_dv();
-    double nz = p.x.df_du()*p.y.df_dv()-p.y.df_du()*p.x.df_dv();
-    double s = nx*nx + ny*ny + nz*nz;
-    if (s > 0) s = sqrt(1/s);
+   double * uBreaks = new double[uBreakpointCount + 2];
+   int uBreakCount = splitAtBreakpoints(u_min, u_max,
+      uBreakpoints, uBreakpointCount, uBreaks);
+
+   double * vBreaks = new double[vBreakCountMax(v_min, v_max)];
+   int vBreakCount = splitAtVBreakpoints(v_min, v_max, vBreaks);
+
+   bool isBounded = true;
+   for (int stage = 0; stage < 5 && isBounded; ++stage) {
+      BoundedSurfaceTimeFunction * func;
+      Interval t;
+      if (bendtime >= 0.0) {
+         if (stage > 0)
+            break;
+         func = bounds::BendIn;
+         t = Interval(bendtime);
+      } else {
+         double start = starts[stage], end = starts[stage+1];
+         if (time_max < start || time_min >= end
+               || (time_min == end && stage < 4))
+            continue;
+         func = funcs[stage];
+         t = (Interval(fmax(time_min, start), fmin(time_max, end)) - start)
+            / (end - start);
+         t = Interval(fmax(t.lo, 0), fmin(t.hi, 1));
+      }
+      for (int j = 0; j+1 < uBreakCount && isBounded; ++j)
+         for (int k = 0; k+1 < vBreakCount && isBounded; ++k)
+            isBounded = boundBoxRecursively(func,
+               Interval(uBreaks[j], uBreaks[j+1]),
+               Interval(vBreaks[k], vBreaks[k+1]),
+               t, numStrips, maxDepth, &accumulator);
+   }
+
+   delete [] uBreaks;
+   delete [] vBreaks;
 
-    /* printf("%f %f %f    %f %f %f\n", x, y, z, nx*s, ny*s, nz*s); */
+   if (!isBounded || accumulator.isEmpty)
+      return;
 
-    point->vertex[0] = x;
-    point->vertex[1] = y;
-    point->vertex[2] = z;
-    point->normal[0] = -nx*s;
-    point->normal[1] = -ny*s;
-    point->normal[2] = -nz*s;
+   surfaceBounds->isBounded = true;
+   for (int i = 0; i < 3; ++i) {
+      surfaceBounds->vertexMin[i] = nextafterf(
+         (float)accumulator.vertex[i].lo, -HUGE_VALF);
+      surfaceBounds->vertexMax[i] = nextafterf(
+         (float)accumulator.vertex[i].hi, HUGE_VALF);
+      surfaceBounds->normalMin[i] = fmaxf(-1, nextafterf(
+         (float)accumulator.normal[i].lo, -HUGE_VALF));
+      surfaceBounds->normalMax[i] = fminf(1, nextafterf(
+         (float)accumulator.normal[i].hi, HUGE_VALF));
+   }
+   surfaceBounds->normalLengthLowerBound = accumulator.normalLength;
 }
 
 // ----------------------------------------
 
-typedef TwoJetVec SurfaceTimeFunction(ThreeJet u, ThreeJet v, double t, int numStrips);
+typedef bounds::FigureEightFrame BoundedSurfaceFrameFunction(
+   bounds::ThreeJet u, Interval t
+);
 
-static inline double sqr(double x) {
-  return x*x;
+// A stage of the eversion, as swept by certifyImmersion().
+struct CertificationStage {
+   BoundedSurfaceFrameFunction *boundedFrameFunc;
+   SurfaceTimeFunction *func;
+   double start, end;   // times at which the stage starts and ends
+   int numStrips;
+};
+
+// A box of parameters within one stage, as swept by certifyImmersion().
+struct CertificationBox {
+   const CertificationStage *stage;
+   Interval u, v, t;
+};
+
+// The results of certifyImmersion() accumulated by one thread.
+struct CertificationAccumulator {
+   double normalLength;
+   double minimumNormalLength, minimumU, minimumV, minimumTime;
+   long boxCount, uncertifiedBoxCount;
+   double uncertifiedMin[3], uncertifiedMax[3];
+};
+
+/* The surface varies much faster in u and t than in v,
+   so v is only split down to this many times the widest side
+   of the (u,t) box, before the (u,t) box itself is split */
+static const double certificationVWidthRatio = 16;
+
+/*
+   Returns the length of the cross product of the partial derivatives,
+   i.e. of the normal before printVertexAndNormal() normalizes it.
+*/
+static double normalLength(TwoJetVec p) {
+   double nx = p.y.df_du()*p.z.df_dv()-p.z.df_du()*p.y.df_dv();
+   double ny = p.z.df_du()*p.x.df_dv()-p.x.df_du()*p.z.df_dv();
+   double nz = p.x.df_du()*p.y.df_dv()-p.y.df_du()*p.x.df_dv();
+   return sqrt(nx*nx + ny*ny + nz*nz);
 }
-static inline double calcSpeedV(TwoJetVec v) {
-  return sqrt(sqr(v.x.df_dv()) + sqr(v.y.df_dv()) + sqr(v.z.df_dv()));
+
+/*
+   Adds a box over which the normal was proven non-zero,
+   or could not be, to the accumulator,
+   along with the normal at its center.
+*/
+static void accumulateCertifiedBox(
+   const CertificationStage & stage,
+   Interval u, Interval v, Interval t,
+   bool isCertified, double normalLengthLowerBound,
+   CertificationAccumulator * accumulator
+) {
+   double time[2] = {
+      stage.start + t.lo*(stage.end - stage.start),
+      stage.start + t.hi*(stage.end - stage.start)
+   };
+   if (isCertified) {
+      if (normalLengthLowerBound < accumulator->normalLength)
+         accumulator->normalLength = normalLengthLowerBound;
+   } else {
+      double boxMin[3] = { u.lo, v.lo, time[0] };
+      double boxMax[3] = { u.hi, v.hi, time[1] };
+      for (int i = 0; i < 3; ++i) {
+         accumulator->uncertifiedMin[i]
+            = fmin(accumulator->uncertifiedMin[i], boxMin[i]);
+         accumulator->uncertifiedMax[i]
+            = fmax(accumulator->uncertifiedMax[i], boxMax[i]);
+      }
+      ++ accumulator->uncertifiedBoxCount;
+   }
+
+   double length = normalLength((*stage.func)(
+      ThreeJet(u.mid(), 1, 0), ThreeJet(v.mid(), 0, 1), t.mid(),
+      stage.numStrips
+   ));
+   if (length < accumulator->minimumNormalLength) {
+      accumulator->minimumNormalLength = length;
+      accumulator->minimumU = u.mid();
+      accumulator->minimumV = v.mid();
+      accumulator->minimumTime = 0.5*(time[0] + time[1]);
+   }
 }
-static inline double calcSpeedU(TwoJetVec v) {
-  return sqrt(sqr(v.x.df_du()) + sqr(v.y.df_du()) + sqr(v.z.df_du()));
+
+/*
+   Proves the normal non-zero over an interval of v,
+   given the frame of the figure eight over a box of (u,t),
+   bisecting the interval for as long as that cannot be proven,
+   until it is no wider than minimumWidth.
+   The intervals over which it could not be proven are added to failed.
+*/
+static void certifyVRecursively(
+   const CertificationStage & stage,
+   const bounds::FigureEightFrame & frame,
+   Interval u, Interval v, Interval t,
+   double minimumWidth,
+   std::vector<Interval> * failed,
+   CertificationAccumulator * accumulator
+) {
+   ++ accumulator->boxCount;
+
+   /* |n| must be proven non-zero for every answer
+      of the comparisons that are undecidable over the box */
+   bool isCertified = true;
+   double lowerBound = HUGE_VAL;
+   int undecided = 0;
+   for (unsigned choices = 0;
+         isCertified && choices < (1u << undecided); ++choices) {
+      Interval::Branches branches(choices);
+      bounds::TwoJetVec p = bounds::AddFigureEight(frame,
+         bounds::FigureEightTrigAt(bounds::TwoJet(v, 0, 1), stage.numStrips));
+      Interval nx = p.y.df_du()*p.z.df_dv() - p.z.df_du()*p.y.df_dv();
+      Interval ny = p.z.df_du()*p.x.df_dv() - p.x.df_du()*p.z.df_dv();
+      Interval nz = p.x.df_du()*p.y.df_dv() - p.y.df_du()*p.x.df_dv();
+      Interval s = pow(nx, 2) + pow(ny, 2) + pow(nz, 2);
+      if (branches.undecided() > undecided)
+         undecided = branches.undecided();
+      isCertified = undecided <= maxUndecidedComparisons
+         && s.isFinite() && s.lo > 0;
+      if (isCertified)
+         lowerBound = fmin(lowerBound, Interval::down(sqrt(s.lo)));
+   }
+
+   if (isCertified) {
+      accumulateCertifiedBox(stage, u, v, t,
+         true, lowerBound, accumulator);
+   } else if (v.width() > minimumWidth) {
+      Interval a = v, b = v;
+      a.hi = b.lo = v.mid();
+      certifyVRecursively(stage, frame, u, a, t,
+         minimumWidth, failed, accumulator);
+      certifyVRecursively(stage, frame, u, b, t,
+         minimumWidth, failed, accumulator);
+   } else
+      failed->push_back(v);
 }
 
-void printScene(
-   SurfaceTimeFunction *func,
-   double umin, double umax, int ucount,
-   double vmin, double vmax, int vcount,
-   double t,
-   GLPoint ** geometryMatrix,
-   int numStrips
+/*
+   Proves the normal non-zero over a box of (u,t), all within one stage,
+   and the given intervals of v.
+   The frame of the figure eight, which only depends on (u,t),
+   is bounded once for all of v; where that is not enough to prove
+   the normal non-zero, the (u,t) box is bisected along its widest side
+   (measuring t as a time), up to the given depth.
+*/
+static void certifyBoxRecursively(
+   const CertificationStage & stage,
+   Interval u, const std::vector<Interval> & vs, Interval t,
+   int depth,
+   CertificationAccumulator * accumulator
 ) {
-   static TwoJetVec **values;
-   int j, k;
-   double u, v, delta_u, delta_v;
-
-   if (ucount <= 0 || vcount <= 0) return;
-   delta_u = (umax-umin) / ucount;
-   delta_v = (vmax-vmin) / vcount;
-   values = (TwoJetVec **) calloc(ucount+1, sizeof(TwoJetVec *));
-   double *speedv = (double *) calloc(ucount+1, sizeof(double));
-   double **speedu = (double **) calloc(ucount+1, sizeof(double *));
-   for (j = 0; j <= ucount; j++) {
-      u = umin + j*delta_u;
-      values[j] = (TwoJetVec *) calloc(vcount+1, sizeof(TwoJetVec));
-      speedu[j] = (double *) calloc(vcount+1, sizeof(double));
-      speedv[j] = calcSpeedV((*func)(ThreeJet(u, 1, 0), ThreeJet(0, 0, 1), t, numStrips));
-      if (speedv[j] == 0) {
-         /* Perturb a bit, hoping to avoid degeneracy */
-         u += (u < 1) ? 1e-9 : -1e-9;
-         speedv[j] = calcSpeedV((*func)(ThreeJet(u, 1, 0), ThreeJet(0, 0, 1), t, numStrips));
+   double timeWidth = t.width()*(stage.end - stage.start);
+   double minimumWidth = certificationVWidthRatio * fmax(u.width(), timeWidth);
+   std::vector<Interval> failed;
+
+   /* The intervals of v are certified under the frame given by
+      every answer of the comparisons that are undecidable over (u,t) */
+   int undecided = 0;
+   for (unsigned choices = 0; choices < (1u << undecided); ++choices) {
+      bounds::FigureEightFrame frame;
+      {
+         Interval::Branches branches(choices);
+         frame = (*stage.boundedFrameFunc)(bounds::ThreeJet(u, 1, 0), t);
+         if (branches.undecided() > undecided)
+            undecided = branches.undecided();
       }
-      for (k = 0; k <= vcount; k++) {
-         v = vmin + k*delta_v;
-         values[j][k] = (*func)( ThreeJet(u, 1, 0), ThreeJet(v, 0, 1), t, numStrips );
-         speedu[j][k] = calcSpeedU(values[j][k]);
+      if (undecided > maxUndecidedComparisons) {
+         accumulator->boxCount += vs.size();
+         failed = vs;
+         break;
       }
+      for (size_t i = 0; i < vs.size(); ++i)
+         certifyVRecursively(stage, frame, u, vs[i], t,
+            minimumWidth, &failed, accumulator);
    }
 
-   /* quadrilateral mesh code */
-
-   for (j = 0; j <= ucount; ++j)
-      for (k = 0; k <= vcount; ++k) {
-         printMesh(values[j][k],  &geometryMatrix[j][k]);
-      }
+   /* Intervals that failed under several frames are only kept once
+      (they are all from the same bisections of vs, so they either
+      nest or do not overlap) */
+   std::sort(failed.begin(), failed.end(),
+      [](const Interval & a, const Interval & b) {
+         return a.lo < b.lo || (a.lo == b.lo && a.hi > b.hi);
+      });
+   size_t kept = 0;
+   for (size_t i = 0; i < failed.size(); ++i)
+      if (kept == 0 || failed[i].hi > failed[kept-1].hi)
+         failed[kept++] = failed[i];
+   failed.resize(kept);
+
+   if (failed.empty())
+      return;
+   if (depth <= 0) {
+      for (size_t i = 0; i < failed.size(); ++i)
+         accumulateCertifiedBox(stage, u, failed[i], t,
+            false, 0, accumulator);
+      return;
+   }
 
-   /* clean up */
-   for (j = 0; j <= ucount; j++) {
-      free(values[j]);
-      free(speedu[j]);
+   Interval a, b;
+   if (u.width() >= timeWidth) {
+      a = b = u;
+      a.hi = b.lo = u.mid();
+      certifyBoxRecursively(stage, a, failed, t, depth-1, accumulator);
+      certifyBoxRecursively(stage, b, failed, t, depth-1, accumulator);
+   } else {
+      a = b = t;
+      a.hi = b.lo = t.mid();
+      certifyBoxRecursively(stage, u, failed, a, depth-1, accumulator);
+      certifyBoxRecursively(stage, u, failed, b, depth-1, accumulator);
    }
-   free(values);
-   free(speedu);
-   free(speedv);
 }
 
-// ----------------------------------------
-
 /*
    Refer to generateGeometry.h for
    documentation on this function.
 */
-void generateGeometry(
-   GLPoint ** geometryMatrix,
-   double time,
+void certifyImmersion(
+   ImmersionCertificate * certificate,
+   double time_min,
+   double time_max,
    int numStrips,
 
    double u_min,
-   int u_count,
    double u_max,
    double v_min,
-   int v_count,
    double v_max,
 
-   double bendtime,
+   int maxDepth,
+   int threads,
 
    double corrStart,
    double pushStart,
@@ -916,30 +1668,125 @@ void generateGeometry(
    double unpushStart,
    double uncorrStart
 ) {
-   if (NULL == geometryMatrix)
+   /* Each stage is first cut into this many slices of time,
+      so that there are enough boxes to keep every thread busy */
+   const int timeSlicesPerStage = 16;
+
+   BoundedSurfaceFrameFunction * boundedFrameFuncs[5] = {
+      bounds::CorrugateFrame, bounds::PushThroughFrame, bounds::TwistFrame,
+      bounds::UnPushFrame, bounds::UnCorrugateFrame
+   };
+   SurfaceTimeFunction * funcs[5] = {
+      Corrugate, PushThrough, Twist, UnPush, UnCorrugate
+   };
+   double starts[6] = {
+      corrStart, pushStart, twistStart, unpushStart, uncorrStart, 1.0
+   };
+   CertificationStage stages[5];
+   for (int stage = 0; stage < 5; ++stage) {
+      stages[stage].boundedFrameFunc = boundedFrameFuncs[stage];
+      stages[stage].func = funcs[stage];
+      stages[stage].start = starts[stage];
+      stages[stage].end = starts[stage+1];
+      stages[stage].numStrips = numStrips;
+   }
+
+   certificate->isCertified = false;
+   certificate->normalLengthLowerBound = 0;
+   certificate->minimumNormalLength = HUGE_VAL;
+   certificate->minimumU = certificate->minimumV = 0;
+   certificate->minimumTime = 0;
+   certificate->boxCount = certificate->uncertifiedBoxCount = 0;
+   for (int i = 0; i < 3; ++i) {
+      certificate->uncertifiedMin[i] = HUGE_VAL;
+      certificate->uncertifiedMax[i] = -HUGE_VAL;
+   }
+
+   if (u_min > u_max || v_min > v_max || time_min > time_max)
       return;
 
-   if (bendtime >= 0.0) {
-      printScene(BendIn, u_min, u_max, u_count, v_min, v_max, v_count, bendtime, geometryMatrix, numStrips );
-   } else {
+   double * uBreaks = new double[uBreakpointCount + 2];
+   int uBreakCount = splitAtBreakpoints(u_min, u_max,
+      uBreakpoints, uBreakpointCount, uBreaks);
+   double * vBreaks = new double[vBreakCountMax(v_min, v_max)];
+   int vBreakCount = splitAtVBreakpoints(v_min, v_max, vBreaks);
+
+   std::vector<CertificationBox> boxes;
+   for (int stage = 0; stage < 5; ++stage) {
+      double start = starts[stage], end = starts[stage+1];
+      if (time_max < start || time_min >= end || end <= start
+            || (time_min == end && stage < 4))
+         continue;
+      Interval t = (Interval(fmax(time_min, start), fmin(time_max, end))
+         - start) / (end - start);
+      t = Interval(fmax(t.lo, 0), fmin(t.hi, 1));
+      for (int i = 0; i < timeSlicesPerStage; ++i)
+         for (int j = 0; j+1 < uBreakCount; ++j)
+            for (int k = 0; k+1 < vBreakCount; ++k) {
+               CertificationBox box;
+               box.stage = &stages[stage];
+               box.u = Interval(uBreaks[j], uBreaks[j+1]);
+               box.v = Interval(vBreaks[k], vBreaks[k+1]);
+               box.t = Interval(
+                  t.lo + t.width()*i/timeSlicesPerStage,
+                  i+1 == timeSlicesPerStage
+                     ? t.hi : t.lo + t.width()*(i+1)/timeSlicesPerStage
+               );
+               boxes.push_back(box);
+            }
+   }
+   delete [] uBreaks;
+   delete [] vBreaks;
+   if (boxes.empty())
+      return;
 
-      /* time = (time - howfar) / chunk */
+   threads = threadsForParallelFor((int)boxes.size(), threads);
+   std::vector<CertificationAccumulator> accumulators(threads);
+   for (int i = 0; i < threads; ++i) {
+      CertificationAccumulator & accumulator = accumulators[i];
+      accumulator.normalLength = HUGE_VAL;
+      accumulator.minimumNormalLength = HUGE_VAL;
+      accumulator.minimumU = accumulator.minimumV = 0;
+      accumulator.minimumTime = 0;
+      accumulator.boxCount = accumulator.uncertifiedBoxCount = 0;
+      for (int j = 0; j < 3; ++j) {
+         accumulator.uncertifiedMin[j] = HUGE_VAL;
+         accumulator.uncertifiedMax[j] = -HUGE_VAL;
+      }
+   }
 
-      if (time >= uncorrStart)
-         printScene(UnCorrugate, u_min, u_max, u_count, v_min, v_max, v_count,
-		   (time - uncorrStart) / (1.0 - uncorrStart), geometryMatrix, numStrips );
-      else if (time >= unpushStart)
-         printScene(UnPush, u_min, u_max, u_count, v_min, v_max, v_count,
-		   (time - unpushStart) / (uncorrStart - unpushStart), geometryMatrix, numStrips );
-      else if (time >= twistStart)
-         printScene(Twist, u_min, u_max, u_count, v_min, v_max, v_count,
-		   (time - twistStart) / (unpushStart - twistStart), geometryMatrix, numStrips );
-      else if (time >= pushStart)
-         printScene(PushThrough, u_min, u_max, u_count, v_min, v_max, v_count,
-		   (time - pushStart) / (twistStart - pushStart), geometryMatrix, numStrips );
-      else if (time >= corrStart)
-         printScene(Corrugate, u_min, u_max, u_count, v_min, v_max, v_count,
-		   (time - corrStart) / (pushStart - corrStart), geometryMatrix, numStrips );
+   parallelFor((int)boxes.size(), [&](int i, int thread) {
+      const CertificationBox & box = boxes[i];
+      certifyBoxRecursively(*box.stage, box.u,
+         std::vector<Interval>(1, box.v), box.t,
+         maxDepth, &accumulators[thread]);
+   }, threads);
+
+   double lowerBound = HUGE_VAL;
+   for (int i = 0; i < threads; ++i) {
+      const CertificationAccumulator & accumulator = accumulators[i];
+      lowerBound = fmin(lowerBound, accumulator.normalLength);
+      if (accumulator.minimumNormalLength < certificate->minimumNormalLength
+            || (accumulator.minimumNormalLength
+               == certificate->minimumNormalLength
+               && accumulator.minimumTime < certificate->minimumTime)) {
+         certificate->minimumNormalLength = accumulator.minimumNormalLength;
+         certificate->minimumU = accumulator.minimumU;
+         certificate->minimumV = accumulator.minimumV;
+         certificate->minimumTime = accumulator.minimumTime;
+      }
+      certificate->boxCount += accumulator.boxCount;
+      certificate->uncertifiedBoxCount += accumulator.uncertifiedBoxCount;
+      for (int j = 0; j < 3; ++j) {
+         certificate->uncertifiedMin[j] = fmin(
+            certificate->uncertifiedMin[j], accumulator.uncertifiedMin[j]);
+         certificate->uncertifiedMax[j] = fmax(
+            certificate->uncertifiedMax[j], accumulator.uncertifiedMax[j]);
+      }
    }
-}
 
+   if (certificate->uncertifiedBoxCount == 0) {
+      certificate->normalLengthLowerBound = fmax(0, lowerBound);
+      certificate->isCertified = certificate->normalLengthLowerBound > 0;
+   }
+}
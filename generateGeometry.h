@@ -1,4 +1,8 @@
 
+#ifndef GENERATEGEOMETRY_H
+#define GENERATEGEOMETRY_H
+
+
 // GL Points are points on the surface of an object
 // to be rendered.  They have a location (x,y,z) and a
 // normal vector (nx,ny,nz).  Axis conventions:
@@ -13,6 +17,52 @@ struct GLPoint {
 
 typedef GLPoint * GLPointPointer;
 
+// GL Jet Points extend GL Points with the parameters (u,v) at which
+// they were sampled, and with the partial derivatives of their location,
+// for clients that need more than a vertex and normal
+// (e.g. adaptive tessellation, interpolation, texturing, analysis).
+// The leading members have the same layout as a GLPoint,
+// so an array of GLJetPoints can also be passed to OpenGL
+// as a vertex array with a stride of sizeof(GLJetPoint).
+
+struct GLJetPoint {
+
+    float vertex[3],   // location (x,y,z)
+          normal[3];   // normal vector (nx,ny,nz)
+    float u, v;        // parameters of the sample
+    float du[3],       // partial derivative of location with respect to u
+          dv[3],       // partial derivative of location with respect to v
+          duv[3];      // mixed second partial derivative of location
+};
+
+// How the samples are distributed over [u_min,u_max] and [v_min,v_max].
+enum SampleSpacing {
+    SPACING_UNIFORM,     // equal steps in the parameters
+    SPACING_ARC_LENGTH   // approximately equal steps in arc length on the surface,
+                         // so a given number of samples yields evenly sized patches
+};
+
+// How the vertices and normals of a grid of samples are laid out in memory.
+// Interleaved GLPoints suit fixed-function OpenGL. Split streams, one of
+// positions and one of normals, suit code that only reads positions
+// (e.g. bounding, picking, metrics, export), and SIMD loops over them.
+enum VertexLayout {
+    LAYOUT_INTERLEAVED = 1,   // GLPoints
+    LAYOUT_SPLIT       = 2,   // a stream of positions and one of normals
+    LAYOUT_BOTH        = 3    // all three streams
+};
+
+// Where a grid of samples is written: one or more contiguous streams,
+// each holding rows of samples that start rowStride samples apart.
+// Streams that are NULL are not written; positions and normals
+// are either both NULL or both not.
+struct VertexStreams {
+    GLPoint * points;    // interleaved
+    float * positions;   // x,y,z of each sample
+    float * normals;     // nx,ny,nz of each sample
+    int rowStride;       // at least the number of samples in a row
+};
+
 // ----------------------------------------
 
 void generateGeometry(
@@ -34,6 +84,7 @@ void generateGeometry(
    int v_count = 12,     // Recommended value: 12*(v_max-v_min)
    double v_max = 1.0,
 
+   SampleSpacing spacing = SPACING_UNIFORM,
 
    double bendtime = -1.0,   // -1 means don't do bendtime at all
 
@@ -43,3 +94,436 @@ void generateGeometry(
    double unpushStart = 0.60,   // start of unpush (poles held fixed while corrugations pushed through center)
    double uncorrStart = 0.93    // start of uncorrugation
 );
+
+// Same as generateGeometry(), but the samples are written into the
+// given streams (see VertexStreams), in whichever layout they make up.
+// A rowStride greater than 1 + v_count leaves padding after each row,
+// e.g. to start every row on a cache line.
+void generateGeometry(
+   const VertexStreams & streams,  // Must hold (1 + u_count) rows
+
+   double time = 0.0,
+   int numStrips = 8,
+
+   double u_min = 0.0,
+   int u_count = 12,
+   double u_max = 1.0,
+   double v_min = 0.0,
+   int v_count = 12,
+   double v_max = 1.0,
+
+   SampleSpacing spacing = SPACING_UNIFORM,
+
+   double bendtime = -1.0,
+
+   double corrStart   = 0.00,
+   double pushStart   = 0.10,
+   double twistStart  = 0.23,
+   double unpushStart = 0.60,
+   double uncorrStart = 0.93
+);
+
+// Same as above, into a single, interleaved stream.
+void generateGeometry(
+   GLPoint * vertices,  // Must hold (1 + u_count) rows of rowStride elements
+   int rowStride,
+
+   double time = 0.0,
+   int numStrips = 8,
+
+   double u_min = 0.0,
+   int u_count = 12,
+   double u_max = 1.0,
+   double v_min = 0.0,
+   int v_count = 12,
+   double v_max = 1.0,
+
+   SampleSpacing spacing = SPACING_UNIFORM,
+
+   double bendtime = -1.0,
+
+   double corrStart   = 0.00,
+   double pushStart   = 0.10,
+   double twistStart  = 0.23,
+   double unpushStart = 0.60,
+   double uncorrStart = 0.93
+);
+
+// Same as generateGeometry(), but fills in GLJetPoints,
+// in the same pass as the GLPoints.
+// Either of the two matrices may be NULL.
+void generateJetGeometry(
+   GLPoint ** geometryMatrix,  // Must be NULL, or an array of (1 + u_count) arrays of (1 + v_count) elements
+   GLJetPoint ** jetMatrix,    // Must be NULL, or an array of (1 + u_count) arrays of (1 + v_count) elements
+
+   double time = 0.0,
+   int numStrips = 8,
+
+   double u_min = 0.0,
+   int u_count = 12,
+   double u_max = 1.0,
+   double v_min = 0.0,
+   int v_count = 12,
+   double v_max = 1.0,
+
+   SampleSpacing spacing = SPACING_UNIFORM,
+
+   double bendtime = -1.0,
+
+   double corrStart   = 0.00,
+   double pushStart   = 0.10,
+   double twistStart  = 0.23,
+   double unpushStart = 0.60,
+   double uncorrStart = 0.93
+);
+
+// Evaluates the surface at a single point (u,v), e.g. to refine
+// a feature found on a grid of samples by Newton's method.
+// The result is the same as the sample at (u,v) of generateJetGeometry().
+// Returns false (leaving jet unchanged) if no stage is active at the given time.
+bool evaluateSurface(
+   GLJetPoint * jet,
+   double u,
+   double v,
+
+   double time = 0.0,
+   int numStrips = 8,
+
+   double bendtime = -1.0,
+
+   double corrStart   = 0.00,
+   double pushStart   = 0.10,
+   double twistStart  = 0.23,
+   double unpushStart = 0.60,
+   double uncorrStart = 0.93
+);
+
+// The cubic Hermite basis functions at s in [0,1], and their derivatives:
+// the interpolant is h[0]*f(0) + h[1]*f(1) + h[2]*f'(0) + h[3]*f'(1).
+void hermiteBasis(double s, double h[4], double dh[4]);
+
+// Same as generateGeometry(), but the surface is only evaluated exactly
+// on the given grid of (1 + u_count) by (1 + v_count) samples.
+// The partial derivatives at these samples define a bicubic Hermite patch
+// over each patch of the grid, and each of these is evaluated at
+// refinement by refinement points, which is much cheaper than evaluating
+// the surface itself.
+void generateGeometryUpsampled(
+   GLPoint ** geometryMatrix,  // Must be an array of (1 + refinement*u_count) arrays
+                               // of (1 + refinement*v_count) elements
+   int refinement,             // 1 means no upsampling
+
+   double time = 0.0,
+   int numStrips = 8,
+
+   double u_min = 0.0,
+   int u_count = 12,
+   double u_max = 1.0,
+   double v_min = 0.0,
+   int v_count = 12,
+   double v_max = 1.0,
+
+   SampleSpacing spacing = SPACING_UNIFORM,
+
+   double bendtime = -1.0,
+
+   double corrStart   = 0.00,
+   double pushStart   = 0.10,
+   double twistStart  = 0.23,
+   double unpushStart = 0.60,
+   double uncorrStart = 0.93
+);
+
+// Same as generateGeometryUpsampled(), but into the given streams,
+// as with the generateGeometry() that takes streams.
+void generateGeometryUpsampled(
+   const VertexStreams & streams,  // Must hold (1 + refinement*u_count) rows,
+                                   // rowStride >= 1 + refinement*v_count
+   int refinement,
+
+   double time = 0.0,
+   int numStrips = 8,
+
+   double u_min = 0.0,
+   int u_count = 12,
+   double u_max = 1.0,
+   double v_min = 0.0,
+   int v_count = 12,
+   double v_max = 1.0,
+
+   SampleSpacing spacing = SPACING_UNIFORM,
+
+   double bendtime = -1.0,
+
+   double corrStart   = 0.00,
+   double pushStart   = 0.10,
+   double twistStart  = 0.23,
+   double unpushStart = 0.60,
+   double uncorrStart = 0.93
+);
+
+// Same as above, into a single, interleaved stream.
+void generateGeometryUpsampled(
+   GLPoint * vertices,  // Must hold (1 + refinement*u_count) rows
+                        // of rowStride elements
+   int rowStride,       // At least 1 + refinement*v_count
+   int refinement,
+
+   double time = 0.0,
+   int numStrips = 8,
+
+   double u_min = 0.0,
+   int u_count = 12,
+   double u_max = 1.0,
+   double v_min = 0.0,
+   int v_count = 12,
+   double v_max = 1.0,
+
+   SampleSpacing spacing = SPACING_UNIFORM,
+
+   double bendtime = -1.0,
+
+   double corrStart   = 0.00,
+   double pushStart   = 0.10,
+   double twistStart  = 0.23,
+   double unpushStart = 0.60,
+   double uncorrStart = 0.93
+);
+
+// ----------------------------------------
+
+// A tile is a rectangular block of the (1 + u_count) by (1 + v_count)
+// grid of samples computed by generateGeometry().
+// Adjacent tiles share their boundary row (or column) of samples,
+// so that every patch of the grid lies entirely within one tile.
+
+struct GeometryTile {
+    int firstRow, rowCount;        // samples [firstRow, firstRow+rowCount) in u
+    int firstColumn, columnCount;  // samples [firstColumn, firstColumn+columnCount) in v
+
+    // points[j][k] is the sample at row (firstRow+j), column (firstColumn+k).
+    // Only valid for the duration of the call to consumeTile().
+    // NULL unless the sink's vertexLayout() includes LAYOUT_INTERLEAVED.
+    GLPoint ** points;
+
+    // The same samples, split: positions[j][3*k+i] and normals[j][3*k+i].
+    // NULL unless the sink's vertexLayout() includes LAYOUT_SPLIT.
+    float ** positions;
+    float ** normals;
+
+    // Same layout as points; NULL unless the sink needsJets().
+    GLJetPoint ** jets;
+};
+
+// Receives tiles as they are generated, e.g. to write them to a file,
+// reduce them to some statistic, or rasterize them,
+// without ever holding the entire grid in memory.
+class GeometryTileSink {
+public:
+    virtual ~GeometryTileSink() {}
+    virtual bool needsJets() const { return false; }
+    virtual VertexLayout vertexLayout() const { return LAYOUT_INTERLEAVED; }
+    virtual void consumeTile( const GeometryTile & tile ) = 0;
+};
+
+// Same as generateGeometry(), but the surface is generated one tile at a time,
+// in row-major order of tiles, and each tile is handed to the sink.
+// Memory usage is bounded by the size of one tile,
+// i.e. (1 + tileRows) * (1 + tileColumns) GLPoints.
+void generateGeometryTiled(
+   GeometryTileSink * sink,
+   int tileRows,        // patches per tile in u; 0 means all of u_count
+   int tileColumns,     // patches per tile in v; 0 means all of v_count
+
+   double time = 0.0,
+   int numStrips = 8,
+
+   double u_min = 0.0,
+   int u_count = 12,
+   double u_max = 1.0,
+   double v_min = 0.0,
+   int v_count = 12,
+   double v_max = 1.0,
+
+   SampleSpacing spacing = SPACING_UNIFORM,
+
+   double bendtime = -1.0,
+
+   double corrStart   = 0.00,
+   double pushStart   = 0.10,
+   double twistStart  = 0.23,
+   double unpushStart = 0.60,
+   double uncorrStart = 0.93
+);
+
+// Where samples are equally spaced in v, the sines and cosines of v
+// needed by the surface are only computed by the math library
+// for every given number of columns of samples; those of the columns
+// in between are obtained by a recurrence, which is faster,
+// but drifts by a few ulps per column.
+// 1 means always use the math library. Default: 16.
+void setTrigonometricRecurrenceInterval(int columns);
+int getTrigonometricRecurrenceInterval();
+
+// The loops sampling the surface are compiled several times (as kernels),
+// for instruction sets of different widths: "generic", and, on x86 with gcc,
+// "avx2" (with FMA) and "avx512". The most specific kernel supported by the
+// CPU is picked the first time the surface is sampled, unless the
+// environment variable SPHERE_EVERSION_KERNEL names another supported one;
+// the choice is logged to stderr. Kernels may differ in the last bits
+// of their results, where they fuse multiplications with additions.
+
+// Fills in the names of the kernels supported by the CPU, from the most
+// generic to the most specific, and returns how many there are.
+int getGeometryKernels(const char ** names, int maxCount);
+const char * getGeometryKernel();
+// The kernel picked when none is set: the one named by
+// SPHERE_EVERSION_KERNEL if it is supported, else the most specific one.
+const char * getDefaultGeometryKernel();
+// Logs the kernel in use to stderr, with the reason it is used,
+// in the same way as the choice of the default kernel is logged.
+void logGeometryKernel(const char * reason);
+// Returns false, leaving the kernel unchanged, if it is unknown or unsupported.
+// Must not be called while the surface is being sampled.
+bool setGeometryKernel(const char * name);
+
+// generateGeometry(), generateJetGeometry() and generateGeometryUpsampled()
+// split the grid of samples into tiles of at most tileRows by tileColumns
+// samples (0 means all of them), which are spread over the given number
+// of threads (0 means one per core). Default: 1 thread, a single tile.
+// The tiling may change the last bits of the results,
+// since the trigonometric recurrence restarts in each tile.
+// See tuneGeometry() for finding the fastest setting.
+// Must not be called while the surface is being sampled.
+void setSamplingThreads(int threads, int tileRows, int tileColumns);
+void getSamplingThreads(int * threads, int * tileRows, int * tileColumns);
+
+// ----------------------------------------
+
+// Counts of the operations on jets done while evaluating the surface,
+// to see where savings in the algebra would matter.
+// They are only kept if compiled with -DCOUNT_JET_OPERATIONS,
+// which slows down the evaluation considerably.
+
+enum EversionStage {
+    STAGE_BEND_IN, STAGE_CORRUGATE, STAGE_PUSH_THROUGH,
+    STAGE_TWIST, STAGE_UNPUSH, STAGE_UNCORRUGATE,
+    NumEversionStages
+};
+
+enum JetOrder { TWO_JET, THREE_JET, NumJetOrders };
+
+enum JetOperation {
+    JET_ADD,        // +, +=, including with a constant
+    JET_MULTIPLY,   // *, *=, including with a constant
+    JET_SIN,        // Sin() (also with the sine and cosine given)
+    JET_COS,        // Cos() (likewise)
+    JET_POWER,      // ^, ^=
+    JET_FMOD,       // %=
+    NumJetOperations
+};
+
+struct JetOperationCounts {
+    // Counted under the stage that was active when they were done.
+    long count[NumEversionStages][NumJetOrders][NumJetOperations];
+};
+
+// Returns false, and all counts 0, unless the counts are kept.
+// Counts are exact when several threads evaluate the surface at once,
+// provided that they all evaluate it during the same stage.
+bool getJetOperationCounts(JetOperationCounts * counts);
+void resetJetOperationCounts();
+
+// ----------------------------------------
+
+// Guaranteed bounds on the surface over a box of parameters,
+// in the same coordinates as the samples of generateGeometry().
+struct SurfaceBounds {
+    bool isBounded;             // false if the bounds below could not be established,
+                                // in which case the vertex bounds are infinite
+    float vertexMin[3],         // every location (x,y,z) on the surface
+          vertexMax[3];         // lies within [vertexMin,vertexMax]
+    float normalMin[3],         // every (unit) normal vector
+          normalMax[3];         // lies within [normalMin,normalMax]
+    double normalLengthLowerBound;  // lower bound on the length of the cross product
+                                    // of the partial derivatives in u and v;
+                                    // 0 if the surface may be degenerate somewhere in the box
+};
+
+// Bounds the surface over all (u,v) in [u_min,u_max] x [v_min,v_max],
+// and all times in [time_min,time_max], without sampling it.
+// The surface is evaluated in interval arithmetic
+// over boxes of parameters, with each box split where necessary.
+// The bounds are conservative, but not tight:
+// callers wanting tight bounds should bound smaller boxes.
+// Boxes touching a pole (u = 0 or u = 2) usually cannot be bounded,
+// because the frame of the corrugations is degenerate there.
+void boundSurface(
+   SurfaceBounds * surfaceBounds,
+   double time_min,
+   double time_max,
+   int numStrips = 8,
+
+   double u_min = 0.0,
+   double u_max = 1.0,
+   double v_min = 0.0,
+   double v_max = 1.0,
+
+   double bendtime = -1.0,   // if not negative, bound the surface at this bendtime instead
+
+   double corrStart   = 0.00,
+   double pushStart   = 0.10,
+   double twistStart  = 0.23,
+   double unpushStart = 0.60,
+   double uncorrStart = 0.93
+);
+
+// The result of certifyImmersion().
+struct ImmersionCertificate {
+    bool isCertified;               // true if the normal was proven non-zero everywhere
+    double normalLengthLowerBound;  // if so, a lower bound on the length of the cross product
+                                    // of the partial derivatives in u and v; 0 otherwise
+    double minimumNormalLength;     // the shortest such cross product at a sample point,
+    double minimumU, minimumV,      // and where it was found;
+           minimumTime;             // the true minimum lies between the two lengths
+    long boxCount;                  // number of boxes evaluated
+    long uncertifiedBoxCount;       // number of boxes, bisected maxDepth times,
+                                    // over which the normal could not be proven non-zero
+    double uncertifiedMin[3],       // (u,v,time) bounds of those boxes
+           uncertifiedMax[3];
+};
+
+// Proves that the normal computed by printMesh() never vanishes,
+// i.e. that the surface is immersed, for all (u,v) in [u_min,u_max] x [v_min,v_max]
+// and all times in [time_min,time_max], for the given number of strips
+// and stage start times.
+// The parameters are swept with boxes evaluated in interval arithmetic,
+// as in boundSurface(), each box being bisected along its widest side
+// until the normal is proven non-zero over it, or up to maxDepth times.
+// The boxes are spread over the given number of threads (0 means one per core).
+// The whole sphere is covered by u in [0,1] and v in [0,1],
+// but the normal vanishes at the pole (u = 0), where the parametrization
+// is degenerate, so a small cap around it must be left out.
+void certifyImmersion(
+   ImmersionCertificate * certificate,
+   double time_min = 0.0,
+   double time_max = 1.0,
+   int numStrips = 8,
+
+   double u_min = 0.01,
+   double u_max = 1.0,
+   double v_min = 0.0,
+   double v_max = 1.0,
+
+   int maxDepth = 24,
+   int threads = 0,
+
+   double corrStart   = 0.00,
+   double pushStart   = 0.10,
+   double twistStart  = 0.23,
+   double unpushStart = 0.60,
+   double uncorrStart = 0.93
+);
+
+
+#endif /* GENERATEGEOMETRY_H */
@@ -0,0 +1,134 @@
+
+#include "glExtensions.h"
+#ifndef _WIN32
+#include <GL/glx.h>
+#endif
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+
+typedef void (* GLFunction)();
+
+static GLFunction lookUp( const char * name ) {
+#ifdef _WIN32
+   return (GLFunction)wglGetProcAddress( name );
+#else
+   return (GLFunction)glXGetProcAddressARB( (const GLubyte *)name );
+#endif
+}
+
+// Whether the version of the current context is at least major.minor.
+static bool hasVersion( int major, int minor ) {
+   const char * version = (const char *)glGetString( GL_VERSION );
+   int contextMajor = 0, contextMinor = 0;
+   if ( version == NULL
+         || sscanf( version, "%d.%d", &contextMajor, &contextMinor ) != 2 )
+      return false;
+   return contextMajor > major
+      || ( contextMajor == major && contextMinor >= minor );
+}
+
+// Whether the given name is in the list of extensions of the current context.
+static bool hasExtension( const char * name ) {
+   const char * extensions = (const char *)glGetString( GL_EXTENSIONS );
+   if ( extensions == NULL )
+      return false;
+   size_t length = strlen( name );
+   for ( const char * s = strstr( extensions, name ); s != NULL;
+         s = strstr( s + length, name ) )
+      if ( ( s == extensions || s[-1] == ' ' )
+            && ( s[length] == ' ' || s[length] == '\0' ) )
+         return true;
+   return false;
+}
+
+const GLExtensions & glExtensions() {
+   static GLExtensions extensions;
+   static bool lookedUp = false;
+   if ( lookedUp )
+      return extensions;
+   lookedUp = true;
+
+   extensions.GenBuffers = (PFNGLGENBUFFERSPROC)lookUp( "glGenBuffers" );
+   extensions.DeleteBuffers = (PFNGLDELETEBUFFERSPROC)lookUp( "glDeleteBuffers" );
+   extensions.BindBuffer = (PFNGLBINDBUFFERPROC)lookUp( "glBindBuffer" );
+   extensions.BufferData = (PFNGLBUFFERDATAPROC)lookUp( "glBufferData" );
+   extensions.BufferSubData = (PFNGLBUFFERSUBDATAPROC)lookUp( "glBufferSubData" );
+   extensions.hasBufferObjects = hasVersion( 1, 5 )
+      && extensions.GenBuffers != NULL && extensions.DeleteBuffers != NULL
+      && extensions.BindBuffer != NULL && extensions.BufferData != NULL
+      && extensions.BufferSubData != NULL;
+
+   extensions.CreateShader = (PFNGLCREATESHADERPROC)lookUp( "glCreateShader" );
+   extensions.ShaderSource = (PFNGLSHADERSOURCEPROC)lookUp( "glShaderSource" );
+   extensions.CompileShader = (PFNGLCOMPILESHADERPROC)lookUp( "glCompileShader" );
+   extensions.GetShaderiv = (PFNGLGETSHADERIVPROC)lookUp( "glGetShaderiv" );
+   extensions.GetShaderInfoLog
+      = (PFNGLGETSHADERINFOLOGPROC)lookUp( "glGetShaderInfoLog" );
+   extensions.DeleteShader = (PFNGLDELETESHADERPROC)lookUp( "glDeleteShader" );
+   extensions.CreateProgram = (PFNGLCREATEPROGRAMPROC)lookUp( "glCreateProgram" );
+   extensions.AttachShader = (PFNGLATTACHSHADERPROC)lookUp( "glAttachShader" );
+   extensions.LinkProgram = (PFNGLLINKPROGRAMPROC)lookUp( "glLinkProgram" );
+   extensions.GetProgramiv = (PFNGLGETPROGRAMIVPROC)lookUp( "glGetProgramiv" );
+   extensions.GetProgramInfoLog
+      = (PFNGLGETPROGRAMINFOLOGPROC)lookUp( "glGetProgramInfoLog" );
+   extensions.DeleteProgram = (PFNGLDELETEPROGRAMPROC)lookUp( "glDeleteProgram" );
+   extensions.UseProgram = (PFNGLUSEPROGRAMPROC)lookUp( "glUseProgram" );
+   extensions.GetUniformLocation
+      = (PFNGLGETUNIFORMLOCATIONPROC)lookUp( "glGetUniformLocation" );
+   extensions.Uniform1i = (PFNGLUNIFORM1IPROC)lookUp( "glUniform1i" );
+   extensions.Uniform2f = (PFNGLUNIFORM2FPROC)lookUp( "glUniform2f" );
+   extensions.DrawElementsInstanced = (PFNGLDRAWELEMENTSINSTANCEDARBPROC)
+      lookUp( "glDrawElementsInstancedARB" );
+   extensions.hasInstancing = hasVersion( 2, 0 )
+      && hasExtension( "GL_ARB_draw_instanced" )
+      && extensions.CreateShader != NULL && extensions.ShaderSource != NULL
+      && extensions.CompileShader != NULL && extensions.GetShaderiv != NULL
+      && extensions.GetShaderInfoLog != NULL && extensions.DeleteShader != NULL
+      && extensions.CreateProgram != NULL && extensions.AttachShader != NULL
+      && extensions.LinkProgram != NULL && extensions.GetProgramiv != NULL
+      && extensions.GetProgramInfoLog != NULL && extensions.DeleteProgram != NULL
+      && extensions.UseProgram != NULL && extensions.GetUniformLocation != NULL
+      && extensions.Uniform1i != NULL && extensions.Uniform2f != NULL
+      && extensions.DrawElementsInstanced != NULL;
+
+   return extensions;
+}
+
+GLuint buildVertexProgram( const char * vertexShaderSource, FILE * log ) {
+   const GLExtensions & gl = glExtensions();
+   if ( ! gl.hasInstancing )
+      return 0;
+
+   GLint status = 0, length = 0;
+   GLuint shader = gl.CreateShader( GL_VERTEX_SHADER );
+   gl.ShaderSource( shader, 1, &vertexShaderSource, NULL );
+   gl.CompileShader( shader );
+   gl.GetShaderiv( shader, GL_COMPILE_STATUS, &status );
+   if ( ! status ) {
+      gl.GetShaderiv( shader, GL_INFO_LOG_LENGTH, &length );
+      std::vector< GLchar > message( length + 1, '\0' );
+      gl.GetShaderInfoLog( shader, length, NULL, &message[0] );
+      if ( log != NULL )
+         fprintf( log, "Vertex shader not compiled:\n%s\n", &message[0] );
+      gl.DeleteShader( shader );
+      return 0;
+   }
+
+   GLuint program = gl.CreateProgram();
+   gl.AttachShader( program, shader );
+   gl.LinkProgram( program );
+   gl.DeleteShader( shader );   // only flagged, while attached
+   gl.GetProgramiv( program, GL_LINK_STATUS, &status );
+   if ( ! status ) {
+      gl.GetProgramiv( program, GL_INFO_LOG_LENGTH, &length );
+      std::vector< GLchar > message( length + 1, '\0' );
+      gl.GetProgramInfoLog( program, length, NULL, &message[0] );
+      if ( log != NULL )
+         fprintf( log, "Vertex program not linked:\n%s\n", &message[0] );
+      gl.DeleteProgram( program );
+      return 0;
+   }
+   return program;
+}
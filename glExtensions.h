@@ -0,0 +1,58 @@
+
+#ifndef GLEXTENSIONS_H
+#define GLEXTENSIONS_H
+
+
+#include <GL/glut.h>
+#ifdef _WIN32
+#include <GL/glext.h>
+#endif
+#include <stdio.h>
+
+
+// Entry points of OpenGL beyond version 1.1, which are looked up at
+// run time, since the OpenGL library of MS Windows only exports those
+// of version 1.1, and the driver may not support them at all.
+struct GLExtensions {
+   // Buffer objects (OpenGL 1.5)
+   bool hasBufferObjects;
+   PFNGLGENBUFFERSPROC GenBuffers;
+   PFNGLDELETEBUFFERSPROC DeleteBuffers;
+   PFNGLBINDBUFFERPROC BindBuffer;
+   PFNGLBUFFERDATAPROC BufferData;
+   PFNGLBUFFERSUBDATAPROC BufferSubData;
+
+   // Vertex shaders (OpenGL 2.0) drawing instances
+   // (GL_ARB_draw_instanced, with gl_InstanceIDARB in the shader)
+   bool hasInstancing;
+   PFNGLCREATESHADERPROC CreateShader;
+   PFNGLSHADERSOURCEPROC ShaderSource;
+   PFNGLCOMPILESHADERPROC CompileShader;
+   PFNGLGETSHADERIVPROC GetShaderiv;
+   PFNGLGETSHADERINFOLOGPROC GetShaderInfoLog;
+   PFNGLDELETESHADERPROC DeleteShader;
+   PFNGLCREATEPROGRAMPROC CreateProgram;
+   PFNGLATTACHSHADERPROC AttachShader;
+   PFNGLLINKPROGRAMPROC LinkProgram;
+   PFNGLGETPROGRAMIVPROC GetProgramiv;
+   PFNGLGETPROGRAMINFOLOGPROC GetProgramInfoLog;
+   PFNGLDELETEPROGRAMPROC DeleteProgram;
+   PFNGLUSEPROGRAMPROC UseProgram;
+   PFNGLGETUNIFORMLOCATIONPROC GetUniformLocation;
+   PFNGLUNIFORM1IPROC Uniform1i;
+   PFNGLUNIFORM2FPROC Uniform2f;
+   PFNGLDRAWELEMENTSINSTANCEDARBPROC DrawElementsInstanced;
+};
+
+// The entry points, looked up the first time this is called,
+// which must be once there is a current OpenGL context.
+const GLExtensions & glExtensions();
+
+// Compiles and links a program made of the given vertex shader only
+// (fragments are then coloured by the fixed pipeline), and returns it,
+// or returns 0 and logs why to the given file (unless it is NULL).
+// Needs glExtensions().hasInstancing.
+GLuint buildVertexProgram( const char * vertexShaderSource, FILE * log );
+
+
+#endif /* GLEXTENSIONS_H */
@@ -0,0 +1,223 @@
+
+#include "glState.h"
+#include <map>
+#include <string.h>
+
+
+// A tracked piece of state: up to 4 values, and up to 2 modes or names
+// of objects (kept exactly, rather than as floats), under a key made of
+// the function setting it and those of its enumerated arguments that
+// select what is set (a face, light, target or parameter), if any.
+struct StateKey {
+   int function;
+   GLenum arguments[3];
+
+   bool operator<( const StateKey & other ) const {
+      if ( function != other.function )
+         return function < other.function;
+      return memcmp( arguments, other.arguments, sizeof(arguments) ) < 0;
+   }
+};
+struct StateValue {
+   GLfloat values[4];
+   GLuint names[2];
+};
+
+enum StateFunction {
+   function_enable,
+   function_blend_func,
+   function_alpha_func,
+   function_shade_model,
+   function_cull_face,
+   function_front_face,
+   function_polygon_mode,
+   function_line_width,
+   function_material,
+   function_light,
+   function_light_model,
+   function_bind_texture,
+   function_tex_parameter,
+   function_tex_env
+};
+
+static std::map< StateKey, StateValue > state;
+static long callsMade = 0, callsSkipped = 0;
+
+// Records the given values and names under the key, and returns whether
+// the call setting them needs to be made.
+static bool changes(
+   int function, GLenum a0, GLenum a1, GLenum a2,
+   const GLfloat * values, int count, GLuint name0 = 0, GLuint name1 = 0
+) {
+   StateKey key;
+   key.function = function;
+   key.arguments[0] = a0;
+   key.arguments[1] = a1;
+   key.arguments[2] = a2;
+   StateValue value;
+   memset( &value, 0, sizeof(value) );
+   if ( count > 0 )
+      memcpy( value.values, values, count * sizeof(GLfloat) );
+   value.names[0] = name0;
+   value.names[1] = name1;
+
+   std::map< StateKey, StateValue >::iterator known = state.find( key );
+   if ( known != state.end()
+         && memcmp( &known->second, &value, sizeof(value) ) == 0 ) {
+      ++ callsSkipped;
+      return false;
+   }
+   state[ key ] = value;
+   ++ callsMade;
+   return true;
+}
+
+static bool changes( int function, GLenum a0, GLenum a1, GLfloat value ) {
+   return changes( function, a0, a1, 0, &value, 1 );
+}
+
+// Same, for state given by modes or names of objects only.
+static bool changesNames(
+   int function, GLenum a0, GLenum a1, GLuint name0, GLuint name1 = 0
+) {
+   return changes( function, a0, a1, 0, NULL, 0, name0, name1 );
+}
+
+// The number of values of a material, light or light model parameter.
+static int numberOfValues( GLenum name ) {
+   switch ( name ) {
+      case GL_AMBIENT :
+      case GL_DIFFUSE :
+      case GL_SPECULAR :
+      case GL_EMISSION :
+      case GL_AMBIENT_AND_DIFFUSE :
+      case GL_POSITION :
+      case GL_LIGHT_MODEL_AMBIENT :
+         return 4;
+      case GL_SPOT_DIRECTION :
+      case GL_COLOR_INDEXES :
+         return 3;
+      default :
+         return 1;
+   }
+}
+
+void cachedEnable( GLenum capability ) {
+   if ( changes( function_enable, capability, 0, 1.0f ) )
+      glEnable( capability );
+}
+
+void cachedDisable( GLenum capability ) {
+   if ( changes( function_enable, capability, 0, 0.0f ) )
+      glDisable( capability );
+}
+
+void cachedBlendFunc( GLenum source, GLenum destination ) {
+   if ( changesNames( function_blend_func, 0, 0, source, destination ) )
+      glBlendFunc( source, destination );
+}
+
+void cachedAlphaFunc( GLenum function, GLclampf reference ) {
+   if ( changes( function_alpha_func, 0, 0, 0, &reference, 1, function ) )
+      glAlphaFunc( function, reference );
+}
+
+void cachedShadeModel( GLenum mode ) {
+   if ( changesNames( function_shade_model, 0, 0, mode ) )
+      glShadeModel( mode );
+}
+
+void cachedCullFace( GLenum mode ) {
+   if ( changesNames( function_cull_face, 0, 0, mode ) )
+      glCullFace( mode );
+}
+
+void cachedFrontFace( GLenum mode ) {
+   if ( changesNames( function_front_face, 0, 0, mode ) )
+      glFrontFace( mode );
+}
+
+void cachedPolygonMode( GLenum face, GLenum mode ) {
+   // GL_FRONT_AND_BACK sets both faces.
+   bool front = face != GL_BACK
+      && changesNames( function_polygon_mode, GL_FRONT, 0, mode );
+   bool back = face != GL_FRONT
+      && changesNames( function_polygon_mode, GL_BACK, 0, mode );
+   if ( front || back )
+      glPolygonMode( face, mode );
+}
+
+void cachedLineWidth( GLfloat width ) {
+   if ( changes( function_line_width, 0, 0, width ) )
+      glLineWidth( width );
+}
+
+void cachedMaterialfv( GLenum face, GLenum name, const GLfloat * values ) {
+   // GL_FRONT_AND_BACK sets both faces,
+   // and GL_AMBIENT_AND_DIFFUSE both parameters.
+   int count = numberOfValues( name );
+   bool changed = false;
+   for ( int f = 0; f < 2; ++f ) {
+      GLenum side = f == 0 ? GL_FRONT : GL_BACK;
+      if ( face != GL_FRONT_AND_BACK && face != side )
+         continue;
+      if ( name == GL_AMBIENT_AND_DIFFUSE ) {
+         changed |= changes( function_material, side, GL_AMBIENT, 0, values, count );
+         changed |= changes( function_material, side, GL_DIFFUSE, 0, values, count );
+      }
+      else
+         changed |= changes( function_material, side, name, 0, values, count );
+   }
+   if ( changed )
+      glMaterialfv( face, name, values );
+}
+
+void cachedLightfv( GLenum light, GLenum name, const GLfloat * values ) {
+   if ( name == GL_POSITION || name == GL_SPOT_DIRECTION ) {
+      ++ callsMade;
+      glLightfv( light, name, values );
+   }
+   else if ( changes( function_light, light, name, 0, values, numberOfValues( name ) ) )
+      glLightfv( light, name, values );
+}
+
+void cachedLightModelfv( GLenum name, const GLfloat * values ) {
+   if ( changes( function_light_model, name, 0, 0, values, numberOfValues( name ) ) )
+      glLightModelfv( name, values );
+}
+
+// The texture bound to the target, under which its parameters are kept.
+static GLuint boundTexture( GLenum target ) {
+   StateKey key = { function_bind_texture, { target, 0, 0 } };
+   std::map< StateKey, StateValue >::const_iterator known = state.find( key );
+   return known != state.end() ? known->second.names[0] : 0;
+}
+
+void cachedBindTexture( GLenum target, GLuint texture ) {
+   if ( changesNames( function_bind_texture, target, 0, texture ) )
+      glBindTexture( target, texture );
+}
+
+void cachedTexParameteri( GLenum target, GLenum name, GLint value ) {
+   if ( changes( function_tex_parameter, target, boundTexture( target ), name,
+         NULL, 0, (GLuint)value ) )
+      glTexParameteri( target, name, value );
+}
+
+void cachedTexEnvi( GLenum target, GLenum name, GLint value ) {
+   if ( changesNames( function_tex_env, target, name, (GLuint)value ) )
+      glTexEnvi( target, name, value );
+}
+
+void forgetGLState() {
+   state.clear();
+}
+
+void getGLStateCounts( long * made, long * skipped ) {
+   *made = callsMade;
+   *skipped = callsSkipped;
+}
+
+void resetGLStateCounts() {
+   callsMade = callsSkipped = 0;
+}
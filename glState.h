@@ -0,0 +1,43 @@
+
+#ifndef GLSTATE_H
+#define GLSTATE_H
+
+
+#include <GL/glut.h>
+
+
+// Versions of the OpenGL calls setting state that skip the call when
+// the state already has the value given, as last set through them,
+// and count the calls made and skipped (e.g. to show them per frame).
+// State not set through them yet is unknown, so the first call is made.
+// Any code changing a piece of state tracked here must go through these,
+// or else call forgetGLState() afterwards.
+// Light positions and directions are never skipped, since OpenGL
+// transforms them by the modelview matrix current when they are set.
+// Texture parameters are tracked per texture object bound to the target.
+
+void cachedEnable( GLenum capability );
+void cachedDisable( GLenum capability );
+void cachedBlendFunc( GLenum source, GLenum destination );
+void cachedAlphaFunc( GLenum function, GLclampf reference );
+void cachedShadeModel( GLenum mode );
+void cachedCullFace( GLenum mode );
+void cachedFrontFace( GLenum mode );
+void cachedPolygonMode( GLenum face, GLenum mode );
+void cachedLineWidth( GLfloat width );
+void cachedMaterialfv( GLenum face, GLenum name, const GLfloat * values );
+void cachedLightfv( GLenum light, GLenum name, const GLfloat * values );
+void cachedLightModelfv( GLenum name, const GLfloat * values );
+void cachedBindTexture( GLenum target, GLuint texture );
+void cachedTexParameteri( GLenum target, GLenum name, GLint value );
+void cachedTexEnvi( GLenum target, GLenum name, GLint value );
+
+// Forgets all the state tracked, so that the next calls are all made.
+void forgetGLState();
+
+// The number of calls made and skipped since the counts were last reset.
+void getGLStateCounts( long * callsMade, long * callsSkipped );
+void resetGLStateCounts();
+
+
+#endif /* GLSTATE_H */
@@ -0,0 +1,193 @@
+
+#include "gridIndices.h"
+#include <math.h>
+#include <algorithm>
+
+
+void appendGridTriangles(
+   std::vector< unsigned int > & indices,
+   int rows, int columns, int rowStride,
+   int firstRow
+) {
+   for ( int j = firstRow; j < rows; ++j )
+      for ( int k = 0; k < columns; ++k ) {
+         unsigned int a = j * rowStride + k;
+         unsigned int b = a + rowStride;
+         unsigned int c = a + 1;
+         unsigned int d = b + 1;
+         unsigned int triangles[6] = { a, b, c, c, b, d };
+         indices.insert( indices.end(), triangles, triangles + 6 );
+      }
+}
+
+void appendGridSamples(
+   std::vector< unsigned int > & indices,
+   int rows, int columns, int rowStride
+) {
+   for ( int j = 0; j <= rows; ++j )
+      for ( int k = 0; k <= columns; ++k )
+         indices.push_back( j * rowStride + k );
+}
+
+void appendGridTextureCoordinates(
+   std::vector< float > & textureCoordinates,
+   int rows, int columns, int rowStride
+) {
+   for ( int j = 0; j <= rows; ++j )
+      for ( int k = 0; k < rowStride; ++k ) {
+         textureCoordinates.push_back( k <= columns ? k : 0 );
+         textureCoordinates.push_back( k <= columns ? j : 0 );
+      }
+}
+
+// The parameters of Forsyth's scoring.
+const int OptimizedCacheSize = 32;
+const float CacheDecayPower = 1.5f;
+const float LastTriangleScore = 0.75f;
+const float ValenceBoostScale = 2.0f;
+const float ValenceBoostPower = 0.5f;
+
+static float vertexScore( int cachePosition, int remainingTriangles ) {
+   if ( remainingTriangles == 0 )
+      return -1.0f;   // no triangle needs it anymore
+   float score = 0;
+   if ( cachePosition >= 0 ) {
+      if ( cachePosition < 3 )
+         // the vertices of the last triangle score the same, whatever
+         // their order, so that it does not matter which one comes next
+         score = LastTriangleScore;
+      else
+         score = powf(
+            1.0f - float( cachePosition - 3 ) / ( OptimizedCacheSize - 3 ),
+            CacheDecayPower
+         );
+   }
+   return score
+      + ValenceBoostScale * powf( (float)remainingTriangles, -ValenceBoostPower );
+}
+
+void optimizeVertexCache(
+   std::vector< unsigned int > & indices,
+   unsigned int vertexCount
+) {
+   size_t triangleCount = indices.size() / 3;
+   if ( triangleCount == 0 )
+      return;
+   size_t t, i;
+
+   // The triangles of each vertex not emitted yet, those of vertex v being
+   // vertexTriangles[ firstTriangle[v] ... firstTriangle[v]+remaining[v] ).
+   std::vector< int > remaining( vertexCount, 0 );
+   for ( i = 0; i < 3 * triangleCount; ++i )
+      ++ remaining[ indices[i] ];
+   std::vector< size_t > firstTriangle( vertexCount + 1, 0 );
+   for ( unsigned int v = 0; v < vertexCount; ++v )
+      firstTriangle[v + 1] = firstTriangle[v] + remaining[v];
+   std::vector< unsigned int > vertexTriangles( 3 * triangleCount );
+   std::fill( remaining.begin(), remaining.end(), 0 );
+   for ( t = 0; t < triangleCount; ++t )
+      for ( i = 0; i < 3; ++i ) {
+         unsigned int v = indices[3*t + i];
+         vertexTriangles[ firstTriangle[v] + remaining[v]++ ] = (unsigned int)t;
+      }
+
+   std::vector< int > cachePosition( vertexCount, -1 );
+   std::vector< float > score( vertexCount );
+   for ( unsigned int v = 0; v < vertexCount; ++v )
+      score[v] = vertexScore( -1, remaining[v] );
+   std::vector< float > triangleScore( triangleCount );
+   for ( t = 0; t < triangleCount; ++t )
+      triangleScore[t] = score[ indices[3*t] ] + score[ indices[3*t + 1] ]
+         + score[ indices[3*t + 2] ];
+
+   std::vector< bool > isEmitted( triangleCount, false );
+   std::vector< unsigned int > reordered;
+   reordered.reserve( indices.size() );
+   std::vector< unsigned int > cache, newCache;
+   cache.reserve( OptimizedCacheSize + 3 );
+   newCache.reserve( OptimizedCacheSize + 3 );
+
+   size_t nextUnemitted = 0;   // where to look when the cache gives nothing
+   long best = -1;
+   while ( reordered.size() < indices.size() ) {
+      if ( best < 0 ) {
+         while ( isEmitted[ nextUnemitted ] )
+            ++ nextUnemitted;
+         best = (long)nextUnemitted;
+      }
+
+      // Emit it, and put its vertices at the front of the cache.
+      isEmitted[best] = true;
+      newCache.clear();
+      for ( i = 0; i < 3; ++i ) {
+         unsigned int v = indices[3*best + i];
+         reordered.push_back( v );
+         newCache.push_back( v );
+         unsigned int * triangles = &vertexTriangles[ firstTriangle[v] ];
+         for ( int k = 0; k < remaining[v]; ++k )
+            if ( triangles[k] == (unsigned int)best ) {
+               triangles[k] = triangles[ --remaining[v] ];
+               break;
+            }
+      }
+      for ( i = 0; i < cache.size(); ++i ) {
+         unsigned int v = cache[i];
+         if ( v != newCache[0] && v != newCache[1] && v != newCache[2] )
+            newCache.push_back( v );
+      }
+      for ( i = OptimizedCacheSize; i < newCache.size(); ++i ) {
+         cachePosition[ newCache[i] ] = -1;
+         score[ newCache[i] ] = vertexScore( -1, remaining[ newCache[i] ] );
+      }
+      if ( newCache.size() > (size_t)OptimizedCacheSize )
+         newCache.resize( OptimizedCacheSize );
+      cache.swap( newCache );
+
+      // Update the scores of the vertices in the cache and of their
+      // triangles, the best of which comes next.
+      for ( i = 0; i < cache.size(); ++i ) {
+         cachePosition[ cache[i] ] = (int)i;
+         score[ cache[i] ] = vertexScore( (int)i, remaining[ cache[i] ] );
+      }
+      best = -1;
+      float bestScore = -1;
+      for ( i = 0; i < cache.size(); ++i ) {
+         unsigned int v = cache[i];
+         const unsigned int * triangles = &vertexTriangles[ firstTriangle[v] ];
+         for ( int k = 0; k < remaining[v]; ++k ) {
+            unsigned int u = triangles[k];
+            triangleScore[u] = score[ indices[3*u] ] + score[ indices[3*u + 1] ]
+               + score[ indices[3*u + 2] ];
+            if ( triangleScore[u] > bestScore ) {
+               bestScore = triangleScore[u];
+               best = u;
+            }
+         }
+      }
+   }
+   indices.swap( reordered );
+}
+
+double averageCacheMissRatio(
+   const std::vector< unsigned int > & indices,
+   int cacheSize
+) {
+   if ( indices.size() < 3 )
+      return 0;
+   // A vertex is in the FIFO if it was last loaded
+   // fewer than cacheSize misses ago.
+   unsigned int vertexCount = 0;
+   for ( size_t i = 0; i < indices.size(); ++i )
+      if ( indices[i] >= vertexCount )
+         vertexCount = indices[i] + 1;
+   std::vector< long > loadedAt( vertexCount, -1 );
+   long misses = 0;
+   for ( size_t i = 0; i < indices.size(); ++i ) {
+      long & loaded = loadedAt[ indices[i] ];
+      if ( loaded < 0 || misses - loaded >= cacheSize ) {
+         loaded = misses;
+         ++ misses;
+      }
+   }
+   return (double)misses / ( indices.size() / 3 );
+}
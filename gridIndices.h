@@ -0,0 +1,63 @@
+
+#ifndef GRIDINDICES_H
+#define GRIDINDICES_H
+
+
+#include <vector>
+
+
+// Indices, into a grid of (1 + rows) by (1 + columns) samples whose rows
+// start rowStride samples apart (as in the vertex streams of
+// generateGeometry()), of what is drawn of one strip, for drawing
+// with glDrawElements() instead of one call per sample.
+// Patch (j,k) is split into the triangles (j,k),(j+1,k),(j,k+1) and
+// (j,k+1),(j+1,k),(j+1,k+1), the same triangles, in the same order and
+// orientation, as the triangle strips along each row of patches.
+
+// Appends the triangles of the patches in rows firstRow ... rows-1 of patches.
+void appendGridTriangles(
+   std::vector< unsigned int > & indices,
+   int rows, int columns, int rowStride,
+   int firstRow = 0
+);
+
+// Appends every sample of the grid, row by row (to draw them as points).
+void appendGridSamples(
+   std::vector< unsigned int > & indices,
+   int rows, int columns, int rowStride
+);
+
+// Appends the texture coordinates (s,t) = (k,j) of each sample (j,k) of
+// the grid, two floats per sample, rowStride samples per row (those past
+// the last column are 0), so that a texture repeating every n samples
+// (under a texture matrix scaling by 1/n) lays a pattern on the patches.
+void appendGridTextureCoordinates(
+   std::vector< float > & textureCoordinates,
+   int rows, int columns, int rowStride
+);
+
+// Reorders the triangles given by indices (3 per triangle, into
+// vertexCount vertices) so that the vertices transformed for a triangle
+// are reused by the following ones from the GPU's post-transform cache,
+// with Tom Forsyth's linear-speed vertex cache optimisation: triangles
+// are emitted one at a time, each time the one whose vertices score
+// best, where vertices score more the more recently they were used
+// (in a simulated cache of 32 vertices) and the fewer triangles they
+// have left, so as not to leave stragglers behind.
+// The orientation of each triangle is kept.
+void optimizeVertexCache(
+   std::vector< unsigned int > & indices,
+   unsigned int vertexCount
+);
+
+// The average cache miss ratio (ACMR) of drawing the triangles given by
+// indices: the number of vertices transformed per triangle, with a FIFO
+// post-transform cache of cacheSize vertices. It is 3 with no reuse at
+// all, and tends to 0.5 for a large grid drawn in the best order.
+double averageCacheMissRatio(
+   const std::vector< unsigned int > & indices,
+   int cacheSize = 16
+);
+
+
+#endif /* GRIDINDICES_H */
@@ -0,0 +1,294 @@
+
+#ifndef INTERVAL_H
+#define INTERVAL_H
+
+
+#include <math.h>
+#include <string.h>
+
+
+// A closed interval [lo,hi] of reals, with arithmetic that is
+// rounded outward, so that the result of every operation
+// contains every value the operation could produce
+// on reals taken from its operands.
+// Used as the scalar type of the jets in evertSurface.h,
+// to bound the surface over a box of parameters
+// rather than evaluating it at a single point.
+//
+// Comparisons with a double can be undecidable,
+// i.e. when the interval reaches past the double.
+// In that case they answer as the midpoint of the interval would
+// (or as told by an Interval::Branches, see below),
+// and increment Interval::indeterminateCount(),
+// so the caller knows the result is not to be trusted
+// (and should, for example, split the box and try again).
+// An interval that only touches the double at an endpoint
+// is considered to be on the side of its other endpoint.
+// The answer is then wrong at the endpoint itself, but that point
+// is also covered by the neighbouring box, beyond the breakpoint,
+// where it is answered correctly (boxes are split at the breakpoints
+// of the piecewise functions in evertSurface.h).
+// Pieces of those functions only meet continuously in value,
+// not in every derivative, so nothing looser than that is safe.
+
+class Interval {
+public:
+   double lo, hi;
+
+   Interval() { lo = hi = 0; }
+   Interval( double x ) {
+      if ( x == x ) lo = hi = x;
+      else { lo = -HUGE_VAL; hi = HUGE_VAL; }
+   }
+   Interval( double a, double b ) {
+      if ( a == a && b == b ) { lo = a; hi = b; }
+      else { lo = -HUGE_VAL; hi = HUGE_VAL; }
+   }
+
+   double mid() const { return 0.5*lo + 0.5*hi; }
+   double width() const { return hi - lo; }
+   bool isFinite() const { return -HUGE_VAL < lo && hi < HUGE_VAL; }
+   bool contains( double x ) const { return lo <= x && x <= hi; }
+
+   // Rounds a to the next double down, or up.
+   static double down( double a ) { return -up( -a ); }
+   static double up( double a ) {
+      if ( a != a || a == HUGE_VAL ) return a;
+      if ( a == 0 ) return 4.9406564584124654e-324;   // smallest denormal
+      long long bits;
+      memcpy( &bits, &a, sizeof(bits) );
+      bits += a > 0 ? 1 : -1;
+      memcpy( &a, &bits, sizeof(bits) );
+      return a;
+   }
+
+   // Lower and upper bounds on a+b and a*b.
+   // These are only rounded when the operation was inexact
+   // (the rounding error is recovered exactly, with TwoSum and fma),
+   // so that e.g. sums and products of zeros stay exactly zero.
+   static double sumDown( double a, double b ) {
+      double s = a + b, bb = s - a, error = ( a - ( s - bb ) ) + ( b - bb );
+      return error == 0 || error > 0 ? s : down( s );
+   }
+   static double sumUp( double a, double b ) {
+      double s = a + b, bb = s - a, error = ( a - ( s - bb ) ) + ( b - bb );
+      return error == 0 || error < 0 ? s : up( s );
+   }
+   static double productDown( double a, double b ) {
+      double p = a * b, error = fma( a, b, -p );
+      return ( error == 0 || error > 0 ) && ! ( fabs( p ) < 1e-290 ) ? p : down( p );
+   }
+   static double productUp( double a, double b ) {
+      double p = a * b, error = fma( a, b, -p );
+      return ( error == 0 || error < 0 ) && ! ( fabs( p ) < 1e-290 ) ? p : up( p );
+   }
+
+   // Number of undecidable comparisons made by the calling thread.
+   static unsigned long & indeterminateCount() {
+      static thread_local unsigned long count = 0;
+      return count;
+   }
+
+   class Branches;
+
+   bool operator<( double d ) const {
+      if ( hi <= d ) return true;
+      if ( lo >= d ) return false;
+      return undecided( mid() < d );
+   }
+   bool operator>( double d ) const {
+      if ( lo >= d ) return true;
+      if ( hi <= d ) return false;
+      return undecided( mid() > d );
+   }
+   bool operator<=( double d ) const { return *this < d; }
+   bool operator>=( double d ) const { return *this > d; }
+
+   Interval operator-() const { return Interval( -hi, -lo ); }
+
+   void operator+=( const Interval & x );
+   void operator*=( const Interval & x );
+
+private:
+   static Branches * & activeBranches() {
+      static thread_local Branches * branches = NULL;
+      return branches;
+   }
+   // Counts an undecidable comparison, and returns its answer.
+   static bool undecided( bool midpointAnswer );
+};
+
+// While a Branches is alive, the i-th undecidable comparison made
+// by the calling thread answers bit i of the given choices.
+// Evaluating a function once for each choice of answers,
+// up to 2^undecided(), then covers every piece the function
+// could use anywhere over the box, even where rounding leaves
+// a box reaching a little past a breakpoint:
+// the results over the box are contained in the hull of the results.
+class Interval::Branches {
+public:
+   explicit Branches( unsigned choices ) : choices( choices ) {
+      first = indeterminateCount();
+      previous = activeBranches();
+      activeBranches() = this;
+   }
+   ~Branches() { activeBranches() = previous; }
+
+   // Number of undecidable comparisons made so far.
+   int undecided() const { return (int)( indeterminateCount() - first ); }
+
+private:
+   friend class Interval;
+   unsigned choices;
+   unsigned long first;
+   Branches * previous;
+};
+
+inline bool Interval::undecided( bool midpointAnswer ) {
+   unsigned long i = indeterminateCount() ++;
+   const Branches * branches = activeBranches();
+   if ( branches == NULL || i - branches->first >= 32 )
+      return midpointAnswer;
+   return ( branches->choices >> ( i - branches->first ) ) & 1;
+}
+
+inline Interval operator+( const Interval & x, const Interval & y ) {
+   return Interval( Interval::sumDown( x.lo, y.lo ), Interval::sumUp( x.hi, y.hi ) );
+}
+inline Interval operator-( const Interval & x, const Interval & y ) {
+   return Interval( Interval::sumDown( x.lo, -y.hi ), Interval::sumUp( x.hi, -y.lo ) );
+}
+inline Interval operator*( const Interval & x, const Interval & y ) {
+   // An operand that is exactly zero gives exactly zero,
+   // even against an unbounded operand: in evertSurface.h,
+   // unbounded intervals only stand in for values that are finite
+   // but could not be bounded (e.g. a normalized zero vector).
+   if ( ( x.lo == 0 && x.hi == 0 ) || ( y.lo == 0 && y.hi == 0 ) )
+      return Interval( 0 );
+   double a = x.lo*y.lo, b = x.lo*y.hi, c = x.hi*y.lo, d = x.hi*y.hi;
+   if ( a != a || b != b || c != c || d != d )
+      return Interval( -HUGE_VAL, HUGE_VAL );
+   // Only the smallest and largest products need to be rounded
+   // (all of them, where several round to the same value).
+   double pLo = fmin( fmin( a, b ), fmin( c, d ) );
+   double pHi = fmax( fmax( a, b ), fmax( c, d ) );
+   double lo = HUGE_VAL, hi = -HUGE_VAL;
+   if ( a == pLo ) lo = fmin( lo, Interval::productDown( x.lo, y.lo ) );
+   if ( b == pLo ) lo = fmin( lo, Interval::productDown( x.lo, y.hi ) );
+   if ( c == pLo ) lo = fmin( lo, Interval::productDown( x.hi, y.lo ) );
+   if ( d == pLo ) lo = fmin( lo, Interval::productDown( x.hi, y.hi ) );
+   if ( a == pHi ) hi = fmax( hi, Interval::productUp( x.lo, y.lo ) );
+   if ( b == pHi ) hi = fmax( hi, Interval::productUp( x.lo, y.hi ) );
+   if ( c == pHi ) hi = fmax( hi, Interval::productUp( x.hi, y.lo ) );
+   if ( d == pHi ) hi = fmax( hi, Interval::productUp( x.hi, y.hi ) );
+   return Interval( lo, hi );
+}
+inline Interval operator/( const Interval & x, const Interval & y ) {
+   if ( y.lo <= 0 && y.hi >= 0 )
+      return Interval( -HUGE_VAL, HUGE_VAL );
+   return x * Interval( Interval::down( 1/y.hi ), Interval::up( 1/y.lo ) );
+}
+inline void Interval::operator+=( const Interval & x ) { *this = *this + x; }
+inline void Interval::operator*=( const Interval & x ) { *this = *this * x; }
+
+inline Interval operator+( const Interval & x, double d ) { return x + Interval( d ); }
+inline Interval operator+( double d, const Interval & x ) { return x + Interval( d ); }
+inline Interval operator-( const Interval & x, double d ) { return x - Interval( d ); }
+inline Interval operator-( double d, const Interval & x ) { return Interval( d ) - x; }
+inline Interval operator*( const Interval & x, double d ) { return x * Interval( d ); }
+inline Interval operator*( double d, const Interval & x ) { return x * Interval( d ); }
+inline Interval operator/( const Interval & x, double d ) { return x / Interval( d ); }
+inline Interval operator/( double d, const Interval & x ) { return Interval( d ) / x; }
+
+// Returns the smallest interval containing both x and y.
+inline Interval hull( const Interval & x, const Interval & y ) {
+   return Interval( fmin( x.lo, y.lo ), fmax( x.hi, y.hi ) );
+}
+
+// Returns true if x is in [lo,hi] modulo 2*pi.
+// Errs on the side of returning true.
+inline bool containsAngle( double lo, double hi, double x ) {
+   if ( hi - lo >= 2*M_PI ) return true;
+   double k = ceil( ( lo - x ) / ( 2*M_PI ) - 1e-9 );
+   return x + k*2*M_PI <= hi + 1e-9*( 1 + fabs( hi ) );
+}
+
+// Results of the library functions are assumed to be within an ulp,
+// so they are rounded outward by one step on each side.
+inline Interval sin( const Interval & x ) {
+   if ( ! x.isFinite() ) return Interval( -1, 1 );
+   double a = sin( x.lo ), b = sin( x.hi );
+   double lo = Interval::down( fmin( a, b ) ), hi = Interval::up( fmax( a, b ) );
+   if ( containsAngle( x.lo, x.hi, M_PI/2 ) ) hi = 1;
+   if ( containsAngle( x.lo, x.hi, -M_PI/2 ) ) lo = -1;
+   return Interval( fmax( lo, -1 ), fmin( hi, 1 ) );
+}
+inline Interval cos( const Interval & x ) {
+   if ( ! x.isFinite() ) return Interval( -1, 1 );
+   double a = cos( x.lo ), b = cos( x.hi );
+   double lo = Interval::down( fmin( a, b ) ), hi = Interval::up( fmax( a, b ) );
+   if ( containsAngle( x.lo, x.hi, 0 ) ) hi = 1;
+   if ( containsAngle( x.lo, x.hi, M_PI ) ) lo = -1;
+   return Interval( fmax( lo, -1 ), fmin( hi, 1 ) );
+}
+
+inline Interval pow( const Interval & x, double n ) {
+   if ( n == 0 ) return Interval( 1 );
+   if ( n == floor( n ) && fabs( n ) < 64 ) {
+      int k = (int)n;
+      if ( k < 0 ) {
+         if ( x.lo <= 0 && x.hi >= 0 ) return Interval( -HUGE_VAL, HUGE_VAL );
+         return 1 / pow( x, -n );
+      }
+      double a = pow( x.lo, n ), b = pow( x.hi, n );
+      if ( k % 2 == 1 )
+         return Interval( Interval::down( a ), Interval::up( b ) );
+      if ( x.lo >= 0 )
+         return Interval( Interval::down( a ), Interval::up( b ) );
+      if ( x.hi <= 0 )
+         return Interval( Interval::down( b ), Interval::up( a ) );
+      return Interval( 0, Interval::up( fmax( a, b ) ) );
+   }
+   // Non-integer powers are only defined for non-negative numbers.
+   if ( x.lo < 0 ) return Interval( -HUGE_VAL, HUGE_VAL );
+   double a = pow( x.lo, n ), b = pow( x.hi, n );
+   if ( n > 0 )
+      return Interval( fmax( Interval::down( a ), 0 ), Interval::up( b ) );
+   return Interval( fmax( Interval::down( b ), 0 ), Interval::up( a ) );
+}
+
+// Returns x modulo d (for d > 0), in [0,d].
+// Where x lies in a single period, its upper endpoint may touch
+// the start of the next period; the result then ends at d
+// rather than wrapping around to 0,
+// which is safe for the periodic functions in evertSurface.h.
+inline Interval fmod( const Interval & x, double d ) {
+   if ( ! x.isFinite() ) return Interval( 0, d );
+   double k = floor( x.lo / d );
+   if ( k == 0 && x.hi <= d ) return x;
+   if ( x.hi - k*d > d ) return Interval( 0, d );
+   return Interval(
+      fmax( Interval::down( x.lo - k*d ), 0 ),
+      fmin( Interval::up( x.hi - k*d ), d )
+   );
+}
+
+// Sets xi to the i-th derivative of f^n.
+inline void PowerDerivatives(
+   const Interval & f, double n,
+   Interval & x0, Interval & x1, Interval & x2, Interval & x3
+) {
+   x0 = pow( f, n );
+   x1 = n == 0 ? Interval( 0 ) : n * pow( f, n-1 );
+   x2 = n*(n-1) == 0 ? Interval( 0 ) : n*(n-1) * pow( f, n-2 );
+   x3 = n*(n-1)*(n-2) == 0 ? Interval( 0 ) : n*(n-1)*(n-2) * pow( f, n-3 );
+   if ( f.contains( 0 ) ) {
+      // evertSurface.h takes the derivatives of f^n at 0 to be 0.
+      x1 = hull( x1, Interval( 0 ) );
+      x2 = hull( x2, Interval( 0 ) );
+      x3 = hull( x3, Interval( 0 ) );
+   }
+}
+
+
+#endif /* INTERVAL_H */
@@ -13,12 +13,25 @@
 */
 
 #include "generateGeometry.h"
+#include "tuneGeometry.h"
+#include "packedGeometry.h"
+#include "gridIndices.h"
+#include "glExtensions.h"
+#include "glState.h"
+#include "surfaceMesh.h"
+#include "doubleCurve.h"
+#include "crossSection.h"
+#include "silhouette.h"
 #include "Camera.h"
 #include "drawutil.h"
 #include "drawutil2D.h"
 
 #include <GL/glut.h>
 #include <cstring>
+#include <cstddef>
+#include <map>
+#include <deque>
+#include <algorithm>
 
 Camera * camera = 0;
 
@@ -39,8 +52,19 @@ bool flipFrontFaces = true;
 bool drawWorldAxes = true;
 bool drawTarget = false;
 bool displayText = true;
+bool drawDoubleCurve = false;
+bool drawCrossSection = false;
+bool drawSilhouette = false;
 double deltaTime = 1.0/256;
 bool showHalfStrips = false;
+bool useArcLengthSpacing = false;
+const int hermiteUpsamplingRefinement = 4;
+bool useHermiteUpsampling = false;
+bool useFrameCache = true;
+bool useVertexBuffers = true;
+bool useInstancing = true;
+bool useFrustumCulling = true;
+const size_t maximumFrameCacheBytes = 64 << 20;
 const int defaultNumStrips = 8;
 const int defaultNumberOfLatitudinalPatchesPerHemisphere = 12;
 const int defaultNumberOfLongitudinalPatchesPerStrip = 12;
@@ -65,6 +89,9 @@ int mouse_x, mouse_y;
 #define MI_TOGGLE_DISPLAY_OF_WORLD_SPACE_AXES 21
 #define MI_TOGGLE_DISPLAY_OF_CAMERA_TARGET 22
 #define MI_TOGGLE_DISPLAY_OF_TEXT 23
+#define MI_TOGGLE_DISPLAY_OF_DOUBLE_CURVE 24
+#define MI_TOGGLE_DISPLAY_OF_CROSS_SECTION 25
+#define MI_TOGGLE_DISPLAY_OF_SILHOUETTE 26
 #define MI_INCREMENT_TIME 31
 #define MI_DECREMENT_TIME 32
 #define MI_DOUBLE_TIME_STEP 33
@@ -79,6 +106,12 @@ int mouse_x, mouse_y;
 #define MI_DECREMENT_LATITUDINAL_RESOLUTION 52
 #define MI_INCREMENT_LONGITUDINAL_RESOLUTION 53
 #define MI_DECREMENT_LONGITUDINAL_RESOLUTION 54
+#define MI_TOGGLE_ARC_LENGTH_SPACING 55
+#define MI_TOGGLE_HERMITE_UPSAMPLING 56
+#define MI_TOGGLE_FRAME_CACHE 57
+#define MI_TOGGLE_VERTEX_BUFFERS 58
+#define MI_TOGGLE_INSTANCING 59
+#define MI_TOGGLE_FRUSTUM_CULLING 60
 #define MI_TOGGLE_ANIMATED_EVERSION 61
 #define MI_TOGGLE_ANIMATED_ROTATION 62
 #define MI_RESET_CAMERA 71
@@ -102,13 +135,166 @@ class EvertableSphere {
 
     // Stores all the vertices and normals used to render the sphere.
     // Elements in the array are arranged by [latitude][longitude].
+    // There are (1+NumberOfRows) by (1+NumberOfColumns) of them,
+    // which is more than the number of patches if upsampling is used.
+    // They are kept in one buffer, aligned on a cache line, as the
+    // streams of vertexLayout: GLPoints and/or separate positions and
+    // normals, with rows vertexStreams.rowStride samples apart (padded
+    // so that each row is aligned too). If there are GLPoints,
+    // arrayOfVertices[j] points to their row j, else it is NULL.
+    // The buffer is only reallocated when the number of rows or columns
+    // (or the layout) changes, not every time the vertices are regenerated.
+    VertexLayout vertexLayout;
+    char * vertexStorage;   // as allocated; the streams lie within it
+    VertexStreams vertexStreams;
     GLPoint ** arrayOfVertices;
+    int NumberOfRows, NumberOfColumns;
     bool verticesAreDirty; // If true, need to regenerate vertices.
 
+    // Packed copies of the vertices (see packedGeometry.h) at the times
+    // they were generated, keyed by the time in units of 2^-24, so that
+    // going over the same times again (e.g. as the animation bounces back)
+    // only unpacks them. Only used if useFrameCache. The oldest frames
+    // are dropped past maximumFrameCacheBytes, and all of them when
+    // anything but the time changes, as found from frameCacheSignature.
+    std::map< long, PackedGrid > frameCache;
+    std::deque< long > frameCacheOrder;
+    size_t frameCacheBytes;
+    int frameCacheSignature[6];
+
+    const float * Position( int j, int k ) const {
+       long i = (long)j * vertexStreams.rowStride + k;
+       return vertexStreams.points != NULL
+          ? vertexStreams.points[i].vertex : vertexStreams.positions + 3*i;
+    }
+    const float * Normal( int j, int k ) const {
+       long i = (long)j * vertexStreams.rowStride + k;
+       return vertexStreams.points != NULL
+          ? vertexStreams.points[i].normal : vertexStreams.normals + 3*i;
+    }
+
+    // The vertex streams copied into a buffer object, and the indices
+    // (see gridIndices.h) of what each rendering style draws of one strip
+    // into another, so that each strip is drawn with one glDrawElements()
+    // instead of a glVertex() per sample. Only used if useVertexBuffers;
+    // without buffer objects (OpenGL before 1.5), the same arrays are
+    // drawn from memory. The vertices are uploaded again once regenerated;
+    // the indices, and the texture coordinates, once per size of the grid,
+    // with the triangles reordered for the vertex cache (which takes a
+    // fraction of a second at the highest resolutions) within each band
+    // of rows (see bandRows), so that bands can be left out of the range.
+    // All the styles but points draw the same triangles: in style_checkered
+    // and style_bands, the patches not shown are cut out of them by the
+    // alpha test, through patternTexture (see LoadPatternMatrix()).
+    enum IndexRange {
+       range_triangles = 0,   // every patch
+       range_samples,         // every sample, as points
+       number_of_index_ranges
+    };
+    GLuint vertexBufferObject, indexBufferObject,   // 0 until created
+       textureCoordinateBufferObject;
+    bool buffersAreDirty; // If true, need to upload the vertices again.
+    bool indicesAreDirty; // If true, need to rebuild and upload indices.
+    std::vector< GLuint > indices;
+    size_t indexRangeStart[ number_of_index_ranges + 1 ];
+    std::vector< GLfloat > textureCoordinates;
+    GLuint patternTexture;   // 0 until created
+    IndexRange GetIndexRange() const {
+       return renderingStyle == style_points ? range_samples : range_triangles;
+    }
+    bool IsPatterned() const {
+       return renderingStyle == style_checkered || renderingStyle == style_bands;
+    }
+    void LoadPatternMatrix( int hemisphere );
+    void UploadBuffers();
+    void DrawIndexRange( size_t first, size_t count, int instances = 1 );
+
+    // Bounds of the vertices of the strip, and of its bands of bandRows
+    // rows of patches (the last one may have fewer), found whenever the
+    // vertices are generated, and the index of the first triangle of each
+    // band (then the end of range_triangles). Draw() leaves out the bands
+    // of the strips displayed whose bounds, rotated as each strip is,
+    // are outside the view frustum, and counts what it leaves out.
+    // bandIsVisible holds whether band b of instance i (strip s of
+    // hemisphere h being instance h * NumStripsToDisplay + s) is drawn.
+    // In style_points, the whole strip is one band.
+    int bandRows;
+    AlignedBox stripBounds;
+    std::vector< AlignedBox > bandBounds;
+    std::vector< size_t > bandIndexStart;
+    std::vector< char > bandIsVisible;
+    int NumberOfBands() const {
+       return (NumberOfRows + bandRows - 1) / bandRows;
+    }
+    int NumberOfBandsDrawn() const {
+       return GetIndexRange() == range_samples ? 1 : NumberOfBands();
+    }
+    size_t BandIndexStart( int band ) const {
+       return GetIndexRange() == range_samples
+          ? indexRangeStart[ range_samples + band ] : bandIndexStart[band];
+    }
+    void ComputeBounds();
+    void FindVisibleBands( const Plane * frustum );
+    void DrawVisibleBands( int firstInstance, int instances );
+
+    // The vertex shader (see stripVertexShader) drawing all the strips
+    // displayed, as instances of the one strip in the buffers, with one
+    // call instead of one per strip.
+    // Only used if useInstancing and useVertexBuffers, and if OpenGL
+    // supports it; 0 until built, and if it could not be.
+    GLuint stripProgram;
+    bool stripProgramIsBuilt;
+    GLint firstInstanceUniform, stripsPerHemisphereUniform, numStripsUniform,
+       lightingUniform, hemisphereTextureOffsetUniform;
+    bool BuildStripProgram();
+
+    // What was sent to OpenGL by the last call to Draw(), and how,
+    // and the number of points or triangles left out by culling.
+    int drawCalls;
+    long drawnVertices;
+    const char * drawingMode;
+    long culledPrimitives;
+
+    // The mesh of the whole sphere built from arrayOfVertices.
+    SurfaceMesh mesh;
+    bool meshIsDirty; // If true, need to rebuild mesh.
+    void BuildMesh();
+
+    // Where the surface passes through itself, found from mesh.
+    std::vector< Polyline > doubleCurve;
+    bool doubleCurveIsDirty; // If true, need to recompute doubleCurve.
+
+    // The silhouette seen from the eye point last given to DrawSilhouette().
+    std::vector< Polyline > silhouette;
+
+    // Samples of one strip, with their partial derivatives, at the corners
+    // of the patches (without upsampling), and the mesh of the whole sphere
+    // built from them, from which cross-sections are found.
+    std::vector< GLJetPoint > jetSamples;
+    std::vector< GLJetPoint * > arrayOfJets;
+    SurfaceMesh jetMesh;
+    bool jetsAreDirty; // If true, need to regenerate jetSamples and jetMesh.
+
+    // Where the surface crosses the plane last given to DrawCrossSection().
+    std::vector< Polyline > crossSection;
+
     void GenerateVertices();
+    void AllocateArray();
     void DeallocateArray();
 public:
-    EvertableSphere() : arrayOfVertices(NULL), verticesAreDirty(true) {
+    EvertableSphere() :
+       vertexLayout(LAYOUT_INTERLEAVED), vertexStorage(NULL),
+       arrayOfVertices(NULL), NumberOfRows(0), NumberOfColumns(0),
+       verticesAreDirty(true), frameCacheBytes(0),
+       vertexBufferObject(0), indexBufferObject(0),
+       textureCoordinateBufferObject(0),
+       buffersAreDirty(true), indicesAreDirty(true), patternTexture(0),
+       bandRows(1),
+       stripProgram(0), stripProgramIsBuilt(false),
+       drawCalls(0), drawnVertices(0), drawingMode(""), culledPrimitives(0),
+       meshIsDirty(true), doubleCurveIsDirty(true), jetsAreDirty(true)
+    {
+       memset( frameCacheSignature, 0, sizeof(frameCacheSignature) );
        Construct();
     }
     ~EvertableSphere() { DeallocateArray(); verticesAreDirty = true; }
@@ -122,10 +308,32 @@ public:
        int numberOfLongitudinalPatchesPerStrip = 0
     );
     void Reconstruct() { DeallocateArray(); verticesAreDirty = true; }
-    void Draw();
+    void ClearFrameCache() {
+       frameCache.clear();
+       frameCacheOrder.clear();
+       frameCacheBytes = 0;
+    }
+    int GetNumberOfCachedFrames() { return (int)frameCache.size(); }
+    int GetNumberOfDrawCalls() { return drawCalls; }
+    long GetNumberOfDrawnVertices() { return drawnVertices; }
+    const char * GetDrawingMode() { return drawingMode; }
+    long GetNumberOfCulledPrimitives() { return culledPrimitives; }
+    size_t GetFrameCacheBytes() { return frameCacheBytes; }
+    void SetVertexLayout( VertexLayout layout ) {
+       vertexLayout = layout;
+       Reconstruct();
+    }
+    // Leaves out what is outside the frustum (see Camera::getFrustum()),
+    // if one is given, when drawing from vertex buffers.
+    void Draw( const Plane * frustum = NULL );
+    void DrawDoubleCurve();
+    int GetNumberOfDoubleCurvePolylines() { return (int)doubleCurve.size(); }
+    void DrawCrossSection( const Plane & plane );
+    int GetNumberOfCrossSectionPolylines() { return (int)crossSection.size(); }
+    void DrawSilhouette( const Point3 & eye );
+    int GetNumberOfSilhouettePolylines() { return (int)silhouette.size(); }
     void IncrementTime(double deltaTime) {
        if ( Time < 1.0 ) {
-          DeallocateArray();
           Time += deltaTime;
           if ( deltaTime > 1.0 ) deltaTime = 1.0;
           verticesAreDirty = true;
@@ -133,21 +341,18 @@ public:
     }
     void DecrementTime(double deltaTime) {
        if ( Time > 0.0 ) {
-          DeallocateArray();
           Time -= deltaTime;
           if ( deltaTime < 0.0 ) deltaTime = 0.0;
           verticesAreDirty = true;
        }
     }
     void IncrementNumStrips() {
-       DeallocateArray();
        ++ NumStrips;
        ++ NumStripsToDisplay;
        verticesAreDirty = true;
     }
     void DecrementNumStrips() {
        if ( NumStrips > 1 ) {
-          DeallocateArray();
           -- NumStrips;
           if ( NumStripsToDisplay > 1 )
              -- NumStripsToDisplay;
@@ -192,16 +397,58 @@ public:
 
 const int EvertableSphere::NumHemispheres = 2;
 
-void EvertableSphere::DeallocateArray() {
+void EvertableSphere::AllocateArray() {
 
+   const int Alignment = 64;   // bytes in a cache line
+   const size_t PositionSize = 3 * sizeof(float);
    int j;
 
-   if (arrayOfVertices == NULL)
+   int rowStride = 1 + NumberOfColumns;
+   while (
+      rowStride * sizeof(GLPoint) % Alignment != 0
+      || rowStride * PositionSize % Alignment != 0
+   )
+      ++ rowStride;
+   size_t samples = (size_t)(1 + NumberOfRows) * rowStride;
+   size_t pointsSize
+      = vertexLayout & LAYOUT_INTERLEAVED ? samples * sizeof(GLPoint) : 0;
+   size_t streamSize
+      = vertexLayout & LAYOUT_SPLIT ? samples * PositionSize : 0;
+
+   // The streams one after the other, each a whole number of rows.
+   vertexStorage = new char[ pointsSize + 2 * streamSize + Alignment - 1 ];
+   char * buffer = (char *)(
+      ( (size_t)vertexStorage + Alignment - 1 ) & ~(size_t)( Alignment - 1 )
+   );
+   vertexStreams.rowStride = rowStride;
+   vertexStreams.points = pointsSize > 0 ? (GLPoint *)buffer : NULL;
+   vertexStreams.positions
+      = streamSize > 0 ? (float *)( buffer + pointsSize ) : NULL;
+   vertexStreams.normals
+      = streamSize > 0 ? (float *)( buffer + pointsSize + streamSize ) : NULL;
+
+   if ( vertexStreams.points != NULL ) {
+      arrayOfVertices = new GLPointPointer[1 + NumberOfRows];
+      for (j = NumberOfRows; j >= 0; --j)
+         arrayOfVertices[j] = vertexStreams.points + j * rowStride;
+   }
+   // at most 8 bands
+   bandRows = NumberOfRows > 8 ? (NumberOfRows + 7) / 8 : 1;
+   bandBounds.resize( NumberOfBands() );
+   bandIndexStart.resize( NumberOfBands() + 1 );
+
+   indicesAreDirty = true;
+   buffersAreDirty = true;
+}
+
+void EvertableSphere::DeallocateArray() {
+
+   if (vertexStorage == NULL)
      return;
-   for (j = NumberOfLatitudinalPatchesPerHemisphere; j >= 0; --j)
-     delete [] (arrayOfVertices[j]);
    delete [] arrayOfVertices;
+   delete [] vertexStorage;
    arrayOfVertices = NULL;
+   vertexStorage = NULL;
 }
 
 void EvertableSphere::Construct(
@@ -243,8 +490,6 @@ void EvertableSphere::Construct(
 
 void EvertableSphere::GenerateVertices() {
 
-    int j;
-
     // clamp input parameters to their minima
     if (Time < 0.0)
        Time = 0.0;
@@ -257,17 +502,60 @@ void EvertableSphere::GenerateVertices() {
     if (NumberOfLongitudinalPatchesPerStrip < 2)
        NumberOfLongitudinalPatchesPerStrip = 2;
 
-    // throw away previous geometry
-    DeallocateArray();
+    // allocate stuff, unless the previous geometry had the same size
+    int refinement = useHermiteUpsampling ? hermiteUpsamplingRefinement : 1;
+    int rows = refinement * NumberOfLatitudinalPatchesPerHemisphere;
+    int columns = refinement * NumberOfLongitudinalPatchesPerStrip;
+    if ( vertexStorage == NULL
+          || rows != NumberOfRows || columns != NumberOfColumns ) {
+       DeallocateArray();
+       NumberOfRows = rows;
+       NumberOfColumns = columns;
+       AllocateArray();
+    }
 
-    // allocate stuff
-    arrayOfVertices = new GLPointPointer[1 + NumberOfLatitudinalPatchesPerHemisphere];
-    for (j = NumberOfLatitudinalPatchesPerHemisphere; j >= 0; --j)
-       arrayOfVertices[j] = new GLPoint[1 + NumberOfLongitudinalPatchesPerStrip];
+    // forget the frames generated with other settings
+    int signature[6] = {
+       NumStrips,
+       NumberOfLatitudinalPatchesPerHemisphere,
+       NumberOfLongitudinalPatchesPerStrip,
+       refinement,
+       showHalfStrips,
+       useArcLengthSpacing
+    };
+    if ( ! useFrameCache
+          || memcmp( signature, frameCacheSignature, sizeof(signature) ) != 0 ) {
+       ClearFrameCache();
+       memcpy( frameCacheSignature, signature, sizeof(signature) );
+    }
+
+    long frame = (long)floor( Time * (1 << 24) + 0.5 );
+    std::map< long, PackedGrid >::const_iterator cached = frameCache.find( frame );
+    if ( cached != frameCache.end() ) {
+       unpackGrid( cached->second, vertexStreams );
+       ComputeBounds();
+       verticesAreDirty = false;
+       buffersAreDirty = true;
+       meshIsDirty = true;
+       doubleCurveIsDirty = true;
+       jetsAreDirty = true;
+       return;
+    }
+
+    // sample in the fastest way for grids of this size (cached after the
+    // first run, so this only takes time when the machine is new)
+    GeometryConfiguration configuration;
+    tuneGeometry(
+       &configuration,
+       NumberOfLatitudinalPatchesPerHemisphere,
+       NumberOfLongitudinalPatchesPerStrip,
+       NumStrips, true, NULL, stderr
+    );
 
     // generate the geometry
-    generateGeometry(
-       arrayOfVertices,
+    generateGeometryUpsampled(
+       vertexStreams,
+       refinement,
        Time,
        NumStrips,
 
@@ -276,19 +564,325 @@ void EvertableSphere::GenerateVertices() {
        1.0,
        0.0,
        NumberOfLongitudinalPatchesPerStrip,
-       showHalfStrips ? 0.5 : 1.0
+       showHalfStrips ? 0.5 : 1.0,
+       useArcLengthSpacing ? SPACING_ARC_LENGTH : SPACING_UNIFORM
 #ifdef BEND_IN /* this will display a cylindar bending into a sphere */
        ,Time
 #endif
     );
 
+    if ( useFrameCache ) {
+       PackedGrid & packed = frameCache[ frame ];
+       packGrid( vertexStreams, NumberOfRows, NumberOfColumns, &packed );
+       frameCacheOrder.push_back( frame );
+       frameCacheBytes += packed.sizeInBytes();
+       while ( frameCacheBytes > maximumFrameCacheBytes && frameCacheOrder.size() > 1 ) {
+          std::map< long, PackedGrid >::iterator oldest
+             = frameCache.find( frameCacheOrder.front() );
+          frameCacheBytes -= oldest->second.sizeInBytes();
+          frameCache.erase( oldest );
+          frameCacheOrder.pop_front();
+       }
+    }
+
+    ComputeBounds();
     verticesAreDirty = false;
+    buffersAreDirty = true;
+    meshIsDirty = true;
+    doubleCurveIsDirty = true;
+    jetsAreDirty = true;
+}
+
+void EvertableSphere::UploadBuffers() {
+
+   const GLExtensions & gl = glExtensions();
+   size_t samples = (size_t)(1 + NumberOfRows) * vertexStreams.rowStride;
+
+   if ( indicesAreDirty ) {
+      int rowStride = vertexStreams.rowStride;
+      indices.clear();
+      indexRangeStart[range_triangles] = indices.size();
+      for ( int band = 0; band < NumberOfBands(); ++band ) {
+         // in an order reusing the GPU's transformed vertices, rather than
+         // row after row, unless the rows are short enough for that
+         // to be as good
+         int firstRow = band * bandRows;
+         int endRow = std::min( firstRow + bandRows, NumberOfRows );
+         std::vector< GLuint > rowOrder, reordered;
+         appendGridTriangles(
+            rowOrder, endRow, NumberOfColumns, rowStride, firstRow
+         );
+         reordered = rowOrder;
+         optimizeVertexCache( reordered, (unsigned int)samples );
+         if ( averageCacheMissRatio( rowOrder )
+               <= averageCacheMissRatio( reordered ) )
+            reordered.swap( rowOrder );
+         bandIndexStart[band] = indices.size();
+         indices.insert( indices.end(), reordered.begin(), reordered.end() );
+      }
+      bandIndexStart[ NumberOfBands() ] = indices.size();
+      indexRangeStart[range_samples] = indices.size();
+      appendGridSamples( indices, NumberOfRows, NumberOfColumns, rowStride );
+      indexRangeStart[number_of_index_ranges] = indices.size();
+
+      if ( gl.hasBufferObjects ) {
+         if ( indexBufferObject == 0 )
+            gl.GenBuffers( 1, &indexBufferObject );
+         gl.BindBuffer( GL_ELEMENT_ARRAY_BUFFER, indexBufferObject );
+         gl.BufferData( GL_ELEMENT_ARRAY_BUFFER,
+            indices.size() * sizeof(GLuint),
+            indices.empty() ? NULL : &indices[0], GL_STATIC_DRAW );
+      }
+
+      textureCoordinates.clear();
+      appendGridTextureCoordinates(
+         textureCoordinates, NumberOfRows, NumberOfColumns, rowStride
+      );
+      if ( gl.hasBufferObjects ) {
+         if ( textureCoordinateBufferObject == 0 )
+            gl.GenBuffers( 1, &textureCoordinateBufferObject );
+         gl.BindBuffer( GL_ARRAY_BUFFER, textureCoordinateBufferObject );
+         gl.BufferData( GL_ARRAY_BUFFER,
+            textureCoordinates.size() * sizeof(GLfloat),
+            &textureCoordinates[0], GL_STATIC_DRAW );
+      }
+      indicesAreDirty = false;
+   }
+
+   if ( buffersAreDirty && gl.hasBufferObjects ) {
+      if ( vertexBufferObject == 0 )
+         gl.GenBuffers( 1, &vertexBufferObject );
+      gl.BindBuffer( GL_ARRAY_BUFFER, vertexBufferObject );
+      if ( vertexStreams.points != NULL )
+         gl.BufferData( GL_ARRAY_BUFFER, samples * sizeof(GLPoint),
+            vertexStreams.points, GL_DYNAMIC_DRAW );
+      else {
+         // positions, then normals
+         size_t streamSize = samples * 3 * sizeof(float);
+         gl.BufferData( GL_ARRAY_BUFFER, 2 * streamSize, NULL, GL_DYNAMIC_DRAW );
+         gl.BufferSubData( GL_ARRAY_BUFFER, 0, streamSize,
+            vertexStreams.positions );
+         gl.BufferSubData( GL_ARRAY_BUFFER, streamSize, streamSize,
+            vertexStreams.normals );
+      }
+   }
+   buffersAreDirty = false;
+}
+
+// Draws instance i = firstInstance + gl_InstanceIDARB of the strip, which is strip
+// i % stripsPerHemisphere of hemisphere i / stripsPerHemisphere, rotated
+// as in the glRotatef() calls of EvertableSphere::Draw(), and lit
+// (if lighting) as by the fixed pipeline, with GL_LIGHT0 and a two-sided
+// light model. Texture coordinates are shifted by hemisphereTextureOffset
+// in the second hemisphere (see EvertableSphere::LoadPatternMatrix()).
+static const char * const stripVertexShader =
+   "#version 120\n"
+   "#extension GL_ARB_draw_instanced : require\n"
+   "uniform int firstInstance;\n"
+   "uniform int stripsPerHemisphere;\n"
+   "uniform int numStrips;\n"
+   "uniform int lighting;\n"
+   "uniform vec2 hemisphereTextureOffset;\n"
+   "\n"
+   "vec4 shade(\n"
+   "   vec3 normal, vec3 position, vec4 scene,\n"
+   "   vec4 ambient, vec4 diffuse, vec4 specular, float shininess\n"
+   ") {\n"
+   "   vec4 light = gl_LightSource[0].position;\n"
+   "   vec3 l = normalize( light.w == 0.0 ? light.xyz : light.xyz - position );\n"
+   "   vec3 h = normalize( l + vec3( 0.0, 0.0, 1.0 ) );\n"
+   "   float d = dot( normal, l );\n"
+   "   vec4 colour = scene + ambient;\n"
+   "   if ( d > 0.0 )\n"
+   "      colour += d * diffuse\n"
+   "         + pow( max( dot( normal, h ), 0.0 ), shininess ) * specular;\n"
+   "   return vec4( colour.rgb, diffuse.a );\n"
+   "}\n"
+   "\n"
+   "void main() {\n"
+   "   int instance = firstInstance + gl_InstanceIDARB;\n"
+   "   int hemisphere = instance / stripsPerHemisphere;\n"
+   "   int strip = instance - hemisphere * stripsPerHemisphere;\n"
+   "   float angle = radians( 360.0 ) / float( numStrips )\n"
+   "      * float( hemisphere == 0 ? -strip : strip + 1 );\n"
+   "   float c = cos( angle ), s = sin( angle );\n"
+   "   mat3 rotation = mat3( c, s, 0.0, -s, c, 0.0, 0.0, 0.0, 1.0 );\n"
+   "   if ( hemisphere != 0 )\n"
+   "      rotation = mat3( -1.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, -1.0 )\n"
+   "         * rotation;\n"
+   "\n"
+   "   vec4 vertex = vec4( rotation * gl_Vertex.xyz, 1.0 );\n"
+   "   gl_Position = gl_ModelViewProjectionMatrix * vertex;\n"
+   "   gl_TexCoord[0] = gl_TextureMatrix[0] * gl_MultiTexCoord0\n"
+   "      + vec4( float( hemisphere ) * hemisphereTextureOffset, 0.0, 0.0 );\n"
+   "   if ( lighting != 0 ) {\n"
+   "      vec3 normal = normalize( gl_NormalMatrix * ( rotation * gl_Normal ) );\n"
+   "      vec3 position = ( gl_ModelViewMatrix * vertex ).xyz;\n"
+   "      gl_FrontColor = shade(\n"
+   "         normal, position, gl_FrontLightModelProduct.sceneColor,\n"
+   "         gl_FrontLightProduct[0].ambient, gl_FrontLightProduct[0].diffuse,\n"
+   "         gl_FrontLightProduct[0].specular, gl_FrontMaterial.shininess\n"
+   "      );\n"
+   "      gl_BackColor = shade(\n"
+   "         -normal, position, gl_BackLightModelProduct.sceneColor,\n"
+   "         gl_BackLightProduct[0].ambient, gl_BackLightProduct[0].diffuse,\n"
+   "         gl_BackLightProduct[0].specular, gl_BackMaterial.shininess\n"
+   "      );\n"
+   "   }\n"
+   "   else {\n"
+   "      gl_FrontColor = gl_Color;\n"
+   "      gl_BackColor = gl_Color;\n"
+   "   }\n"
+   "}\n";
+
+bool EvertableSphere::BuildStripProgram() {
+
+   if ( ! stripProgramIsBuilt ) {
+      stripProgramIsBuilt = true;
+      const GLExtensions & gl = glExtensions();
+      stripProgram = buildVertexProgram( stripVertexShader, stderr );
+      if ( stripProgram != 0 ) {
+         firstInstanceUniform
+            = gl.GetUniformLocation( stripProgram, "firstInstance" );
+         stripsPerHemisphereUniform
+            = gl.GetUniformLocation( stripProgram, "stripsPerHemisphere" );
+         numStripsUniform = gl.GetUniformLocation( stripProgram, "numStrips" );
+         lightingUniform = gl.GetUniformLocation( stripProgram, "lighting" );
+         hemisphereTextureOffsetUniform
+            = gl.GetUniformLocation( stripProgram, "hemisphereTextureOffset" );
+      }
+   }
+   return stripProgram != 0;
+}
+
+// patternTexture is 2 by 2 texels, opaque at (0,0) and (1,1) and
+// transparent elsewhere, and repeats every 2 samples of the grid:
+// in style_checkered, patch (j,k) is shown if j+k is even. In style_bands,
+// s is flattened to 0, and t shifted by a patch in the second hemisphere,
+// so that hemisphere 0 shows the even rows of patches, and 1 the odd ones.
+void EvertableSphere::LoadPatternMatrix( int hemisphere ) {
+   glMatrixMode(GL_TEXTURE);
+   glLoadIdentity();
+   if ( renderingStyle == style_bands ) {
+      glTranslatef( 0, 0.5*hemisphere, 0 );
+      glScalef( 0, 0.5, 1 );
+   }
+   else
+      glScalef( 0.5, 0.5, 1 );
+   glMatrixMode(GL_MODELVIEW);
+}
+
+void EvertableSphere::DrawIndexRange(
+   size_t first, size_t count, int instances
+) {
+   if ( count == 0 )
+      return;
+
+   const GLExtensions & gl = glExtensions();
+   GLenum mode = GetIndexRange() == range_samples ? GL_POINTS : GL_TRIANGLES;
+   const GLvoid * rangeIndices = gl.hasBufferObjects
+      ? (const GLvoid *)( first * sizeof(GLuint) ) : &indices[first];
+   if ( instances > 1 )
+      gl.DrawElementsInstanced(
+         mode, (GLsizei)count, GL_UNSIGNED_INT, rangeIndices, instances
+      );
+   else
+      glDrawElements( mode, (GLsizei)count, GL_UNSIGNED_INT, rangeIndices );
+   ++ drawCalls;
+   drawnVertices += (long)count * instances;
+}
+
+void EvertableSphere::ComputeBounds() {
+
+   stripBounds.clear();
+   for ( int band = 0; band < NumberOfBands(); ++band ) {
+      // the rows of samples at the corners of the band's patches
+      int endRow = std::min( (band + 1) * bandRows, NumberOfRows );
+      bandBounds[band].clear();
+      for ( int j = band * bandRows; j <= endRow; ++j )
+         for ( int k = 0; k <= NumberOfColumns; ++k ) {
+            const float * p = Position(j,k);
+            bandBounds[band].bound( Point3( p[0], p[1], p[2] ) );
+         }
+      stripBounds.bound( bandBounds[band] );
+   }
+}
+
+void EvertableSphere::FindVisibleBands( const Plane * frustum ) {
+
+   int instances = NumHemispheresToDisplay * NumStripsToDisplay;
+   int bands = NumberOfBandsDrawn();
+   bandIsVisible.assign( bands * instances, true );
+   if ( frustum == NULL )
+      return;
+
+   float rotation[9];
+   for ( int i = 0; i < instances; ++i ) {
+      stripInstanceRotation(
+         i / NumStripsToDisplay, i % NumStripsToDisplay, NumStrips, rotation
+      );
+      for ( int band = 0; band < bands; ++band ) {
+         const AlignedBox & box
+            = bands == 1 ? stripBounds : bandBounds[band];
+         AlignedBox rotated;
+         for ( int c = 0; c < 8; ++c ) {
+            Point3 p = box.getCorner( c );
+            rotated.bound( Point3(
+               rotation[0]*p.x() + rotation[1]*p.y() + rotation[2]*p.z(),
+               rotation[3]*p.x() + rotation[4]*p.y() + rotation[5]*p.z(),
+               rotation[6]*p.x() + rotation[7]*p.y() + rotation[8]*p.z()
+            ) );
+         }
+         for ( int f = 0; f < 6; ++f )
+            if ( frustum[f].side( rotated ) < 0 ) {
+               bandIsVisible[ band * instances + i ] = false;
+               break;
+            }
+      }
+   }
 }
 
-void EvertableSphere::Draw() {
+// Draws the visible bands of the given instances, with one call per run
+// of consecutive instances over consecutive bands visible in the same
+// instances (a single call if everything is visible).
+// More than one instance at a time needs stripProgram to be in use.
+void EvertableSphere::DrawVisibleBands( int firstInstance, int instances ) {
+
+   const GLExtensions & gl = glExtensions();
+   int allInstances = NumHemispheresToDisplay * NumStripsToDisplay;
+   int bands = NumberOfBandsDrawn();
+   int indicesPerPrimitive = GetIndexRange() == range_samples ? 1 : 3;
+   int endInstance = firstInstance + instances;
+   for ( int firstBand = 0, endBand; firstBand < bands; firstBand = endBand ) {
+      const char * visible = &bandIsVisible[ firstBand * allInstances ];
+      for ( endBand = firstBand + 1; endBand < bands; ++endBand )
+         if ( memcmp(
+               visible + firstInstance,
+               &bandIsVisible[ endBand * allInstances ] + firstInstance,
+               instances
+            ) != 0 )
+            break;
+      size_t first = BandIndexStart( firstBand );
+      size_t count = BandIndexStart( endBand ) - first;
+
+      for ( int i = firstInstance, run; i < endInstance; i = run ) {
+         if ( ! visible[i] ) {
+            culledPrimitives += (long)( count / indicesPerPrimitive );
+            run = i + 1;
+            continue;
+         }
+         for ( run = i + 1; run < endInstance && visible[run]; ++run )
+            ;
+         if ( instances > 1 )
+            gl.Uniform1i( firstInstanceUniform, i );
+         DrawIndexRange( first, count, run - i );
+      }
+   }
+}
+
+void EvertableSphere::Draw( const Plane * frustum ) {
 
    if ( verticesAreDirty ) {
-      DeallocateArray();
       GenerateVertices();
       ASSERT( ! verticesAreDirty );
    }
@@ -311,11 +905,100 @@ void EvertableSphere::Draw() {
 
    int hemisphere,strip,j,k;
 
-   glFrontFace(GL_CW);  // we're going to use the opposite convention
+   cachedFrontFace(GL_CW);  // we're going to use the opposite convention
+
+   drawCalls = 0;
+   drawnVertices = 0;
+   culledPrimitives = 0;
+   const GLExtensions & gl = glExtensions();
+   if ( useVertexBuffers ) {
+      UploadBuffers();
+      FindVisibleBands( frustum );
+
+      if ( IsPatterned() ) {
+         if ( gl.hasBufferObjects )
+            gl.BindBuffer( GL_ARRAY_BUFFER, textureCoordinateBufferObject );
+         glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+         glTexCoordPointer(2, GL_FLOAT, 0,
+            gl.hasBufferObjects ? (const GLvoid *)0 : &textureCoordinates[0]
+         );
+
+         if ( patternTexture == 0 ) {
+            const GLubyte texels[2][2][4] = {
+               { { 255, 255, 255, 255 }, { 255, 255, 255, 0 } },
+               { { 255, 255, 255, 0 }, { 255, 255, 255, 255 } }
+            };
+            glGenTextures( 1, &patternTexture );
+            cachedBindTexture( GL_TEXTURE_2D, patternTexture );
+            cachedTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT );
+            cachedTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT );
+            cachedTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+            cachedTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
+            glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA, 2, 2, 0,
+               GL_RGBA, GL_UNSIGNED_BYTE, texels );
+         }
+         cachedBindTexture( GL_TEXTURE_2D, patternTexture );
+         cachedTexEnvi( GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE );
+         cachedEnable( GL_TEXTURE_2D );
+         cachedAlphaFunc( GL_GREATER, 0.5f );
+         cachedEnable( GL_ALPHA_TEST );
+         LoadPatternMatrix( 0 );
+      }
+
+      GLsizei stride = vertexStreams.points != NULL ? sizeof(GLPoint) : 0;
+      const GLvoid * vertices, * normals;
+      if ( gl.hasBufferObjects ) {
+         // offsets into the buffer objects, as uploaded
+         gl.BindBuffer( GL_ARRAY_BUFFER, vertexBufferObject );
+         gl.BindBuffer( GL_ELEMENT_ARRAY_BUFFER, indexBufferObject );
+         vertices = (const GLvoid *)0;
+         normals = (const GLvoid *)( vertexStreams.points != NULL
+            ? offsetof(GLPoint, normal)
+            : (size_t)(1 + NumberOfRows) * vertexStreams.rowStride
+               * 3 * sizeof(float)
+         );
+      }
+      else if ( vertexStreams.points != NULL ) {
+         vertices = vertexStreams.points[0].vertex;
+         normals = vertexStreams.points[0].normal;
+      }
+      else {
+         vertices = vertexStreams.positions;
+         normals = vertexStreams.normals;
+      }
+      glEnableClientState(GL_VERTEX_ARRAY);
+      glEnableClientState(GL_NORMAL_ARRAY);
+      glVertexPointer(3, GL_FLOAT, stride, vertices);
+      glNormalPointer(GL_FLOAT, stride, normals);
+      drawingMode = gl.hasBufferObjects ? "buffer objects" : "vertex arrays";
+   }
+   else
+      drawingMode = "immediate mode";
 
    glMatrixMode(GL_MODELVIEW);
 
-   for (hemisphere = 0; hemisphere < NumHemispheresToDisplay; ++hemisphere) {
+   if (
+      useVertexBuffers && useInstancing && gl.hasInstancing
+      && BuildStripProgram()
+   ) {
+      // all the strips at once, rotated by the vertex shader
+      bool lighting = glIsEnabled(GL_LIGHTING) == GL_TRUE;
+      gl.UseProgram( stripProgram );
+      gl.Uniform1i( stripsPerHemisphereUniform, NumStripsToDisplay );
+      gl.Uniform1i( numStripsUniform, NumStrips );
+      gl.Uniform1i( lightingUniform, lighting );
+      // the shift of LoadPatternMatrix() in the second hemisphere
+      gl.Uniform2f( hemisphereTextureOffsetUniform,
+         0, renderingStyle == style_bands ? 0.5f : 0 );
+      if ( lighting )
+         cachedEnable(GL_VERTEX_PROGRAM_TWO_SIDE);
+      DrawVisibleBands( 0, NumHemispheresToDisplay * NumStripsToDisplay );
+      cachedDisable(GL_VERTEX_PROGRAM_TWO_SIDE);
+      gl.UseProgram( 0 );
+      drawingMode = gl.hasBufferObjects
+         ? "instances from buffer objects" : "instances from vertex arrays";
+   }
+   else for (hemisphere = 0; hemisphere < NumHemispheresToDisplay; ++hemisphere) {
       glPushMatrix();
       glRotatef(hemisphere*180.0,0.0,1.0,0.0);
       for (strip = 0; strip < NumStripsToDisplay; ++strip) {
@@ -325,43 +1008,54 @@ void EvertableSphere::Draw() {
             0.0,0.0,1.0
          );
 
-         if ( renderingStyle == style_points ) {
+         if ( useVertexBuffers ) {
+            if ( IsPatterned() )
+               LoadPatternMatrix( hemisphere );
+            DrawVisibleBands( hemisphere * NumStripsToDisplay + strip, 1 );
+         }
+         else if ( renderingStyle == style_points ) {
             glBegin(GL_POINTS);
-            for (j = 0; j <= NumberOfLatitudinalPatchesPerHemisphere; ++j)
-               for (k = 0; k <= NumberOfLongitudinalPatchesPerStrip; ++k) {
-                  glNormal3fv(arrayOfVertices[j][k].normal);
-                  glVertex3fv(arrayOfVertices[j][k].vertex);
+            for (j = 0; j <= NumberOfRows; ++j)
+               for (k = 0; k <= NumberOfColumns; ++k) {
+                  glNormal3fv(Normal(j,k));
+                  glVertex3fv(Position(j,k));
                }
             glEnd();
+            ++ drawCalls;
+            drawnVertices += (long)(1 + NumberOfRows) * (1 + NumberOfColumns);
          }
          else {
-            for (j = 0; j < NumberOfLatitudinalPatchesPerHemisphere; ++j) {
+            for (j = 0; j < NumberOfRows; ++j) {
                if (
                   renderingStyle == style_polygons
                   || renderingStyle == style_wireframe
                   || (renderingStyle == style_bands && (j & 1)==hemisphere)
                ) {
                   glBegin(GL_TRIANGLE_STRIP);
-                  for (k = 0; k <= NumberOfLongitudinalPatchesPerStrip; ++k) {
-                     glNormal3fv(arrayOfVertices[j][k].normal);
-                     glVertex3fv(arrayOfVertices[j][k].vertex);
-                     glNormal3fv(arrayOfVertices[j+1][k].normal);
-                     glVertex3fv(arrayOfVertices[j+1][k].vertex);
+                  for (k = 0; k <= NumberOfColumns; ++k) {
+                     glNormal3fv(Normal(j,k));
+                     glVertex3fv(Position(j,k));
+                     glNormal3fv(Normal(j+1,k));
+                     glVertex3fv(Position(j+1,k));
                   }
                   glEnd();
+                  ++ drawCalls;
+                  drawnVertices += 2 * (1 + NumberOfColumns);
                }
                else if (renderingStyle == style_checkered) {
-                  for (k = j%2; k < NumberOfLongitudinalPatchesPerStrip; k+=2) {
+                  for (k = j%2; k < NumberOfColumns; k+=2) {
                      glBegin(GL_TRIANGLE_STRIP);
-                     glNormal3fv(arrayOfVertices[j][k].normal);
-                     glVertex3fv(arrayOfVertices[j][k].vertex);
-                     glNormal3fv(arrayOfVertices[j+1][k].normal);
-                     glVertex3fv(arrayOfVertices[j+1][k].vertex);
-                     glNormal3fv(arrayOfVertices[j][k+1].normal);
-                     glVertex3fv(arrayOfVertices[j][k+1].vertex);
-                     glNormal3fv(arrayOfVertices[j+1][k+1].normal);
-                     glVertex3fv(arrayOfVertices[j+1][k+1].vertex);
+                     glNormal3fv(Normal(j,k));
+                     glVertex3fv(Position(j,k));
+                     glNormal3fv(Normal(j+1,k));
+                     glVertex3fv(Position(j+1,k));
+                     glNormal3fv(Normal(j,k+1));
+                     glVertex3fv(Position(j,k+1));
+                     glNormal3fv(Normal(j+1,k+1));
+                     glVertex3fv(Position(j+1,k+1));
                      glEnd();
+                     ++ drawCalls;
+                     drawnVertices += 4;
                   }
                }
             }
@@ -370,6 +1064,181 @@ void EvertableSphere::Draw() {
       }
       glPopMatrix();
    }
+
+   if ( useVertexBuffers ) {
+      if ( IsPatterned() ) {
+         glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+         cachedDisable( GL_TEXTURE_2D );
+         cachedDisable( GL_ALPHA_TEST );
+         glMatrixMode(GL_TEXTURE);
+         glLoadIdentity();
+         glMatrixMode(GL_MODELVIEW);
+      }
+      glDisableClientState(GL_VERTEX_ARRAY);
+      glDisableClientState(GL_NORMAL_ARRAY);
+      if ( gl.hasBufferObjects ) {
+         gl.BindBuffer( GL_ARRAY_BUFFER, 0 );
+         gl.BindBuffer( GL_ELEMENT_ARRAY_BUFFER, 0 );
+      }
+   }
+}
+
+void EvertableSphere::BuildMesh() {
+
+   if ( verticesAreDirty ) {
+      GenerateVertices();
+      ASSERT( ! verticesAreDirty );
+   }
+
+   if ( meshIsDirty ) {
+      // The mesh covers the whole sphere,
+      // not just the strips and hemispheres being displayed.
+      if ( arrayOfVertices != NULL && ! showHalfStrips )
+         buildSurfaceMesh(
+            arrayOfVertices, NumberOfRows, NumberOfColumns, NumStrips, &mesh
+         );
+      else {
+         // Only split streams, or only half of each strip:
+         // the mesh is built from GLPoints of whole strips.
+         int j, k, i;
+         std::vector< GLPoint > samples( (1 + NumberOfRows) * (1 + NumberOfColumns) );
+         std::vector< GLPoint * > rows( 1 + NumberOfRows );
+         for (j = 0; j <= NumberOfRows; ++j)
+            rows[j] = &samples[j * (1 + NumberOfColumns)];
+         if ( showHalfStrips ) {
+            VertexStreams streams = { &samples[0], NULL, NULL, 1 + NumberOfColumns };
+            generateGeometryUpsampled(
+               streams,
+               useHermiteUpsampling ? hermiteUpsamplingRefinement : 1,
+               Time,
+               NumStrips,
+
+               0.0,
+               NumberOfLatitudinalPatchesPerHemisphere,
+               1.0,
+               0.0,
+               NumberOfLongitudinalPatchesPerStrip,
+               1.0,
+               useArcLengthSpacing ? SPACING_ARC_LENGTH : SPACING_UNIFORM
+#ifdef BEND_IN
+               ,Time
+#endif
+            );
+         }
+         else
+            for (j = 0; j <= NumberOfRows; ++j)
+               for (k = 0; k <= NumberOfColumns; ++k)
+                  for (i = 0; i < 3; ++i) {
+                     rows[j][k].vertex[i] = Position(j,k)[i];
+                     rows[j][k].normal[i] = Normal(j,k)[i];
+                  }
+         buildSurfaceMesh(
+            &rows[0], NumberOfRows, NumberOfColumns, NumStrips, &mesh
+         );
+      }
+      meshIsDirty = false;
+   }
+}
+
+void EvertableSphere::DrawDoubleCurve() {
+
+   BuildMesh();
+
+   if ( doubleCurveIsDirty ) {
+      findDoubleCurve( mesh, doubleCurve );
+      doubleCurveIsDirty = false;
+   }
+
+   int i, j;
+
+   glMatrixMode(GL_MODELVIEW);
+   for (i = 0; i < (int)doubleCurve.size(); ++i) {
+      const Polyline & polyline = doubleCurve[i];
+      glBegin( polyline.isClosed ? GL_LINE_LOOP : GL_LINE_STRIP );
+      for (j = 0; j < polyline.numberOfPoints(); ++j)
+         glVertex3fv( &polyline.points[3*j] );
+      glEnd();
+   }
+}
+
+void EvertableSphere::DrawSilhouette( const Point3 & eye ) {
+
+   BuildMesh();
+
+   // The eye moves with the camera, so this is redone every time.
+   float eyePoint[3] = { eye.x(), eye.y(), eye.z() };
+   findSilhouette( mesh, eyePoint, silhouette );
+
+   int i, j;
+
+   glMatrixMode(GL_MODELVIEW);
+   for (i = 0; i < (int)silhouette.size(); ++i) {
+      const Polyline & polyline = silhouette[i];
+      glBegin( polyline.isClosed ? GL_LINE_LOOP : GL_LINE_STRIP );
+      for (j = 0; j < polyline.numberOfPoints(); ++j)
+         glVertex3fv( &polyline.points[3*j] );
+      glEnd();
+   }
+}
+
+void EvertableSphere::DrawCrossSection( const Plane & plane ) {
+
+   if ( verticesAreDirty ) {
+      GenerateVertices();
+      ASSERT( ! verticesAreDirty );
+   }
+
+   // As with the double curve, the whole sphere is cut.
+   int rows = NumberOfLatitudinalPatchesPerHemisphere;
+   int columns = NumberOfLongitudinalPatchesPerStrip;
+   if ( jetsAreDirty ) {
+      int j;
+      jetSamples.resize( (1 + rows) * (1 + columns) );
+      arrayOfJets.resize( 1 + rows );
+      for (j = 0; j <= rows; ++j)
+         arrayOfJets[j] = &jetSamples[j * (1 + columns)];
+
+      generateJetGeometry(
+         NULL,
+         &arrayOfJets[0],
+         Time,
+         NumStrips,
+
+         0.0,
+         rows,
+         1.0,
+         0.0,
+         columns,
+         1.0,
+         useArcLengthSpacing ? SPACING_ARC_LENGTH : SPACING_UNIFORM
+#ifdef BEND_IN
+         ,Time
+#endif
+      );
+      buildSurfaceMesh( &arrayOfJets[0], rows, columns, NumStrips, &jetMesh );
+      jetsAreDirty = false;
+   }
+
+   // The plane changes whenever the camera moves, so this is redone
+   // every time; it is cheap compared to generating the samples.
+   findCrossSection(
+      plane, jetMesh, &arrayOfJets[0], columns, crossSection,
+      3, 0, Time, NumStrips
+#ifdef BEND_IN
+      ,Time
+#endif
+   );
+
+   int i, j;
+
+   glMatrixMode(GL_MODELVIEW);
+   for (i = 0; i < (int)crossSection.size(); ++i) {
+      const Polyline & polyline = crossSection[i];
+      glBegin( polyline.isClosed ? GL_LINE_LOOP : GL_LINE_STRIP );
+      for (j = 0; j < polyline.numberOfPoints(); ++j)
+         glVertex3fv( &polyline.points[3*j] );
+      glEnd();
+   }
 }
 
 // ===============================================================
@@ -385,10 +1254,15 @@ void reshapeCallback( int width, int height ) {
 
 void drawCallback() {
 
+   // state changes made and skipped over the last frame, for the text
+   static long stateChangesMade = 0, stateChangesSkipped = 0;
+   getGLStateCounts( &stateChangesMade, &stateChangesSkipped );
+   resetGLStateCounts();
+
    glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
 
    glDepthFunc( GL_LEQUAL );
-   glEnable( GL_DEPTH_TEST );
+   cachedEnable( GL_DEPTH_TEST );
 
    camera->transform();
 
@@ -412,10 +1286,10 @@ void drawCallback() {
 
    if (cullBackfaces) {
       // turn on back face culling
-      glEnable( GL_CULL_FACE );
-      glCullFace( flipFrontFaces ? GL_BACK : GL_FRONT );
+      cachedEnable( GL_CULL_FACE );
+      cachedCullFace( flipFrontFaces ? GL_BACK : GL_FRONT );
    }
-   else glDisable( GL_CULL_FACE );
+   else cachedDisable( GL_CULL_FACE );
 
    // Don't bother doing this, since the normals are
    // already normalized by us at generation time.
@@ -423,7 +1297,7 @@ void drawCallback() {
    // glEnable(GL_NORMALIZE);
 
    if ( renderingStyle == style_wireframe )
-      glPolygonMode( GL_FRONT_AND_BACK, GL_LINE );
+      cachedPolygonMode( GL_FRONT_AND_BACK, GL_LINE );
 
    if (
       renderingStyle == style_polygons
@@ -433,9 +1307,9 @@ void drawCallback() {
       // Setup colours & lighting properties of the materiel.
       //
       GLfloat specular[] = { 1.0, 1.0, 1.0, 1.0 };
-      glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, specular);
+      cachedMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, specular);
       GLfloat shininess[] = { 50.0 };
-      glMaterialfv(GL_FRONT_AND_BACK, GL_SHININESS, shininess);
+      cachedMaterialfv(GL_FRONT_AND_BACK, GL_SHININESS, shininess);
       float a = useAlphaBlending ? alpha : 1;
       GLfloat colourFront[] = {
          a*materialColour.x(),
@@ -449,8 +1323,8 @@ void drawCallback() {
          a*(1-materialColour.z()),
          1.0
       };// colour of back faces
-      glMaterialfv(GL_FRONT, GL_AMBIENT_AND_DIFFUSE, colourFront);
-      glMaterialfv(GL_BACK, GL_AMBIENT_AND_DIFFUSE, colourBack);
+      cachedMaterialfv(GL_FRONT, GL_AMBIENT_AND_DIFFUSE, colourFront);
+      cachedMaterialfv(GL_BACK, GL_AMBIENT_AND_DIFFUSE, colourBack);
 
       // Setup lighting.
       //
@@ -461,38 +1335,73 @@ void drawCallback() {
       //
       Point3 lightPosition = camera->getPosition()
          + ( camera->getPosition() - camera->getTarget() );
-      glLightfv( GL_LIGHT0, GL_POSITION, lightPosition.get() );
-      glEnable( GL_LIGHT0 );
-      glEnable( GL_LIGHTING );
+      cachedLightfv( GL_LIGHT0, GL_POSITION, lightPosition.get() );
+      cachedEnable( GL_LIGHT0 );
+      cachedEnable( GL_LIGHTING );
       GLfloat lightModelFlag[1] = { 1.0 };
-      glLightModelfv(GL_LIGHT_MODEL_TWO_SIDE, lightModelFlag);
+      cachedLightModelfv(GL_LIGHT_MODEL_TWO_SIDE, lightModelFlag);
 
-      glShadeModel( isShadingSmooth ? GL_SMOOTH : GL_FLAT );
+      cachedShadeModel( isShadingSmooth ? GL_SMOOTH : GL_FLAT );
    }
 
    if ( useAlphaBlending ) {
       // We use an additive (and therefore commutative) function,
       // so that no z-sorting of polygons is necessary.
-      glBlendFunc( GL_ONE, GL_ONE );
+      cachedBlendFunc( GL_ONE, GL_ONE );
 
-      glEnable( GL_BLEND );
-      glDisable( GL_DEPTH_TEST );
+      cachedEnable( GL_BLEND );
+      cachedDisable( GL_DEPTH_TEST );
    }
 
    glColor3f( 1, 1, 1 );
 
    // ----- draw objects
 
-   sphere.Draw();
+   Plane frustum[6];
+   camera->getFrustum( frustum );
+   sphere.Draw( useFrustumCulling ? frustum : NULL );
 
    if ( renderingStyle == style_wireframe )
-      glPolygonMode( GL_FRONT_AND_BACK, GL_FILL );
-   glDisable( GL_LIGHTING );
+      cachedPolygonMode( GL_FRONT_AND_BACK, GL_FILL );
+   cachedDisable( GL_LIGHTING );
    if ( useAlphaBlending ) {
-      glDisable( GL_BLEND );
-      glEnable( GL_DEPTH_TEST );
+      cachedDisable( GL_BLEND );
+      cachedEnable( GL_DEPTH_TEST );
+   }
+   cachedDisable( GL_CULL_FACE );
+
+   if ( drawDoubleCurve ) {
+      // Drawn on top of the surface, since it lies within it.
+      cachedDisable( GL_DEPTH_TEST );
+      cachedLineWidth( 2 );
+      glColor3f( 1, 1, 0 );
+      sphere.DrawDoubleCurve();
+      cachedLineWidth( 1 );
+      cachedEnable( GL_DEPTH_TEST );
+   }
+
+   if ( drawSilhouette ) {
+      cachedDisable( GL_DEPTH_TEST );
+      cachedLineWidth( 2 );
+      glColor3f( 1, 1, 1 );
+      sphere.DrawSilhouette( camera->getPosition() );
+      cachedLineWidth( 1 );
+      cachedEnable( GL_DEPTH_TEST );
+   }
+
+   if ( drawCrossSection ) {
+      // Cut by the plane through the camera target facing the camera,
+      // so that orbiting the camera sweeps the plane around the surface.
+      Plane plane(
+         camera->getTarget() - camera->getPosition(), camera->getTarget()
+      );
+      cachedDisable( GL_DEPTH_TEST );
+      cachedLineWidth( 2 );
+      glColor3f( 0, 1, 1 );
+      sphere.DrawCrossSection( plane );
+      cachedLineWidth( 1 );
+      cachedEnable( GL_DEPTH_TEST );
    }
-   glDisable( GL_CULL_FACE );
 
    // ----- draw text
 
@@ -501,15 +1410,16 @@ void drawCallback() {
       g.pushProjection(
          camera->getViewportWidthInPixels(),camera->getViewportHeightInPixels()
       );
-      char buffer[50];
+      char buffer[128];
       sprintf( buffer, "t = %.4f, delta_t = 1/%d",
          sphere.GetTime(),
          ROUND( 1.0/deltaTime )
       );
 
       int FONT_HEIGHT = 18;
+      int y = 20+FONT_HEIGHT;
       g.drawString(
-         20, 20+FONT_HEIGHT,
+         20, y,
          buffer,
          FONT_HEIGHT,
          true, // blended ?
@@ -519,8 +1429,99 @@ void drawCallback() {
 
       if ( useAlphaBlending ) {
          sprintf( buffer, "alpha = %.3f", alpha );
+         y += 5+FONT_HEIGHT;
+         g.drawString(
+            20, y,
+            buffer,
+            FONT_HEIGHT,
+            true, // blended ?
+            1, // line thinkness
+            OpenGL2DInterface::FONT_TOTAL_HEIGHT
+         );
+      }
+
+      if ( useFrameCache ) {
+         sprintf( buffer, "frame cache: %d frames, %.1f MB",
+            sphere.GetNumberOfCachedFrames(),
+            sphere.GetFrameCacheBytes() / 1048576.0
+         );
+         y += 5+FONT_HEIGHT;
          g.drawString(
-            20, 25+2*FONT_HEIGHT,
+            20, y,
+            buffer,
+            FONT_HEIGHT,
+            true, // blended ?
+            1, // line thinkness
+            OpenGL2DInterface::FONT_TOTAL_HEIGHT
+         );
+      }
+
+      sprintf( buffer, "draw calls: %d, vertices: %ld, culled primitives: %ld (%s)",
+         sphere.GetNumberOfDrawCalls(),
+         sphere.GetNumberOfDrawnVertices(),
+         sphere.GetNumberOfCulledPrimitives(),
+         sphere.GetDrawingMode()
+      );
+      y += 5+FONT_HEIGHT;
+      g.drawString(
+         20, y,
+         buffer,
+         FONT_HEIGHT,
+         true, // blended ?
+         1, // line thinkness
+         OpenGL2DInterface::FONT_TOTAL_HEIGHT
+      );
+
+      sprintf( buffer, "state changes: %ld made, %ld redundant ones skipped",
+         stateChangesMade, stateChangesSkipped
+      );
+      y += 5+FONT_HEIGHT;
+      g.drawString(
+         20, y,
+         buffer,
+         FONT_HEIGHT,
+         true, // blended ?
+         1, // line thinkness
+         OpenGL2DInterface::FONT_TOTAL_HEIGHT
+      );
+
+      if ( drawDoubleCurve ) {
+         sprintf( buffer, "double curve: %d polylines",
+            sphere.GetNumberOfDoubleCurvePolylines()
+         );
+         y += 5+FONT_HEIGHT;
+         g.drawString(
+            20, y,
+            buffer,
+            FONT_HEIGHT,
+            true, // blended ?
+            1, // line thinkness
+            OpenGL2DInterface::FONT_TOTAL_HEIGHT
+         );
+      }
+
+      if ( drawCrossSection ) {
+         sprintf( buffer, "cross-section: %d polylines",
+            sphere.GetNumberOfCrossSectionPolylines()
+         );
+         y += 5+FONT_HEIGHT;
+         g.drawString(
+            20, y,
+            buffer,
+            FONT_HEIGHT,
+            true, // blended ?
+            1, // line thinkness
+            OpenGL2DInterface::FONT_TOTAL_HEIGHT
+         );
+      }
+
+      if ( drawSilhouette ) {
+         sprintf( buffer, "silhouette: %d polylines",
+            sphere.GetNumberOfSilhouettePolylines()
+         );
+         y += 5+FONT_HEIGHT;
+         g.drawString(
+            20, y,
             buffer,
             FONT_HEIGHT,
             true, // blended ?
@@ -660,6 +1661,18 @@ void menuCallback( int menuItem ) {
          displayText = ! displayText;
          glutPostRedisplay();
          break;
+      case MI_TOGGLE_DISPLAY_OF_DOUBLE_CURVE :
+         drawDoubleCurve = ! drawDoubleCurve;
+         glutPostRedisplay();
+         break;
+      case MI_TOGGLE_DISPLAY_OF_CROSS_SECTION :
+         drawCrossSection = ! drawCrossSection;
+         glutPostRedisplay();
+         break;
+      case MI_TOGGLE_DISPLAY_OF_SILHOUETTE :
+         drawSilhouette = ! drawSilhouette;
+         glutPostRedisplay();
+         break;
       case MI_INCREMENT_TIME :
          sphere.IncrementTime(deltaTime);
          glutPostRedisplay();
@@ -720,6 +1733,34 @@ void menuCallback( int menuItem ) {
          sphere.DecrementLongitudinalResolution();
          glutPostRedisplay();
          break;
+      case MI_TOGGLE_ARC_LENGTH_SPACING :
+         useArcLengthSpacing = ! useArcLengthSpacing;
+         sphere.Reconstruct();
+         glutPostRedisplay();
+         break;
+      case MI_TOGGLE_HERMITE_UPSAMPLING :
+         useHermiteUpsampling = ! useHermiteUpsampling;
+         sphere.Reconstruct();
+         glutPostRedisplay();
+         break;
+      case MI_TOGGLE_FRAME_CACHE :
+         useFrameCache = ! useFrameCache;
+         if ( ! useFrameCache )
+            sphere.ClearFrameCache();
+         glutPostRedisplay();
+         break;
+      case MI_TOGGLE_VERTEX_BUFFERS :
+         useVertexBuffers = ! useVertexBuffers;
+         glutPostRedisplay();
+         break;
+      case MI_TOGGLE_INSTANCING :
+         useInstancing = ! useInstancing;
+         glutPostRedisplay();
+         break;
+      case MI_TOGGLE_FRUSTUM_CULLING :
+         useFrustumCulling = ! useFrustumCulling;
+         glutPostRedisplay();
+         break;
       case MI_TOGGLE_ANIMATED_EVERSION :
          animatingEversion = ! animatingEversion;
          startAnimationAsNecessary();
@@ -764,9 +1805,36 @@ void keyboardCallback( unsigned char key, int x, int y ) {
       case 'b':
          menuCallback( MI_TOGGLE_DISPLAY_OF_BACKFACES );
          break;
+      case 'c':
+         menuCallback( MI_TOGGLE_DISPLAY_OF_CROSS_SECTION );
+         break;
+      case 'd':
+         menuCallback( MI_TOGGLE_DISPLAY_OF_DOUBLE_CURVE );
+         break;
+      case 'e':
+         menuCallback( MI_TOGGLE_ARC_LENGTH_SPACING );
+         break;
       case 'f':
          menuCallback( MI_TOGGLE_WHICH_FACES_ARE_FRONT_FACING );
          break;
+      case 'h':
+         menuCallback( MI_TOGGLE_HERMITE_UPSAMPLING );
+         break;
+      case 'i':
+         menuCallback( MI_TOGGLE_INSTANCING );
+         break;
+      case 'k':
+         menuCallback( MI_TOGGLE_FRAME_CACHE );
+         break;
+      case 'o':
+         menuCallback( MI_TOGGLE_DISPLAY_OF_SILHOUETTE );
+         break;
+      case 'u':
+         menuCallback( MI_TOGGLE_FRUSTUM_CULLING );
+         break;
+      case 'v':
+         menuCallback( MI_TOGGLE_VERTEX_BUFFERS );
+         break;
       case 'r':
          menuCallback( MI_RESET_CAMERA );
          break;
@@ -913,11 +1981,32 @@ void timerCallback( int /* id */ ) {
 
 int main( int argc, char *argv[] ) {
 
-   if ( argc > 2 || (argc == 2 && strcmp(argv[1],"--root")!= 0)) {
-      fprintf(stderr,"Usage: %s [--root]\n", argv[0] );
+   bool rootWindow = false, badArguments = false;
+   VertexLayout vertexLayout = LAYOUT_INTERLEAVED;
+   for ( int i = 1; i < argc && ! badArguments; ++i ) {
+      if ( strcmp(argv[i],"--root") == 0 )
+         rootWindow = true;
+      else if ( strcmp(argv[i],"--layout") == 0 && i+1 < argc ) {
+         ++ i;
+         if ( strcmp(argv[i],"interleaved") == 0 )
+            vertexLayout = LAYOUT_INTERLEAVED;
+         else if ( strcmp(argv[i],"split") == 0 )
+            vertexLayout = LAYOUT_SPLIT;
+         else if ( strcmp(argv[i],"both") == 0 )
+            vertexLayout = LAYOUT_BOTH;
+         else
+            badArguments = true;
+      }
+      else
+         badArguments = true;
+   }
+   if ( badArguments ) {
+      fprintf(stderr,"Usage: %s [--root] [--layout interleaved|split|both]\n",
+         argv[0] );
       exit(1);
    }
-   if ( argc == 2 ) {
+   sphere.SetVertexLayout( vertexLayout );
+   if ( rootWindow ) {
       animatingEversion = true;
       animatingRotation = true;
       displayText = false;
@@ -957,6 +2046,12 @@ int main( int argc, char *argv[] ) {
       MI_TOGGLE_DISPLAY_OF_CAMERA_TARGET );
    glutAddMenuEntry( "Toggle Display of Text (F9)",
       MI_TOGGLE_DISPLAY_OF_TEXT );
+   glutAddMenuEntry( "Toggle Display of Double Curve (d)",
+      MI_TOGGLE_DISPLAY_OF_DOUBLE_CURVE );
+   glutAddMenuEntry( "Toggle Display of Cross-Section (c)",
+      MI_TOGGLE_DISPLAY_OF_CROSS_SECTION );
+   glutAddMenuEntry( "Toggle Display of Silhouette (o)",
+      MI_TOGGLE_DISPLAY_OF_SILHOUETTE );
    glutAddMenuEntry( "Increment Time t (+ or right arrow)",
       MI_INCREMENT_TIME );
    glutAddMenuEntry( "Decrement Time t (- or left arrow)",
@@ -983,6 +2078,18 @@ int main( int argc, char *argv[] ) {
       MI_INCREMENT_LONGITUDINAL_RESOLUTION );
    glutAddMenuEntry( "Decrement Number of Longitudinal Patches (F4)",
       MI_DECREMENT_LONGITUDINAL_RESOLUTION );
+   glutAddMenuEntry( "Toggle Equal Arc Length Spacing of Patches (e)",
+      MI_TOGGLE_ARC_LENGTH_SPACING );
+   glutAddMenuEntry( "Toggle Hermite Upsampling of Patches (h)",
+      MI_TOGGLE_HERMITE_UPSAMPLING );
+   glutAddMenuEntry( "Toggle Caching of Packed Frames (k)",
+      MI_TOGGLE_FRAME_CACHE );
+   glutAddMenuEntry( "Toggle Drawing from Vertex Buffers (v)",
+      MI_TOGGLE_VERTEX_BUFFERS );
+   glutAddMenuEntry( "Toggle Drawing Strips as Instances (i)",
+      MI_TOGGLE_INSTANCING );
+   glutAddMenuEntry( "Toggle Frustum Culling of Strips and Bands (u)",
+      MI_TOGGLE_FRUSTUM_CULLING );
    glutAddMenuEntry( "Toggle Animated Eversion (F5)",
       MI_TOGGLE_ANIMATED_EVERSION );
    glutAddMenuEntry( "Toggle Animated Rotation (F6)",
@@ -354,6 +354,14 @@ public:
    //Plane( const Point3& p0, const Point3& p1, const Point3& p2 );
    //Plane( const Ray& ray, const Point3& p );
 
+   const Vector3& getNormal() const { return _n; }
+
+   // Returns the signed distance from the plane to the given point
+   // (positive in the direction of the normal)
+   float distance( const Point3& p ) const {
+      return _n.x()*p.x() + _n.y()*p.y() + _n.z()*p.z() + _d;
+   }
+
    // Returns true if there is an intersection,
    // in which case the point of intersection is also returned
    bool intersects( const Ray & ray, Point3 & intersection,
@@ -0,0 +1,176 @@
+
+#include "packedGeometry.h"
+#include <math.h>
+
+
+const float QuantizedRange = 65535.0f;
+const float NormalRange = 127.0f;
+
+static inline float signNotZero( float x ) {
+   return x < 0 ? -1.0f : 1.0f;
+}
+
+PackingBox packingBox( const float min[3], const float max[3] ) {
+   PackingBox box;
+   for ( int i = 0; i < 3; ++i ) {
+      box.origin[i] = min[i];
+      box.scale[i] = max[i] > min[i] ? ( max[i] - min[i] ) / QuantizedRange : 0;
+   }
+   return box;
+}
+
+void packPoint(
+   const float vertex[3], const float normal[3],
+   const PackingBox & box, PackedPoint * packed
+) {
+   for ( int i = 0; i < 3; ++i ) {
+      float q = box.scale[i] > 0
+         ? ( vertex[i] - box.origin[i] ) / box.scale[i] : 0;
+      if ( q < 0 ) q = 0;
+      else if ( q > QuantizedRange ) q = QuantizedRange;
+      packed->vertex[i] = (unsigned short)( q + 0.5f );
+   }
+
+   // A zero normal (at a degenerate sample) comes back as (0,0,1).
+   float s = fabsf( normal[0] ) + fabsf( normal[1] ) + fabsf( normal[2] );
+   float x = 0, y = 0;
+   if ( s > 0 ) {
+      x = normal[0] / s;
+      y = normal[1] / s;
+      if ( normal[2] < 0 ) {
+         float foldedX = ( 1 - fabsf( y ) ) * signNotZero( x );
+         y = ( 1 - fabsf( x ) ) * signNotZero( y );
+         x = foldedX;
+      }
+   }
+   packed->normal[0] = (signed char)floorf( x * NormalRange + 0.5f );
+   packed->normal[1] = (signed char)floorf( y * NormalRange + 0.5f );
+}
+
+void unpackPoint(
+   const PackedPoint & packed, const PackingBox & box,
+   float vertex[3], float normal[3]
+) {
+   for ( int i = 0; i < 3; ++i )
+      vertex[i] = box.origin[i] + box.scale[i] * packed.vertex[i];
+
+   float x = packed.normal[0] / NormalRange;
+   float y = packed.normal[1] / NormalRange;
+   float z = 1 - fabsf( x ) - fabsf( y );
+   if ( z < 0 ) {
+      float unfoldedX = ( 1 - fabsf( y ) ) * signNotZero( x );
+      y = ( 1 - fabsf( x ) ) * signNotZero( y );
+      x = unfoldedX;
+   }
+   float s = 1 / sqrtf( x*x + y*y + z*z );
+   normal[0] = x * s;
+   normal[1] = y * s;
+   normal[2] = z * s;
+}
+
+// The vertex and normal of sample (j,k) of the streams.
+static inline void streamSample(
+   const VertexStreams & streams, int j, int k,
+   const float ** vertex, const float ** normal
+) {
+   long i = (long)j * streams.rowStride + k;
+   if ( streams.points != NULL ) {
+      *vertex = streams.points[i].vertex;
+      *normal = streams.points[i].normal;
+   }
+   else {
+      *vertex = streams.positions + 3*i;
+      *normal = streams.normals + 3*i;
+   }
+}
+
+void packGrid(
+   const VertexStreams & streams, int rows, int columns,
+   PackedGrid * packed
+) {
+   const float * vertex, * normal;
+   float min[3] = { 0, 0, 0 }, max[3] = { 0, 0, 0 };
+   int j, k, i;
+
+   for ( j = 0; j <= rows; ++j )
+      for ( k = 0; k <= columns; ++k ) {
+         streamSample( streams, j, k, &vertex, &normal );
+         for ( i = 0; i < 3; ++i ) {
+            if ( ( j == 0 && k == 0 ) || vertex[i] < min[i] ) min[i] = vertex[i];
+            if ( ( j == 0 && k == 0 ) || vertex[i] > max[i] ) max[i] = vertex[i];
+         }
+      }
+
+   packed->rows = rows;
+   packed->columns = columns;
+   packed->box = packingBox( min, max );
+   packed->points.resize( (size_t)( 1 + rows ) * ( 1 + columns ) );
+   for ( j = 0; j <= rows; ++j )
+      for ( k = 0; k <= columns; ++k ) {
+         streamSample( streams, j, k, &vertex, &normal );
+         packPoint( vertex, normal, packed->box,
+            &packed->points[ (size_t)j * ( 1 + columns ) + k ] );
+      }
+}
+
+void unpackGrid( const PackedGrid & packed, const VertexStreams & streams ) {
+   for ( int j = 0; j <= packed.rows; ++j )
+      for ( int k = 0; k <= packed.columns; ++k ) {
+         const PackedPoint & p
+            = packed.points[ (size_t)j * ( 1 + packed.columns ) + k ];
+         long i = (long)j * streams.rowStride + k;
+         float vertex[3], normal[3];
+         unpackPoint( p, packed.box, vertex, normal );
+         for ( int c = 0; c < 3; ++c ) {
+            if ( streams.points != NULL ) {
+               streams.points[i].vertex[c] = vertex[c];
+               streams.points[i].normal[c] = normal[c];
+            }
+            if ( streams.positions != NULL ) {
+               streams.positions[3*i+c] = vertex[c];
+               streams.normals[3*i+c] = normal[c];
+            }
+         }
+      }
+}
+
+void generatePackedGeometry(
+   PackedGrid * packed,
+   int refinement,
+   double time,
+   int numStrips,
+
+   double u_min,
+   int u_count,
+   double u_max,
+   double v_min,
+   int v_count,
+   double v_max,
+
+   SampleSpacing spacing,
+
+   double bendtime,
+
+   double corrStart,
+   double pushStart,
+   double twistStart,
+   double unpushStart,
+   double uncorrStart
+) {
+   if ( refinement < 1 )
+      refinement = 1;
+   int rows = refinement * u_count, columns = refinement * v_count;
+   if ( rows < 0 || columns < 0 )
+      return;
+
+   // The vertices are generated in a split buffer first, and packed
+   // afterwards, since the box they are quantized against depends
+   // on all of them.
+   std::vector< float > positions( 3 * (size_t)( 1 + rows ) * ( 1 + columns ) );
+   std::vector< float > normals( positions.size() );
+   VertexStreams streams = { NULL, &positions[0], &normals[0], 1 + columns };
+   generateGeometryUpsampled( streams, refinement, time, numStrips,
+      u_min, u_count, u_max, v_min, v_count, v_max, spacing,
+      bendtime, corrStart, pushStart, twistStart, unpushStart, uncorrStart );
+   packGrid( streams, rows, columns, packed );
+}
@@ -0,0 +1,96 @@
+
+#ifndef PACKEDGEOMETRY_H
+#define PACKEDGEOMETRY_H
+
+
+#include "generateGeometry.h"
+#include <vector>
+#include <stddef.h>
+
+
+// A GLPoint in 8 bytes instead of 24, for keeping many frames in memory
+// or on disk: the vertex quantized to 16 bits per coordinate within
+// the bounding box of its grid, and the unit normal in the octahedral
+// encoding (folded onto the octahedron |x|+|y|+|z| = 1, then projected
+// onto the plane z = 0), at 8 bits per coordinate.
+// Vertices are within 1/131070 of the size of the box of their true value,
+// and normals within about 1 degree.
+struct PackedPoint {
+   unsigned short vertex[3];
+   signed char normal[2];
+};
+
+// Where the quantized vertices of a grid of PackedPoints lie:
+// vertex[i] = origin[i] + scale[i] * packed.vertex[i].
+struct PackingBox {
+   float origin[3];
+   float scale[3];
+};
+
+// A (1 + rows) by (1 + columns) grid of PackedPoints, in row-major order.
+struct PackedGrid {
+   int rows, columns;
+   PackingBox box;
+   std::vector< PackedPoint > points;
+
+   size_t sizeInBytes() const {
+      return sizeof( *this ) + points.capacity() * sizeof( PackedPoint );
+   }
+};
+
+// The box that the given bounds are quantized against.
+PackingBox packingBox( const float min[3], const float max[3] );
+
+void packPoint(
+   const float vertex[3], const float normal[3],
+   const PackingBox & box, PackedPoint * packed
+);
+void unpackPoint(
+   const PackedPoint & packed, const PackingBox & box,
+   float vertex[3], float normal[3]
+);
+
+// Packs the grid of (1 + rows) by (1 + columns) samples held in the given
+// streams (read from the GLPoints if there are any, else from the split
+// streams), against its bounding box.
+void packGrid(
+   const VertexStreams & streams, int rows, int columns,
+   PackedGrid * packed
+);
+
+// Unpacks the grid into whichever of the given streams are non-NULL.
+void unpackGrid( const PackedGrid & packed, const VertexStreams & streams );
+
+// Same as generateGeometryUpsampled(), but emits a PackedGrid of
+// (1 + refinement*u_count) by (1 + refinement*v_count) samples.
+// The samples are not packed as they are generated: since the box they
+// are quantized against depends on all of them, the whole grid is first
+// generated in floats (24 bytes per sample, freed on return), then packed.
+// Only what is kept (e.g. in a frame cache) is smaller.
+void generatePackedGeometry(
+   PackedGrid * packed,
+   int refinement,             // 1 means no upsampling
+
+   double time = 0.0,
+   int numStrips = 8,
+
+   double u_min = 0.0,
+   int u_count = 12,
+   double u_max = 1.0,
+   double v_min = 0.0,
+   int v_count = 12,
+   double v_max = 1.0,
+
+   SampleSpacing spacing = SPACING_UNIFORM,
+
+   double bendtime = -1.0,
+
+   double corrStart   = 0.00,
+   double pushStart   = 0.10,
+   double twistStart  = 0.23,
+   double unpushStart = 0.60,
+   double uncorrStart = 0.93
+);
+
+
+#endif /* PACKEDGEOMETRY_H */
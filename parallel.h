@@ -0,0 +1,66 @@
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+
+#include <thread>
+#include <atomic>
+#include <vector>
+
+
+// Returns the number of threads worth running at once on this machine.
+inline int numberOfThreads() {
+   static int n = 0;
+   if ( n == 0 ) {
+      n = (int)std::thread::hardware_concurrency();
+      if ( n < 1 ) n = 1;
+   }
+   return n;
+}
+
+// Returns the number of threads parallelFor() will actually use.
+inline int threadsForParallelFor( int count, int threads = 0, int chunkSize = 1 ) {
+   if ( threads <= 0 ) threads = numberOfThreads();
+   if ( chunkSize < 1 ) chunkSize = 1;
+   if ( threads > ( count + chunkSize - 1 ) / chunkSize )
+      threads = ( count + chunkSize - 1 ) / chunkSize;
+   return threads < 1 ? 1 : threads;
+}
+
+// Calls f( i, thread ) for every i in [0,count), spread over
+// the given number of threads (0 means numberOfThreads()).
+// thread is in [0,threads), and identifies the calling thread,
+// e.g. for indexing per-thread output buffers.
+// Indices are handed out in chunks of the given size,
+// on a first-come first-served basis, so that the load stays
+// balanced even if some indices take much longer than others.
+// Returns once every call has returned.
+template < class Function >
+void parallelFor( int count, Function f, int threads = 0, int chunkSize = 1 ) {
+   threads = threadsForParallelFor( count, threads, chunkSize );
+   if ( chunkSize < 1 ) chunkSize = 1;
+   if ( threads <= 1 ) {
+      for ( int i = 0; i < count; ++i )
+         f( i, 0 );
+      return;
+   }
+
+   std::atomic< int > next( 0 );
+   std::vector< std::thread > workers;
+   for ( int t = 0; t < threads; ++t ) {
+      workers.push_back( std::thread( [ &next, &f, count, chunkSize, t ]() {
+         for (;;) {
+            int begin = next.fetch_add( chunkSize );
+            if ( begin >= count ) break;
+            int end = begin + chunkSize < count ? begin + chunkSize : count;
+            for ( int i = begin; i < end; ++i )
+               f( i, t );
+         }
+      } ) );
+   }
+   for ( int t = 0; t < threads; ++t )
+      workers[t].join();
+}
+
+
+#endif /* PARALLEL_H */
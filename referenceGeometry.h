@@ -0,0 +1,36 @@
+
+#ifndef REFERENCEGEOMETRY_H
+#define REFERENCEGEOMETRY_H
+
+
+#include "generateGeometry.h"
+
+
+// Same as generateGeometry() with SPACING_UNIFORM, but computed by
+// the original code, with one full evaluation of the surface per sample
+// and the sines and cosines of v from the math library.
+// This is much slower, and is only meant as a reference for testing
+// the faster paths of generateGeometry.cpp.
+void generateReferenceGeometry(
+   GLPoint ** geometryMatrix,   // Must be an array of (1 + u_count) arrays of (1 + v_count) elements
+   double time = 0.0,
+   int numStrips = 8,
+
+   double u_min = 0.0,
+   int u_count = 12,
+   double u_max = 1.0,
+   double v_min = 0.0,
+   int v_count = 12,
+   double v_max = 1.0,
+
+   double bendtime = -1.0,
+
+   double corrStart   = 0.00,
+   double pushStart   = 0.10,
+   double twistStart  = 0.23,
+   double unpushStart = 0.60,
+   double uncorrStart = 0.93
+);
+
+
+#endif /* REFERENCEGEOMETRY_H */
@@ -0,0 +1,217 @@
+/*
+    This file is part of "sphereEversion",
+    a program by Michael McGuffin.
+    This file samples the surface defined in evertSurface.h.
+*/
+
+/*
+    Sampling of the surface on a grid, the innermost loops of
+    generateGeometry().
+
+    Like evertSurface.h, this file has no include guard: it is included
+    after evertSurface.h, in the same namespace, once per build of these
+    loops (see selectGeometryKernel() in generateGeometry.cpp).
+*/
+
+// ----------------------------------------
+
+static void printVertexAndNormal(TwoJetVec p, float vertex[3], float normal[3]) {
+
+    double x = p.x.f ;
+    double y = p.y.f ;
+    double z = p.z.f ;
+    double nx = p.y.df_du()*p.z.df_dv()-p.z.df_du()*p.y.df_dv();
+    double ny = p.z.df_du()*p.x.df_dv()-p.x.df_du()*p.z.df_dv();
+    double nz = p.x.df_du()*p.y.df_dv()-p.y.df_du()*p.x.df_dv();
+    double s = nx*nx + ny*ny + nz*nz;
+    if (s > 0) s = sqrt(1/s);
+
+    /* printf("%f %f %f    %f %f %f\n", x, y, z, nx*s, ny*s, nz*s); */
+
+    vertex[0] = x;
+    vertex[1] = y;
+    vertex[2] = z;
+    normal[0] = -nx*s;
+    normal[1] = -ny*s;
+    normal[2] = -nz*s;
+}
+
+void printMesh(TwoJetVec p, GLPoint * point) {
+    printVertexAndNormal(p, point->vertex, point->normal);
+}
+
+void printJet(TwoJetVec p, double u, double v, GLJetPoint * jet) {
+
+    printVertexAndNormal(p, jet->vertex, jet->normal);
+
+    jet->u = u;
+    jet->v = v;
+    jet->du[0] = p.x.df_du();
+    jet->du[1] = p.y.df_du();
+    jet->du[2] = p.z.df_du();
+    jet->dv[0] = p.x.df_dv();
+    jet->dv[1] = p.y.df_dv();
+    jet->dv[2] = p.z.df_dv();
+    jet->duv[0] = p.x.d2f_dudv();
+    jet->duv[1] = p.y.d2f_dudv();
+    jet->duv[2] = p.z.d2f_dudv();
+}
+
+// ----------------------------------------
+
+typedef TwoJetVec SurfaceTimeFunction(ThreeJet u, ThreeJet v, double t, int numStrips);
+typedef FigureEightFrame SurfaceFrameFunction(ThreeJet u, double t);
+
+static inline double sqr(double x) {
+  return x*x;
+}
+static inline double calcSpeedV(TwoJetVec v) {
+  return sqrt(sqr(v.x.df_dv()) + sqr(v.y.df_dv()) + sqr(v.z.df_dv()));
+}
+static inline double calcSpeedU(TwoJetVec v) {
+  return sqrt(sqr(v.x.df_du()) + sqr(v.y.df_du()) + sqr(v.z.df_du()));
+}
+
+/* The FigureEightFrame of the given stage, as a function of (u,t) */
+static SurfaceFrameFunction * StageFrameFunction(EversionStage stage) {
+   switch (stage) {
+      case STAGE_BEND_IN: return BendInFrame;
+      case STAGE_CORRUGATE: return CorrugateFrame;
+      case STAGE_PUSH_THROUGH: return PushThroughFrame;
+      case STAGE_TWIST: return TwistFrame;
+      case STAGE_UNPUSH: return UnPushFrame;
+      default: return UnCorrugateFrame;
+   }
+}
+
+// ----------------------------------------
+
+/*
+   Fills in trig[k] with FigureEightTrigAt(vSamples[k]), for k in [0,count).
+   If the samples are equally spaced, only every
+   getTrigonometricRecurrenceInterval()-th column has its sines and cosines computed by the math library;
+   those of the columns in between are obtained from the previous column,
+   by a rotation through the fixed angle between columns.
+*/
+static void computeColumnTrig(
+   const double * vSamples,
+   int count,
+   bool equallySpaced,
+   int numStrips,
+   FigureEightTrig * trig
+) {
+   int i, k;
+   int interval = getTrigonometricRecurrenceInterval();
+
+   if (!equallySpaced || interval <= 1 || count < 3) {
+      for (k = 0; k < count; k++)
+         trig[k] = FigureEightTrigAt(ThreeJet(vSamples[k], 0, 1), numStrips);
+      return;
+   }
+
+   // The angles (in turns) of Sin(v*2), Cos(v), and Sin(v/numStrips)
+   // advance by these fixed amounts per unit of v.
+   const double turnsPerV[3] = { 2, 1, 1.0/numStrips };
+   double delta_v = (vSamples[count-1] - vSamples[0]) / (count-1);
+   double s[3] = { 0, 0, 0 }, c[3] = { 1, 1, 1 }, sinStep[3], cosStep[3];
+   double error = 0;
+   for (i = 0; i < 3; i++) {
+      sinStep[i] = sin(2*M_PI*turnsPerV[i]*delta_v);
+      cosStep[i] = cos(2*M_PI*turnsPerV[i]*delta_v);
+   }
+
+   for (k = 0; k < count; k++) {
+      TwoJet v = ThreeJet(vSamples[k], 0, 1);
+      TwoJet angle[3];
+      angle[2] = v*(1.0/numStrips);
+      v %= 1;
+      angle[0] = v*2;
+      angle[1] = v;
+      for (i = 0; i < 3; i++) {
+         double si = s[i]*cosStep[i] + c[i]*sinStep[i];
+         c[i] = c[i]*cosStep[i] - s[i]*sinStep[i];
+         s[i] = si;
+         if (k % interval == 0) {
+            // Re-anchor, measuring how far the recurrence has drifted.
+            double a = (angle[i]*(2*M_PI)).f;
+            double sa = sin(a), ca = cos(a);
+            if (k > 0) {
+               if (fabs(s[i] - sa) > error) error = fabs(s[i] - sa);
+               if (fabs(c[i] - ca) > error) error = fabs(c[i] - ca);
+            }
+            s[i] = sa;
+            c[i] = ca;
+         }
+      }
+      trig[k].v = v;
+      trig[k].sin2v = SinGiven(angle[0], s[0], c[0]);
+      trig[k].cos2v = CosGiven(angle[0], s[0], c[0]);
+      trig[k].cosv = CosGiven(angle[1], s[1], c[1]);
+      trig[k].sinRotation = SinGiven(angle[2], s[2], c[2]);
+      trig[k].cosRotation = CosGiven(angle[2], s[2], c[2]);
+   }
+
+   // The drift should stay within a few ulps per step;
+   // anything more means the samples were not equally spaced.
+   ASSERT(error < 1e-9);
+}
+
+/*
+   Evaluates the samples in rows [firstRow, firstRow+rowCount) and
+   columns [firstColumn, firstColumn+columnCount) of the sample grid,
+   storing sample (j,k), which is located at (uSamples[j],vSamples[k]),
+   in geometryMatrix[j-firstRow][k-firstColumn],
+   positionMatrix[j-firstRow][3*(k-firstColumn)] and
+   normalMatrix[j-firstRow][3*(k-firstColumn)] (which are both NULL or not),
+   and/or jetMatrix[j-firstRow][k-firstColumn], whichever are non-NULL,
+   with t the time rescaled to the given stage.
+   The part of the surface that depends only on u is evaluated
+   once per row, and the part that depends only on v once per column.
+*/
+void printScene(
+   EversionStage stage,
+   const double * uSamples,
+   const double * vSamples,
+   bool equallySpacedV,
+   double t,
+   GLPoint ** geometryMatrix,
+   float ** positionMatrix,
+   float ** normalMatrix,
+   GLJetPoint ** jetMatrix,
+   int numStrips,
+   int firstRow, int rowCount,
+   int firstColumn, int columnCount
+) {
+   int j, k;
+   double u, speedv;
+   SurfaceFrameFunction * frameFunc = StageFrameFunction(stage);
+   FigureEightFrame frame;
+   FigureEightTrig * trig = new FigureEightTrig[columnCount];
+   FigureEightTrig trigAtZero = FigureEightTrigAt(ThreeJet(0, 0, 1), numStrips);
+
+   computeColumnTrig(vSamples + firstColumn, columnCount, equallySpacedV,
+      numStrips, trig);
+
+   for (j = firstRow; j < firstRow + rowCount; j++) {
+      u = uSamples[j];
+      frame = (*frameFunc)(ThreeJet(u, 1, 0), t);
+      speedv = calcSpeedV(AddFigureEight(frame, trigAtZero));
+      if (speedv == 0) {
+         /* Perturb a bit, hoping to avoid degeneracy */
+         u += (u < 1) ? 1e-9 : -1e-9;
+         frame = (*frameFunc)(ThreeJet(u, 1, 0), t);
+      }
+      for (k = firstColumn; k < firstColumn + columnCount; k++) {
+         TwoJetVec p = AddFigureEight(frame, trig[k-firstColumn]);
+         if (geometryMatrix != NULL)
+            printMesh(p, &geometryMatrix[j-firstRow][k-firstColumn]);
+         if (positionMatrix != NULL)
+            printVertexAndNormal(p, &positionMatrix[j-firstRow][3*(k-firstColumn)],
+               &normalMatrix[j-firstRow][3*(k-firstColumn)]);
+         if (jetMatrix != NULL)
+            printJet(p, uSamples[j], vSamples[k], &jetMatrix[j-firstRow][k-firstColumn]);
+      }
+   }
+
+   delete [] trig;
+}
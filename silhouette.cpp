@@ -0,0 +1,105 @@
+
+#include "silhouette.h"
+#include "parallel.h"
+#include <math.h>
+#include <algorithm>
+
+
+// Finds where n.(p - eye) changes sign along the edge from vertex v0
+// to vertex v1, where it is g0 and g1 respectively.
+static void findCrossing(
+   const SurfaceMesh & mesh, const float eye[3],
+   int v0, int v1, double g0, double g1,
+   float point[3]
+) {
+   const float * p0 = mesh.vertex( v0 );
+   const float * p1 = mesh.vertex( v1 );
+   const float * n0 = mesh.normal( v0 );
+   const float * n1 = mesh.normal( v1 );
+
+   // With p and n interpolated linearly by s in [0,1],
+   // n.(p - eye) = a*s*s + b*s + c.
+   double a = 0, b = 0, c = g0;
+   for ( int i = 0; i < 3; ++i ) {
+      double dp = p1[i] - p0[i], dn = n1[i] - n0[i];
+      a += dn * dp;
+      b += n0[i] * dp + dn * ( p0[i] - eye[i] );
+   }
+
+   // Since the sign changes, there is exactly one root in [0,1].
+   double s = g0 / ( g0 - g1 );
+   if ( fabs( a ) > 1e-12 * ( fabs( b ) + fabs( c ) ) ) {
+      double discriminant = b*b - 4*a*c;
+      if ( discriminant >= 0 ) {
+         double q = -0.5 * ( b + ( b < 0 ? -1 : 1 ) * sqrt( discriminant ) );
+         double r0 = q / a, r1 = q != 0 ? c / q : r0;
+         if ( r0 >= 0 && r0 <= 1 ) s = r0;
+         else if ( r1 >= 0 && r1 <= 1 ) s = r1;
+      }
+   }
+   else if ( b != 0 ) {
+      double r = -c / b;
+      if ( r >= 0 && r <= 1 ) s = r;
+   }
+
+   for ( int i = 0; i < 3; ++i )
+      point[i] = (float)( p0[i] + s*( p1[i] - p0[i] ) );
+}
+
+void findSilhouette(
+   const SurfaceMesh & mesh,
+   const float eye[3],
+   std::vector< Polyline > & polylines,
+   int threads
+) {
+   polylines.clear();
+   int numVertices = mesh.numberOfVertices();
+   int numTriangles = mesh.numberOfTriangles();
+
+   std::vector< double > g( numVertices );
+   parallelFor( numVertices, [&]( int v, int ) {
+      const float * p = mesh.vertex( v );
+      const float * n = mesh.normal( v );
+      g[v] = n[0]*( p[0]-eye[0] ) + n[1]*( p[1]-eye[1] ) + n[2]*( p[2]-eye[2] );
+   }, threads, 1024 );
+
+   // Each triangle whose vertices are on both sides (zero counts as
+   // positive) has two edges crossing the silhouette, giving a segment.
+   // Crossings are computed from the edge's vertices in increasing order,
+   // so both triangles sharing an edge find exactly the same point.
+   const int chunkSize = 1024;
+   threads = threadsForParallelFor( numTriangles, threads, chunkSize );
+   std::vector< std::vector< CurveSegment > > found( threads );
+   parallelFor( numTriangles, [&]( int t, int thread ) {
+      const int * v = &mesh.triangles[3*t];
+      bool isFront[3];
+      for ( int i = 0; i < 3; ++i )
+         isFront[i] = g[v[i]] >= 0;
+      if ( isFront[0] == isFront[1] && isFront[1] == isFront[2] )
+         return;
+
+      CurveSegment segment;
+      int count = 0;
+      for ( int i = 0; i < 3 && count < 2; ++i ) {
+         int j = (i+1)%3;
+         if ( isFront[i] == isFront[j] )
+            continue;
+         int p = v[i], q = v[j];
+         if ( p > q ) { int tmp = p; p = q; q = tmp; }
+         findCrossing( mesh, eye, p, q, g[p], g[q], segment.point[count] );
+         segment.key[count].vertex0 = p;
+         segment.key[count].vertex1 = q;
+         segment.key[count].triangle = -1;
+         ++ count;
+      }
+      found[thread].push_back( segment );
+   }, threads, chunkSize );
+
+   std::vector< CurveSegment > segments;
+   for ( int t = 0; t < threads; ++t )
+      segments.insert( segments.end(), found[t].begin(), found[t].end() );
+   // Independent of how the work was divided among threads.
+   std::sort( segments.begin(), segments.end() );
+
+   chainCurveSegments( segments, polylines );
+}
@@ -0,0 +1,28 @@
+
+#ifndef SILHOUETTE_H
+#define SILHOUETTE_H
+
+
+#include "surfaceMesh.h"
+
+
+// Finds the silhouette (contour generator) of the mesh seen from
+// the given eye point, i.e. where the normal becomes perpendicular
+// to the direction of view, as a set of polylines.
+// The sign of n.(p - eye) is computed at every vertex from its normal,
+// and where it changes along an edge, the normal and location are
+// interpolated linearly along the edge, and the crossing is found
+// exactly as the root of the resulting quadratic
+// (rather than by interpolating n.(p - eye) itself, which is much
+// less accurate where the normal turns quickly).
+// Vertices and triangles are processed in parallel by the given
+// number of threads (0 means one per core).
+void findSilhouette(
+   const SurfaceMesh & mesh,
+   const float eye[3],
+   std::vector< Polyline > & polylines,
+   int threads = 0
+);
+
+
+#endif /* SILHOUETTE_H */
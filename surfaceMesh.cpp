@@ -0,0 +1,271 @@
+
+#include "surfaceMesh.h"
+#include <math.h>
+#include <stdio.h>
+#include <unordered_map>
+#include <algorithm>
+
+#ifdef _WIN32
+#define M_PI 3.1415926535897932384626433832795
+#endif
+
+
+void stripInstanceRotation(
+   int hemisphere, int strip, int numStrips, float rotation[9]
+) {
+   // Same as glRotatef(hemisphere*180,0,1,0) followed by
+   // glRotatef((hemisphere == 0 ? -strip : strip+1)*360/numStrips,0,0,1)
+   double angle = (hemisphere == 0 ? -strip : strip+1) * 2*M_PI / numStrips;
+   float c = (float)cos( angle ), s = (float)sin( angle );
+   float flip = hemisphere == 0 ? 1.0f : -1.0f;
+
+   rotation[0] = flip*c;  rotation[1] = -flip*s;  rotation[2] = 0;
+   rotation[3] = s;       rotation[4] = c;        rotation[5] = 0;
+   rotation[6] = 0;       rotation[7] = 0;        rotation[8] = flip;
+}
+
+// Finds vertices closer than a tolerance to each other,
+// by hashing them into cells as wide as the tolerance.
+class VertexWelder {
+   float _tolerance;
+   std::vector< float > & _vertices;
+   std::unordered_map< unsigned long long, int > _firstInCell;
+   std::vector< int > _nextInCell;
+
+   unsigned long long key( long long i, long long j, long long k ) const {
+      const long long mask = ( 1 << 21 ) - 1;
+      return ( ( i & mask ) << 42 ) | ( ( j & mask ) << 21 ) | ( k & mask );
+   }
+public:
+   VertexWelder( std::vector< float > & vertices, float tolerance )
+      : _tolerance( tolerance ), _vertices( vertices ) { }
+
+   // Adds p as a new vertex, which is never welded to anything,
+   // and returns its index.
+   int add( const float * p ) {
+      int v = (int)_nextInCell.size();
+      _vertices.push_back( p[0] );
+      _vertices.push_back( p[1] );
+      _vertices.push_back( p[2] );
+      _nextInCell.push_back( -1 );
+      return v;
+   }
+
+   // Returns the index of a vertex within the tolerance of p,
+   // adding p as a new vertex if there is none.
+   int weld( const float * p ) {
+      long long i = (long long)floor( p[0] / _tolerance );
+      long long j = (long long)floor( p[1] / _tolerance );
+      long long k = (long long)floor( p[2] / _tolerance );
+      for ( int di = -1; di <= 1; ++di )
+         for ( int dj = -1; dj <= 1; ++dj )
+            for ( int dk = -1; dk <= 1; ++dk ) {
+               std::unordered_map< unsigned long long, int >::const_iterator it
+                  = _firstInCell.find( key( i+di, j+dj, k+dk ) );
+               if ( it == _firstInCell.end() ) continue;
+               for ( int v = it->second; v >= 0; v = _nextInCell[v] ) {
+                  const float * q = &_vertices[3*v];
+                  if (
+                     fabs( p[0]-q[0] ) <= _tolerance
+                     && fabs( p[1]-q[1] ) <= _tolerance
+                     && fabs( p[2]-q[2] ) <= _tolerance
+                  )
+                     return v;
+               }
+            }
+
+      int v = (int)_nextInCell.size();
+      _vertices.push_back( p[0] );
+      _vertices.push_back( p[1] );
+      _vertices.push_back( p[2] );
+      unsigned long long cell = key( i, j, k );
+      std::unordered_map< unsigned long long, int >::iterator it
+         = _firstInCell.find( cell );
+      if ( it == _firstInCell.end() ) {
+         _nextInCell.push_back( -1 );
+         _firstInCell[ cell ] = v;
+      }
+      else {
+         _nextInCell.push_back( it->second );
+         it->second = v;
+      }
+      return v;
+   }
+};
+
+// The body of both versions of buildSurfaceMesh(),
+// for any type of sample with vertex[3] and normal[3] members.
+template < class Sample >
+static void buildSurfaceMeshFromSamples(
+   Sample ** grid, int rows, int columns,
+   int numStrips,
+   SurfaceMesh * mesh,
+   float weldTolerance
+) {
+   mesh->vertices.clear();
+   mesh->normals.clear();
+   mesh->triangles.clear();
+   mesh->triangleRow.clear();
+   mesh->triangleColumn.clear();
+   mesh->triangleHemisphere.clear();
+   mesh->triangleStrip.clear();
+   mesh->triangleSamples.clear();
+
+   VertexWelder welder( mesh->vertices, weldTolerance );
+   std::vector< int > index( ( rows+1 ) * ( columns+1 ) );
+   float rotation[9];
+
+   for ( int hemisphere = 0; hemisphere < NumHemispheres; ++hemisphere ) {
+      for ( int strip = 0; strip < numStrips; ++strip ) {
+         stripInstanceRotation( hemisphere, strip, numStrips, rotation );
+         for ( int j = 0; j <= rows; ++j )
+            for ( int k = 0; k <= columns; ++k ) {
+               const float * v = grid[j][k].vertex;
+               const float * n = grid[j][k].normal;
+               float p[3], pn[3];
+               for ( int i = 0; i < 3; ++i ) {
+                  p[i] = rotation[3*i]*v[0] + rotation[3*i+1]*v[1]
+                     + rotation[3*i+2]*v[2];
+                  pn[i] = rotation[3*i]*n[0] + rotation[3*i+1]*n[1]
+                     + rotation[3*i+2]*n[2];
+               }
+               // Only samples on the boundary of the strip are shared
+               // with other copies of it (or collapse, at the poles).
+               bool isOnBoundary = j == 0 || j == rows || k == 0 || k == columns;
+               int w = isOnBoundary ? welder.weld( p ) : welder.add( p );
+               if ( w == (int)mesh->normals.size() / 3 )
+                  mesh->normals.insert( mesh->normals.end(), pn, pn+3 );
+               index[ j*(columns+1) + k ] = w;
+            }
+
+         // Same triangles as the triangle strips of EvertableSphere::Draw()
+         for ( int j = 0; j < rows; ++j )
+            for ( int k = 0; k < columns; ++k ) {
+               int a = j*(columns+1) + k;
+               int b = (j+1)*(columns+1) + k;
+               int c = j*(columns+1) + k+1;
+               int d = (j+1)*(columns+1) + k+1;
+               int triangle[2][3] = { { a, b, c }, { c, b, d } };
+               for ( int t = 0; t < 2; ++t ) {
+                  int * sample = triangle[t];
+                  int v[3];
+                  for ( int i = 0; i < 3; ++i )
+                     v[i] = index[ sample[i] ];
+                  if ( v[0] == v[1] || v[1] == v[2] || v[2] == v[0] )
+                     continue;
+                  for ( int i = 0; i < 3; ++i ) {
+                     mesh->triangles.push_back( v[i] );
+                     mesh->triangleSamples.push_back( sample[i] );
+                  }
+                  mesh->triangleRow.push_back( j );
+                  mesh->triangleColumn.push_back( k );
+                  mesh->triangleHemisphere.push_back( hemisphere );
+                  mesh->triangleStrip.push_back( strip );
+               }
+            }
+      }
+   }
+}
+
+void buildSurfaceMesh(
+   GLPoint ** grid, int rows, int columns,
+   int numStrips,
+   SurfaceMesh * mesh,
+   float weldTolerance
+) {
+   buildSurfaceMeshFromSamples(
+      grid, rows, columns, numStrips, mesh, weldTolerance
+   );
+}
+
+void buildSurfaceMesh(
+   GLJetPoint ** grid, int rows, int columns,
+   int numStrips,
+   SurfaceMesh * mesh,
+   float weldTolerance
+) {
+   buildSurfaceMeshFromSamples(
+      grid, rows, columns, numStrips, mesh, weldTolerance
+   );
+}
+
+// Chains segments that share an endpoint into polylines.
+void chainCurveSegments(
+   const std::vector< CurveSegment > & segments,
+   std::vector< Polyline > & polylines
+) {
+   int n = (int)segments.size();
+
+   // Pair up the ends (2*segment + end) that have the same key.
+   std::vector< std::pair< CurvePointKey, int > > ends( 2*n );
+   for ( int i = 0; i < n; ++i )
+      for ( int e = 0; e < 2; ++e )
+         ends[2*i+e] = std::make_pair( segments[i].key[e], 2*i+e );
+   std::sort( ends.begin(), ends.end() );
+   std::vector< int > link( 2*n, -1 );
+   for ( int i = 0; i+1 < 2*n; ++i )
+      if ( ends[i].first == ends[i+1].first ) {
+         int a = ends[i].second, b = ends[i+1].second;
+         if ( a/2 != b/2 && link[a] < 0 && link[b] < 0 ) {
+            link[a] = b;
+            link[b] = a;
+         }
+      }
+
+   std::vector< bool > used( n, false );
+   // First the open polylines, starting from an unlinked end,
+   // then the closed ones, starting anywhere.
+   for ( int pass = 0; pass < 2; ++pass )
+      for ( int start = 0; start < 2*n; ++start ) {
+         if ( used[start/2] || ( pass == 0 && link[start] >= 0 ) )
+            continue;
+         Polyline polyline;
+         polyline.isClosed = false;
+         const float * p = segments[start/2].point[start%2];
+         polyline.points.insert( polyline.points.end(), p, p+3 );
+         int end = start;
+         for (;;) {
+            int s = end/2, other = end ^ 1;
+            used[s] = true;
+            int next = link[other];
+            if ( next >= 0 && next/2 == start/2 ) {
+               polyline.isClosed = true;
+               break;
+            }
+            p = segments[s].point[other%2];
+            polyline.points.insert( polyline.points.end(), p, p+3 );
+            if ( next < 0 || used[next/2] )
+               break;
+            end = next;
+         }
+         polylines.push_back( polyline );
+      }
+}
+
+bool writePolylinesAsOBJ(
+   const char * fileName, const std::vector< Polyline > & polylines
+) {
+   FILE * file = fopen( fileName, "w" );
+   if ( file == 0 )
+      return false;
+
+   int first = 1;
+   for ( int i = 0; i < (int)polylines.size(); ++i ) {
+      const Polyline & polyline = polylines[i];
+      int n = polyline.numberOfPoints();
+      for ( int j = 0; j < n; ++j )
+         fprintf( file, "v %g %g %g\n", polyline.points[3*j],
+            polyline.points[3*j+1], polyline.points[3*j+2] );
+      fprintf( file, "l" );
+      for ( int j = 0; j < n; ++j )
+         fprintf( file, " %d", first + j );
+      if ( polyline.isClosed && n > 0 )
+         fprintf( file, " %d", first );
+      fprintf( file, "\n" );
+      first += n;
+   }
+
+   bool failed = ferror( file ) != 0;
+   if ( fclose( file ) != 0 ) failed = true;
+   return ! failed;
+}
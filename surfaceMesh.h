@@ -0,0 +1,121 @@
+
+#ifndef SURFACEMESH_H
+#define SURFACEMESH_H
+
+
+#include "generateGeometry.h"
+#include <vector>
+
+
+// generateGeometry() computes one strip of one hemisphere.
+// The whole sphere is made of NumHemispheres * numStrips copies of it,
+// each rotated about the origin as given by stripInstanceRotation().
+
+const int NumHemispheres = 2;
+
+// Fills in the 3x3 rotation matrix (row-major) that takes the strip
+// computed by generateGeometry() to the given strip of the given hemisphere.
+// This is the same transformation applied with glRotatef() when drawing.
+void stripInstanceRotation(
+   int hemisphere, int strip, int numStrips, float rotation[9]
+);
+
+// A triangle mesh of the whole sphere, with the vertices shared by
+// adjacent copies of the strip welded together,
+// so that adjacency can be found by comparing vertex indices.
+struct SurfaceMesh {
+   std::vector< float > vertices;   // x,y,z of each vertex
+   std::vector< float > normals;    // x,y,z of the normal at each vertex
+   std::vector< int > triangles;    // 3 vertex indices per triangle
+
+   // For each triangle, the sample (row j, column k) of the strip's grid
+   // at the corner of the patch it belongs to, and the copy of the strip.
+   std::vector< int > triangleRow, triangleColumn;
+   std::vector< int > triangleHemisphere, triangleStrip;
+
+   // For each corner of each triangle (3 per triangle),
+   // the sample of the strip's grid it came from, as j*(1+columns)+k.
+   std::vector< int > triangleSamples;
+
+   int numberOfVertices() const { return (int)vertices.size() / 3; }
+   int numberOfTriangles() const { return (int)triangles.size() / 3; }
+   const float * vertex( int i ) const { return &vertices[3*i]; }
+   const float * normal( int i ) const { return &normals[3*i]; }
+};
+
+// Builds the mesh of the whole sphere from the (1+rows) by (1+columns)
+// grid of one strip, triangulating each patch as it is drawn.
+// Vertices on the boundary of the strip closer than weldTolerance
+// are welded, and triangles degenerated by welding (e.g. at the poles)
+// are dropped. Samples inside the strip are never welded, even where
+// they happen to coincide with another sheet of the surface.
+// A welded vertex gets the normal of the first sample welded into it.
+void buildSurfaceMesh(
+   GLPoint ** grid, int rows, int columns,
+   int numStrips,
+   SurfaceMesh * mesh,
+   float weldTolerance = 1e-5f
+);
+
+// Same as above, from a grid of GLJetPoints.
+void buildSurfaceMesh(
+   GLJetPoint ** grid, int rows, int columns,
+   int numStrips,
+   SurfaceMesh * mesh,
+   float weldTolerance = 1e-5f
+);
+
+// A polygonal curve, e.g. for rendering or export.
+struct Polyline {
+   std::vector< float > points;   // x,y,z of each point
+   bool isClosed;                 // if true, the last point connects to the first
+
+   int numberOfPoints() const { return (int)points.size() / 3; }
+};
+
+// Identifies a point where a curve on the mesh crosses an edge of the mesh.
+// Curves found one triangle at a time produce the same key for
+// the same point in each of the triangles sharing the edge,
+// which is how their segments are chained into polylines.
+struct CurvePointKey {
+   int vertex0, vertex1;   // the edge, with vertex0 < vertex1
+   int triangle;           // the triangle crossed by the edge, if that
+                           // is needed to tell points apart; -1 otherwise
+
+   bool operator<( const CurvePointKey & k ) const {
+      if ( vertex0 != k.vertex0 ) return vertex0 < k.vertex0;
+      if ( vertex1 != k.vertex1 ) return vertex1 < k.vertex1;
+      return triangle < k.triangle;
+   }
+   bool operator==( const CurvePointKey & k ) const {
+      return vertex0 == k.vertex0 && vertex1 == k.vertex1
+         && triangle == k.triangle;
+   }
+};
+
+// A piece of a curve on the mesh, between two keyed points.
+struct CurveSegment {
+   float point[2][3];
+   CurvePointKey key[2];
+
+   bool operator<( const CurveSegment & s ) const {
+      if ( ! ( key[0] == s.key[0] ) ) return key[0] < s.key[0];
+      return key[1] < s.key[1];
+   }
+};
+
+// Chains segments that share an endpoint into polylines,
+// appending them to polylines.
+void chainCurveSegments(
+   const std::vector< CurveSegment > & segments,
+   std::vector< Polyline > & polylines
+);
+
+// Writes polylines to a file in Wavefront OBJ format (v and l records).
+// Returns false if the file could not be written.
+bool writePolylinesAsOBJ(
+   const char * fileName, const std::vector< Polyline > & polylines
+);
+
+
+#endif /* SURFACEMESH_H */
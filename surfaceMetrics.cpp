@@ -0,0 +1,120 @@
+
+#include "surfaceMetrics.h"
+#include "surfaceMesh.h"
+#include "parallel.h"
+#include <math.h>
+#include <vector>
+
+
+// Adds the area, 6 times the signed volume of the cone from the origin,
+// and the bending energy of the triangle (a,b,c) to sum[].
+static inline void accumulateTriangle(
+   const GLPoint & a, const GLPoint & b, const GLPoint & c, double sum[3]
+) {
+   double e1[3], e2[3], d1[3], d2[3], cross[3];
+   for ( int i = 0; i < 3; ++i ) {
+      e1[i] = b.vertex[i] - a.vertex[i];
+      e2[i] = c.vertex[i] - a.vertex[i];
+      d1[i] = b.normal[i] - a.normal[i];
+      d2[i] = c.normal[i] - a.normal[i];
+   }
+   cross[0] = e1[1]*e2[2] - e1[2]*e2[1];
+   cross[1] = e1[2]*e2[0] - e1[0]*e2[2];
+   cross[2] = e1[0]*e2[1] - e1[1]*e2[0];
+   double doubleArea = sqrt(
+      cross[0]*cross[0] + cross[1]*cross[1] + cross[2]*cross[2]
+   );
+
+   sum[0] += 0.5 * doubleArea;
+   sum[1] += a.vertex[0]*cross[0] + a.vertex[1]*cross[1] + a.vertex[2]*cross[2];
+   if ( doubleArea == 0 )
+      return;
+
+   // The normal interpolated linearly over the triangle has a constant
+   // derivative D (3x2 in the edge coordinates), whose squared norm
+   // is trace( D G^-1 D^T ), with G the Gram matrix of the edges.
+   double g11 = e1[0]*e1[0] + e1[1]*e1[1] + e1[2]*e1[2];
+   double g12 = e1[0]*e2[0] + e1[1]*e2[1] + e1[2]*e2[2];
+   double g22 = e2[0]*e2[0] + e2[1]*e2[1] + e2[2]*e2[2];
+   double det = g11*g22 - g12*g12;   // = doubleArea^2
+   if ( det <= 0 )
+      return;
+   double trace = 0;
+   for ( int i = 0; i < 3; ++i )
+      trace += g22*d1[i]*d1[i] - 2*g12*d1[i]*d2[i] + g11*d2[i]*d2[i];
+   sum[2] += 0.5 * doubleArea * trace / det;
+}
+
+SurfaceMetricsAccumulator::SurfaceMetricsAccumulator( int numStrips, int threads )
+   : _copies( NumHemispheres * numStrips ), _threads( threads )
+{
+   reset();
+}
+
+void SurfaceMetricsAccumulator::reset() {
+   _sum[0] = _sum[1] = _sum[2] = 0;
+}
+
+void SurfaceMetricsAccumulator::consumeTile( const GeometryTile & tile ) {
+   int rows = tile.rowCount - 1, columns = tile.columnCount - 1;
+   if ( rows <= 0 || columns <= 0 )
+      return;
+
+   std::vector< double > rowSums( 3*rows, 0.0 );
+   parallelFor( rows, [&]( int j, int ) {
+      double * sum = &rowSums[3*j];
+      const GLPoint * row = tile.points[j];
+      const GLPoint * nextRow = tile.points[j+1];
+      // Same triangles as the triangle strips of EvertableSphere::Draw()
+      for ( int k = 0; k < columns; ++k ) {
+         accumulateTriangle( row[k], nextRow[k], row[k+1], sum );
+         accumulateTriangle( row[k+1], nextRow[k], nextRow[k+1], sum );
+      }
+   }, _threads, 4 );
+
+   for ( int j = 0; j < rows; ++j )
+      for ( int i = 0; i < 3; ++i )
+         _sum[i] += rowSums[3*j+i];
+}
+
+SurfaceMetrics SurfaceMetricsAccumulator::metrics() const {
+   SurfaceMetrics m;
+   m.area = _copies * _sum[0];
+   // The triangles as drawn face into the sphere at time 0.
+   m.volume = - _copies * _sum[1] / 6;
+   m.bendingEnergy = _copies * _sum[2];
+   return m;
+}
+
+void computeSurfaceMetrics(
+   SurfaceMetrics * metrics,
+   int tileRows,
+   int tileColumns,
+   int threads,
+
+   double time,
+   int numStrips,
+   int u_count,
+   int v_count,
+
+   SampleSpacing spacing,
+
+   double bendtime,
+
+   double corrStart,
+   double pushStart,
+   double twistStart,
+   double unpushStart,
+   double uncorrStart
+) {
+   SurfaceMetricsAccumulator accumulator( numStrips, threads );
+   generateGeometryTiled(
+      &accumulator, tileRows, tileColumns,
+      time, numStrips,
+      0.0, u_count, 1.0,
+      0.0, v_count, 1.0,
+      spacing, bendtime,
+      corrStart, pushStart, twistStart, unpushStart, uncorrStart
+   );
+   *metrics = accumulator.metrics();
+}
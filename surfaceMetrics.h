@@ -0,0 +1,69 @@
+
+#ifndef SURFACEMETRICS_H
+#define SURFACEMETRICS_H
+
+
+#include "generateGeometry.h"
+
+
+// Global measures of the whole sphere at one time,
+// computed from the triangles of the sample grid of one strip
+// (triangulated as it is drawn), times the number of copies of it.
+struct SurfaceMetrics {
+   double area;            // total area
+   double volume;          // signed volume enclosed, i.e. (1/3) of the integral
+                           // of p.n over the surface, where n is the normal
+                           // pointing out of the sphere at time 0; so positive
+                           // at time 0, and negative once the sphere is everted
+   double bendingEnergy;   // integral of the squared norm of the derivative
+                           // of the normal (k1^2 + k2^2, 8 pi for a round
+                           // sphere), a proxy for the bending energy,
+                           // with the normals interpolated linearly
+                           // over each triangle
+};
+
+// Accumulates the metrics of the whole sphere from the tiles of one strip,
+// so that they can be computed at any resolution without holding the grid.
+// The rows of each tile are reduced in parallel by the given number
+// of threads (0 means one per core), and the partial sums are added
+// in a fixed order, so the result does not depend on the number of threads.
+// The grid must cover the whole strip (v in [0,1]).
+class SurfaceMetricsAccumulator : public GeometryTileSink {
+   int _copies;
+   int _threads;
+   double _sum[3];   // area, -6*volume, bendingEnergy of one strip
+public:
+   SurfaceMetricsAccumulator( int numStrips, int threads = 0 );
+
+   // Forgets all tiles consumed so far, e.g. to start the next time step.
+   void reset();
+   void consumeTile( const GeometryTile & tile );
+   SurfaceMetrics metrics() const;
+};
+
+// Computes the metrics of the sphere at the given time, from
+// a (1 + u_count) by (1 + v_count) grid of samples generated tile by tile.
+void computeSurfaceMetrics(
+   SurfaceMetrics * metrics,
+   int tileRows,
+   int tileColumns,
+   int threads = 0,
+
+   double time = 0.0,
+   int numStrips = 8,
+   int u_count = 12,
+   int v_count = 12,
+
+   SampleSpacing spacing = SPACING_UNIFORM,
+
+   double bendtime = -1.0,
+
+   double corrStart   = 0.00,
+   double pushStart   = 0.10,
+   double twistStart  = 0.23,
+   double unpushStart = 0.60,
+   double uncorrStart = 0.93
+);
+
+
+#endif /* SURFACEMETRICS_H */
@@ -0,0 +1,285 @@
+
+#include "tuneGeometry.h"
+#include "generateGeometry.h"
+#include "parallel.h"
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#endif
+
+
+// Calibrating on bigger grids takes longer, but hardly changes the answer.
+const int MaximumTunedPatches = 256;
+// Each candidate is timed over at least this many grids and milliseconds.
+const int MinimumRepetitions = 2;
+const double MinimumMilliseconds = 30;
+// The time at which the surface is sampled, in the middle of the twist.
+const double TunedTime = 0.4;
+
+bool applyGeometryConfiguration( const GeometryConfiguration & configuration ) {
+   if ( ! setGeometryKernel( configuration.kernel ) )
+      return false;
+   setSamplingThreads(
+      configuration.threads,
+      configuration.tileRows, configuration.tileColumns
+   );
+   // The viewer applies it for every frame, so it is only logged
+   // when the kernel changes.
+   static std::string loggedKernel;
+   if ( loggedKernel != configuration.kernel ) {
+      loggedKernel = configuration.kernel;
+      logGeometryKernel( "the fastest found by tuning" );
+   }
+   return true;
+}
+
+const char * tuningCacheFileName() {
+   static std::string fileName;
+   if ( fileName.empty() ) {
+      std::string directory;
+#ifdef _WIN32
+      const char * appData = getenv( "APPDATA" );
+      if ( appData == NULL || appData[0] == '\0' )
+         return NULL;
+      directory = std::string( appData ) + "\\sphereEversion";
+      _mkdir( directory.c_str() );
+      fileName = directory + "\\tuning.txt";
+#else
+      const char * config = getenv( "XDG_CONFIG_HOME" );
+      if ( config != NULL && config[0] != '\0' )
+         directory = config;
+      else {
+         const char * home = getenv( "HOME" );
+         if ( home == NULL || home[0] == '\0' )
+            return NULL;
+         directory = std::string( home ) + "/.config";
+      }
+      mkdir( directory.c_str(), 0755 );
+      directory += "/sphereEversion";
+      mkdir( directory.c_str(), 0755 );
+      fileName = directory + "/tuning.txt";
+#endif
+   }
+   return fileName.c_str();
+}
+
+// The key under which the configuration is cached: cores, kernels
+// considered, and log2 of the number of samples, separated by spaces.
+static std::string cacheKey( int u_count, int v_count, const char * kernel ) {
+   std::string kernels;
+   if ( kernel != NULL )
+      kernels = kernel;
+   else {
+      const char * names[8];
+      int count = getGeometryKernels( names, 8 );
+      for ( int i = 0; i < count; ++i )
+         kernels += std::string( i > 0 ? "," : "" ) + names[i];
+   }
+   double samples = (double)( 1 + u_count ) * ( 1 + v_count );
+   int sizeClass = 0;
+   while ( samples >= 2 ) {
+      samples /= 2;
+      ++ sizeClass;
+   }
+   char key[128];
+   snprintf( key, sizeof(key), "%d %s %d",
+      numberOfThreads(), kernels.c_str(), sizeClass );
+   return key;
+}
+
+// Lines of the cache file are the key, then the configuration.
+static bool readCache( const std::string & key, GeometryConfiguration * c ) {
+   const char * fileName = tuningCacheFileName();
+   FILE * file = fileName != NULL ? fopen( fileName, "r" ) : NULL;
+   if ( file == NULL )
+      return false;
+   bool found = false;
+   char line[256];
+   while ( ! found && fgets( line, sizeof(line), file ) != NULL ) {
+      if ( strncmp( line, key.c_str(), key.size() ) != 0
+            || line[ key.size() ] != ' ' )
+         continue;
+      found = sscanf( line + key.size(), "%15s %d %d %d %lf",
+         c->kernel, &c->threads, &c->tileRows, &c->tileColumns,
+         &c->nanosecondsPerSample ) == 5;
+   }
+   fclose( file );
+   return found;
+}
+
+static void writeCache( const std::string & key, const GeometryConfiguration & c ) {
+   const char * fileName = tuningCacheFileName();
+   if ( fileName == NULL )
+      return;
+
+   // Keep the other entries.
+   std::vector< std::string > lines;
+   FILE * file = fopen( fileName, "r" );
+   if ( file != NULL ) {
+      char line[256];
+      while ( fgets( line, sizeof(line), file ) != NULL )
+         if ( line[0] != '#' && (
+               strncmp( line, key.c_str(), key.size() ) != 0
+               || line[ key.size() ] != ' '
+         ) )
+            lines.push_back( line );
+      fclose( file );
+   }
+   file = fopen( fileName, "w" );
+   if ( file == NULL )
+      return;
+   fprintf( file, "# sphereEversion tuning: cores kernels log2(samples)"
+      " kernel threads tileRows tileColumns ns/sample\n" );
+   for ( size_t i = 0; i < lines.size(); ++i )
+      fputs( lines[i].c_str(), file );
+   fprintf( file, "%s %s %d %d %d %.1f\n", key.c_str(),
+      c.kernel, c.threads, c.tileRows, c.tileColumns, c.nanosecondsPerSample );
+   fclose( file );
+}
+
+// Times the sampling of the grid with the given configuration,
+// and keeps it as the best one if it is faster.
+// Returns false if its kernel is unknown or not supported.
+static bool timeConfiguration(
+   GeometryConfiguration & c, GeometryConfiguration * best,
+   GLPoint ** grid, int u_count, int v_count, int numStrips,
+   FILE * log
+) {
+   if ( ! setGeometryKernel( c.kernel ) )
+      return false;
+   setSamplingThreads( c.threads, c.tileRows, c.tileColumns );
+   double fastest = 0, total = 0;
+   for ( int i = 0; i < MinimumRepetitions || total < MinimumMilliseconds; ++i ) {
+      std::chrono::steady_clock::time_point start
+         = std::chrono::steady_clock::now();
+      generateGeometry( grid, TunedTime, numStrips,
+         0.0, u_count, 1.0, 0.0, v_count, 1.0 );
+      double milliseconds = std::chrono::duration< double, std::milli >(
+         std::chrono::steady_clock::now() - start
+      ).count();
+      total += milliseconds;
+      if ( i == 0 || milliseconds < fastest )
+         fastest = milliseconds;
+   }
+   c.nanosecondsPerSample = 1e6 * fastest / ( ( 1 + u_count ) * ( 1 + v_count ) );
+   if ( log != NULL )
+      fprintf( log, "  %-8s %3d threads, tiles of %3d x %3d: %8.1f ns/sample\n",
+         c.kernel, c.threads, c.tileRows, c.tileColumns, c.nanosecondsPerSample );
+   if ( best->nanosecondsPerSample <= 0
+         || c.nanosecondsPerSample < best->nanosecondsPerSample )
+      *best = c;
+   return true;
+}
+
+void tuneGeometry(
+   GeometryConfiguration * configuration,
+   int u_count,
+   int v_count,
+   int numStrips,
+   bool useCache,
+   const char * kernel,
+   FILE * log
+) {
+   // A kernel asked for in the environment is the only one considered,
+   // unless it is unknown or unsupported, in which case the one
+   // used instead is (see getDefaultGeometryKernel()).
+   const char * environmentKernel = getenv( "SPHERE_EVERSION_KERNEL" );
+   if ( kernel == NULL && environmentKernel != NULL && environmentKernel[0] != '\0' )
+      kernel = getDefaultGeometryKernel();
+
+   // The last answer is kept, so that the file is only read
+   // when the size of the grid changes.
+   static std::string lastKey;
+   static GeometryConfiguration lastConfiguration;
+   std::string key = cacheKey( u_count, v_count, kernel );
+   if ( useCache && ( key == lastKey || readCache( key, configuration ) ) ) {
+      if ( key == lastKey )
+         *configuration = lastConfiguration;
+      // A cached kernel that cannot be used is tuned again.
+      if ( applyGeometryConfiguration( *configuration ) ) {
+         lastKey = key;
+         lastConfiguration = *configuration;
+         return;
+      }
+   }
+
+   if ( u_count > MaximumTunedPatches ) u_count = MaximumTunedPatches;
+   if ( v_count > MaximumTunedPatches ) v_count = MaximumTunedPatches;
+   if ( u_count < 1 ) u_count = 1;
+   if ( v_count < 1 ) v_count = 1;
+   int rows = 1 + u_count, columns = 1 + v_count;
+   std::vector< GLPoint > samples( rows * columns );
+   std::vector< GLPoint * > grid( rows );
+   for ( int j = 0; j < rows; ++j )
+      grid[j] = &samples[ j * columns ];
+   if ( log != NULL )
+      fprintf( log, "Tuning the sampling of %d x %d samples:\n", rows, columns );
+
+   GeometryConfiguration best, c;
+   best.nanosecondsPerSample = 0;
+
+   // The kernel, on one thread.
+   const char * kernels[8];
+   int numKernels = 0;
+   if ( kernel != NULL )
+      kernels[ numKernels++ ] = kernel;
+   else
+      numKernels = getGeometryKernels( kernels, 8 );
+   c.threads = 1;
+   c.tileRows = c.tileColumns = 0;
+   for ( int i = 0; i < numKernels; ++i ) {
+      snprintf( c.kernel, sizeof(c.kernel), "%s", kernels[i] );
+      if ( ! timeConfiguration( c, &best, &grid[0], u_count, v_count, numStrips, log ) ) {
+         fprintf( stderr, "sphereEversion: kernel %s is unknown or not supported,"
+            " so the sampling is not tuned\n", c.kernel );
+         snprintf( configuration->kernel, sizeof(configuration->kernel),
+            "%s", getGeometryKernel() );
+         getSamplingThreads( &configuration->threads,
+            &configuration->tileRows, &configuration->tileColumns );
+         configuration->nanosecondsPerSample = 0;
+         return;
+      }
+   }
+
+   // The number of threads, each with one band of rows.
+   c = best;
+   int cores = numberOfThreads();
+   std::vector< int > threadCounts;
+   for ( int threads = 2; threads < cores; threads *= 2 )
+      threadCounts.push_back( threads );
+   if ( cores > 1 )
+      threadCounts.push_back( cores );
+   for ( size_t i = 0; i < threadCounts.size(); ++i ) {
+      c.threads = threadCounts[i];
+      c.tileRows = ( rows + c.threads - 1 ) / c.threads;
+      timeConfiguration( c, &best, &grid[0], u_count, v_count, numStrips, log );
+   }
+
+   // The shape of the tiles, for that number of threads.
+   c = best;
+   const int tileRows[] = { 1, 2, 4, 8, 16, 32, 64 };
+   const int tileColumns[] = { 0, 64 };
+   for ( int j = 0; j < (int)( sizeof(tileRows) / sizeof(tileRows[0]) ); ++j )
+      for ( int k = 0; k < (int)( sizeof(tileColumns) / sizeof(tileColumns[0]) ); ++k ) {
+         if ( tileRows[j] >= rows || tileColumns[k] >= columns )
+            continue;
+         if ( tileRows[j] == best.tileRows && tileColumns[k] == best.tileColumns )
+            continue;
+         c.tileRows = tileRows[j];
+         c.tileColumns = tileColumns[k];
+         timeConfiguration( c, &best, &grid[0], u_count, v_count, numStrips, log );
+      }
+
+   *configuration = best;
+   applyGeometryConfiguration( best );
+   lastKey = key;
+   lastConfiguration = best;
+   writeCache( key, best );
+   if ( log != NULL && tuningCacheFileName() != NULL )
+      fprintf( log, "Saved in %s\n", tuningCacheFileName() );
+}
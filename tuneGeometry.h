@@ -0,0 +1,51 @@
+
+#ifndef TUNEGEOMETRY_H
+#define TUNEGEOMETRY_H
+
+
+#include <stdio.h>
+
+
+// A way of sampling the surface; see setGeometryKernel()
+// and setSamplingThreads() in generateGeometry.h.
+struct GeometryConfiguration {
+   char kernel[16];
+   int threads;
+   int tileRows, tileColumns;     // samples per tile; 0 means all
+   double nanosecondsPerSample;   // as timed when it was picked
+};
+
+// Returns false, leaving everything unchanged, if its kernel
+// is unknown or not supported; logs the kernel when it changes.
+bool applyGeometryConfiguration( const GeometryConfiguration & configuration );
+
+// Finds the fastest configuration for sampling grids of about
+// (1 + u_count) by (1 + v_count) samples on this machine, and applies it.
+// The answer is looked up in a small cache file (see tuningCacheFileName()),
+// under the number of cores, the kernels considered, and the number
+// of samples rounded down to a power of 2.
+// If it is not there, or useCache is false, candidate configurations
+// are timed, one setting at a time (kernel, then threads, then tiles),
+// on a grid of at most 257 by 257 samples, which takes about a second,
+// and the answer is written to the cache.
+// Only the given kernel is considered, unless it is NULL, in which case
+// only the one named by SPHERE_EVERSION_KERNEL is, if that is set
+// (or the one used instead, if it is unknown or unsupported).
+// If the given kernel is unknown or unsupported, nothing is tuned.
+// What is done is logged to the given file, unless it is NULL.
+void tuneGeometry(
+   GeometryConfiguration * configuration,
+   int u_count,
+   int v_count,
+   int numStrips = 8,
+   bool useCache = true,
+   const char * kernel = NULL,
+   FILE * log = NULL
+);
+
+// The file caching the results of tuneGeometry(), in the user's
+// configuration directory, or NULL if there is no such directory.
+const char * tuningCacheFileName();
+
+
+#endif /* TUNEGEOMETRY_H */
@@ -0,0 +1,316 @@
+
+#include "verifyGeometry.h"
+#include "generateGeometry.h"
+#include "referenceGeometry.h"
+#include "packedGeometry.h"
+#include <math.h>
+#include <string.h>
+#include <vector>
+#include <string>
+#include <random>
+
+
+const int NumStages = 5;
+static const char * const stageNames[NumStages] = {
+   "corrugate", "push", "twist", "unpush", "uncorrugate"
+};
+static const double stageStarts[NumStages+1] = {
+   0.00, 0.10, 0.23, 0.60, 0.93, 1.00
+};
+
+// A (1 + rowCount) by (1 + columnCount) grid of samples.
+struct SampleGrid {
+   int rowCount, columnCount;
+   std::vector< GLPoint > samples;
+   std::vector< GLPoint * > rows;
+
+   SampleGrid( int r, int c )
+      : rowCount( r ), columnCount( c ),
+        samples( ( r+1 ) * ( c+1 ) ), rows( r+1 )
+   {
+      for ( int j = 0; j <= r; ++j )
+         rows[j] = &samples[ j * ( c+1 ) ];
+   }
+   GLPoint ** matrix() { return &rows[0]; }
+};
+
+// Copies the tiles it is given into a grid.
+class GridAssembler : public GeometryTileSink {
+   SampleGrid & _grid;
+public:
+   GridAssembler( SampleGrid & grid ) : _grid( grid ) { }
+   void consumeTile( const GeometryTile & tile ) {
+      for ( int j = 0; j < tile.rowCount; ++j )
+         for ( int k = 0; k < tile.columnCount; ++k )
+            _grid.rows[ tile.firstRow + j ][ tile.firstColumn + k ]
+               = tile.points[j][k];
+   }
+};
+
+// The distances between the samples of a path and of the reference.
+struct SampleErrors {
+   long count;
+   double maxPosition, sumPosition;
+   double maxNormal, sumNormal;
+
+   SampleErrors()
+      : count( 0 ), maxPosition( 0 ), sumPosition( 0 ),
+        maxNormal( 0 ), sumNormal( 0 ) { }
+
+   static double distance( const float * a, const float * b ) {
+      double x = a[0]-b[0], y = a[1]-b[1], z = a[2]-b[2];
+      return sqrt( x*x + y*y + z*z );
+   }
+   void add( SampleGrid & grid, SampleGrid & reference ) {
+      for ( int j = 0; j <= grid.rowCount; ++j )
+         for ( int k = 0; k <= grid.columnCount; ++k ) {
+            const GLPoint & p = grid.rows[j][k];
+            const GLPoint & q = reference.rows[j][k];
+            double dp = distance( p.vertex, q.vertex );
+            double dn = distance( p.normal, q.normal );
+            // NaNs count as infinitely wrong.
+            if ( dp != dp ) dp = HUGE_VAL;
+            if ( dn != dn ) dn = HUGE_VAL;
+            if ( dp > maxPosition ) maxPosition = dp;
+            if ( dn > maxNormal ) maxNormal = dn;
+            sumPosition += dp;
+            sumNormal += dn;
+            ++ count;
+         }
+   }
+};
+
+enum FastPath {
+   PATH_DEFAULT,
+   PATH_MATH_LIBRARY_TRIG,
+   PATH_STRIDED,
+   PATH_SPLIT,
+   PATH_TILED,
+   PATH_JETS,
+   PATH_POINT_EVALUATION,
+   PATH_UPSAMPLED,
+   PATH_PACKED,
+   NumPaths
+};
+static const char * const pathNames[NumPaths] = {
+   "generateGeometry",
+   "  without trig recurrence",
+   "  into a strided buffer",
+   "  into split streams",
+   "generateGeometryTiled",
+   "generateJetGeometry",
+   "evaluateSurface",
+   "generateGeometryUpsampled x4",
+   "generatePackedGeometry"
+};
+static const bool pathIsExact[NumPaths] = {
+   true, true, true, true, true, true, true, false, false
+};
+const int UpsamplingRefinement = 4;
+
+// A path, sampled with one of the kernels (see setGeometryKernel()).
+struct VerifiedPath {
+   FastPath path;
+   const char * kernel;
+   std::string name;
+   SampleErrors errors[NumStages];
+};
+
+// Generates the grid of the case with the given path.
+static void generate(
+   FastPath path, SampleGrid & grid,
+   double time, int numStrips,
+   double u_min, double u_max, double v_min, double v_max,
+   int tileRows, int tileColumns
+) {
+   int u_count = grid.rowCount, v_count = grid.columnCount;
+   switch ( path ) {
+      case PATH_DEFAULT :
+         generateGeometry( grid.matrix(), time, numStrips,
+            u_min, u_count, u_max, v_min, v_count, v_max );
+         break;
+      case PATH_MATH_LIBRARY_TRIG : {
+         int interval = getTrigonometricRecurrenceInterval();
+         setTrigonometricRecurrenceInterval( 1 );
+         generateGeometry( grid.matrix(), time, numStrips,
+            u_min, u_count, u_max, v_min, v_count, v_max );
+         setTrigonometricRecurrenceInterval( interval );
+         break;
+      }
+      case PATH_STRIDED : {
+         // Three samples of padding after each row, which must be skipped.
+         int rowStride = v_count + 4;
+         std::vector< GLPoint > samples( ( u_count+1 ) * rowStride );
+         generateGeometry( &samples[0], rowStride, time, numStrips,
+            u_min, u_count, u_max, v_min, v_count, v_max );
+         for ( int j = 0; j <= u_count; ++j )
+            for ( int k = 0; k <= v_count; ++k )
+               grid.rows[j][k] = samples[ j * rowStride + k ];
+         break;
+      }
+      case PATH_SPLIT : {
+         int samples = ( u_count+1 ) * ( v_count+1 );
+         std::vector< float > positions( 3*samples ), normals( 3*samples );
+         VertexStreams streams = { NULL, &positions[0], &normals[0], v_count+1 };
+         generateGeometry( streams, time, numStrips,
+            u_min, u_count, u_max, v_min, v_count, v_max );
+         for ( int j = 0; j <= u_count; ++j )
+            for ( int k = 0; k <= v_count; ++k )
+               for ( int i = 0; i < 3; ++i ) {
+                  int s = j * ( v_count+1 ) + k;
+                  grid.rows[j][k].vertex[i] = positions[3*s+i];
+                  grid.rows[j][k].normal[i] = normals[3*s+i];
+               }
+         break;
+      }
+      case PATH_TILED : {
+         GridAssembler assembler( grid );
+         generateGeometryTiled( &assembler, tileRows, tileColumns,
+            time, numStrips,
+            u_min, u_count, u_max, v_min, v_count, v_max );
+         break;
+      }
+      case PATH_JETS : {
+         std::vector< GLJetPoint > samples( ( u_count+1 ) * ( v_count+1 ) );
+         std::vector< GLJetPoint * > rows( u_count+1 );
+         for ( int j = 0; j <= u_count; ++j )
+            rows[j] = &samples[ j * ( v_count+1 ) ];
+         generateJetGeometry( NULL, &rows[0], time, numStrips,
+            u_min, u_count, u_max, v_min, v_count, v_max );
+         for ( int j = 0; j <= u_count; ++j )
+            for ( int k = 0; k <= v_count; ++k )
+               for ( int i = 0; i < 3; ++i ) {
+                  grid.rows[j][k].vertex[i] = rows[j][k].vertex[i];
+                  grid.rows[j][k].normal[i] = rows[j][k].normal[i];
+               }
+         break;
+      }
+      case PATH_POINT_EVALUATION : {
+         double delta_u = ( u_max - u_min ) / u_count;
+         double delta_v = ( v_max - v_min ) / v_count;
+         for ( int j = 0; j <= u_count; ++j )
+            for ( int k = 0; k <= v_count; ++k ) {
+               GLJetPoint jet;
+               evaluateSurface( &jet, u_min + j*delta_u, v_min + k*delta_v,
+                  time, numStrips );
+               for ( int i = 0; i < 3; ++i ) {
+                  grid.rows[j][k].vertex[i] = jet.vertex[i];
+                  grid.rows[j][k].normal[i] = jet.normal[i];
+               }
+            }
+         break;
+      }
+      case PATH_UPSAMPLED :
+         generateGeometryUpsampled( grid.matrix(), UpsamplingRefinement,
+            time, numStrips,
+            u_min, u_count / UpsamplingRefinement, u_max,
+            v_min, v_count / UpsamplingRefinement, v_max );
+         break;
+      case PATH_PACKED : {
+         PackedGrid packed;
+         generatePackedGeometry( &packed, 1, time, numStrips,
+            u_min, u_count, u_max, v_min, v_count, v_max );
+         VertexStreams streams = { &grid.samples[0], NULL, NULL, v_count+1 };
+         unpackGrid( packed, streams );
+         break;
+      }
+      default :
+         break;
+   }
+}
+
+bool verifyGeometry(
+   int cases,
+   unsigned seed,
+   double tolerance,
+   FILE * report
+) {
+   std::mt19937 random( seed );
+   std::uniform_real_distribution< double > uniform( 0.0, 1.0 );
+   // Every path with the default kernel, then generateGeometry()
+   // with each of the other kernels.
+   const char * defaultKernel = getGeometryKernel();
+   const char * kernels[8];
+   int numKernels = getGeometryKernels( kernels, 8 );
+   std::vector< VerifiedPath > paths;
+   for ( int p = 0; p < NumPaths; ++p ) {
+      VerifiedPath path;
+      path.path = (FastPath)p;
+      path.kernel = defaultKernel;
+      path.name = pathNames[p];
+      paths.push_back( path );
+   }
+   for ( int i = 0; i < numKernels; ++i )
+      if ( strcmp( kernels[i], defaultKernel ) != 0 ) {
+         VerifiedPath path;
+         path.path = PATH_DEFAULT;
+         path.kernel = kernels[i];
+         path.name = std::string( pathNames[PATH_DEFAULT] ) + ", " + kernels[i];
+         paths.push_back( path );
+      }
+
+   for ( int c = 0; c < cases; ++c ) {
+      int stage = c % NumStages;
+      double time = stageStarts[stage]
+         + uniform( random ) * ( stageStarts[stage+1] - stageStarts[stage] );
+      int numStrips = 2 + (int)( uniform( random ) * 15 );
+      // Half the cases cover the usual ranges, with the poles and seams.
+      double u_min = 0, u_max = 1, v_min = 0, v_max = 1;
+      if ( uniform( random ) < 0.5 ) {
+         u_min = 0.5 * uniform( random );
+         u_max = u_min + 0.1 + ( 2.0 - 0.1 - u_min ) * uniform( random );
+         v_min = 0.5 * uniform( random );
+         v_max = v_min + 0.1 + 0.9 * uniform( random );
+      }
+      int u_count = 1 + (int)( uniform( random ) * 48 );
+      int v_count = 1 + (int)( uniform( random ) * 48 );
+      int tileRows = 1 + (int)( uniform( random ) * 16 );
+      int tileColumns = 1 + (int)( uniform( random ) * 16 );
+
+      SampleGrid reference( u_count, v_count );
+      generateReferenceGeometry( reference.matrix(), time, numStrips,
+         u_min, u_count, u_max, v_min, v_count, v_max );
+      SampleGrid fineReference(
+         UpsamplingRefinement * u_count, UpsamplingRefinement * v_count
+      );
+      generateReferenceGeometry( fineReference.matrix(), time, numStrips,
+         u_min, fineReference.rowCount, u_max,
+         v_min, fineReference.columnCount, v_max );
+
+      for ( size_t p = 0; p < paths.size(); ++p ) {
+         SampleGrid & expected
+            = paths[p].path == PATH_UPSAMPLED ? fineReference : reference;
+         SampleGrid grid( expected.rowCount, expected.columnCount );
+         setGeometryKernel( paths[p].kernel );
+         generate( paths[p].path, grid, time, numStrips,
+            u_min, u_max, v_min, v_max, tileRows, tileColumns );
+         paths[p].errors[stage].add( grid, expected );
+      }
+      setGeometryKernel( defaultKernel );
+   }
+
+   bool passed = true;
+   fprintf( report, "%d cases (seed %u), tolerance %g, %s kernel\n",
+      cases, seed, tolerance, defaultKernel );
+   fprintf( report, "%-30s %-12s %10s %10s %10s %10s\n",
+      "path", "stage", "max |dp|", "mean |dp|", "max |dn|", "mean |dn|" );
+   for ( size_t p = 0; p < paths.size(); ++p )
+      for ( int s = 0; s < NumStages; ++s ) {
+         const SampleErrors & e = paths[p].errors[s];
+         bool isExact = pathIsExact[ paths[p].path ];
+         if ( e.count == 0 )
+            continue;
+         bool failed = isExact
+            && ( e.maxPosition > tolerance || e.maxNormal > tolerance );
+         if ( failed )
+            passed = false;
+         fprintf( report, "%-30s %-12s %10.3g %10.3g %10.3g %10.3g%s\n",
+            paths[p].name.c_str(), stageNames[s],
+            e.maxPosition, e.sumPosition / e.count,
+            e.maxNormal, e.sumNormal / e.count,
+            failed ? "  FAILED" : isExact ? "" : "  (approximate)" );
+      }
+   fprintf( report, passed ? "All exact paths agree with the reference\n"
+      : "Some paths differ from the reference\n" );
+   return passed;
+}
@@ -0,0 +1,29 @@
+
+#ifndef VERIFYGEOMETRY_H
+#define VERIFYGEOMETRY_H
+
+
+#include <stdio.h>
+
+
+// Differential test of the faster ways of generating the surface
+// (row/column factoring, trigonometric recurrences, tiling, jets,
+// single point evaluation, Hermite upsampling, and each of the kernels
+// supported by the CPU) against generateReferenceGeometry(), the original code.
+// Each of the given number of cases picks a random time, number of strips,
+// ranges of u and v, and numbers of samples, cycling through the stages
+// of the eversion, and compares the locations and normals of every sample.
+// A table of the maximum and mean distances, per path and per stage,
+// is printed to the report file.
+// Returns false if a path that is meant to reproduce the reference
+// differs from it by more than the tolerance anywhere; approximate paths
+// (Hermite upsampling) are reported, but not checked.
+bool verifyGeometry(
+   int cases,
+   unsigned seed,
+   double tolerance,
+   FILE * report
+);
+
+
+#endif /* VERIFYGEOMETRY_H */